@@ -529,6 +529,28 @@ START_NAMESPACE_DISTRHO
  */
 #define DISTRHO_PLUGIN_WANT_MIDI_OUTPUT 1
 
+/**
+   Wherever the plugin wrapper should pass all MIDI input through to the MIDI output by itself.@n
+   Input events are merged in time order with the ones the plugin writes, coming first on the same frame.
+   Requires both @ref DISTRHO_PLUGIN_WANT_MIDI_INPUT and @ref DISTRHO_PLUGIN_WANT_MIDI_OUTPUT.
+ */
+#define DISTRHO_PLUGIN_MIDI_THRU 1
+
+/**
+   Wherever the plugin wants parameter changes to be sample-accurate.@n
+   Host parameter changes that arrive as MIDI control changes (see Parameter::midiCC) are applied at their frame,
+   and run() is split there so each part sees the value that was valid for it.@n
+   Changes closer than @ref DISTRHO_PLUGIN_MIN_PARAMETER_SPLIT frames to the previous split are merged into it.@n
+   Requires @ref DISTRHO_PLUGIN_WANT_MIDI_INPUT.
+ */
+#define DISTRHO_PLUGIN_WANT_SAMPLE_ACCURATE_PARAMETERS 1
+
+/**
+   Smallest part, in frames, that run() is split into for sample-accurate parameter changes.@n
+   Defaults to 32, must be at least 1. Only used with @ref DISTRHO_PLUGIN_WANT_SAMPLE_ACCURATE_PARAMETERS.
+ */
+#define DISTRHO_PLUGIN_MIN_PARAMETER_SPLIT 32
+
 /**
    Wherever the plugin provides its own internal programs.
    @see Plugin::initProgramName(uint32_t, String&)
@@ -543,6 +565,15 @@ START_NAMESPACE_DISTRHO
  */
 #define DISTRHO_PLUGIN_WANT_STATE 1
 
+/**
+   Wherever some of the plugin states hold binary data instead of strings.@n
+   Requires @ref DISTRHO_PLUGIN_WANT_STATE.
+   @see Plugin::initStateHints(uint32_t, uint32_t&)
+   @see Plugin::getBinaryState(const char*, const void*&, size_t&) const
+   @see Plugin::setBinaryState(const char*, const void*, size_t)
+ */
+#define DISTRHO_PLUGIN_WANT_BINARY_STATE 1
+
 /**
    Wherever the plugin wants time position information from the host.
    @see Plugin::getTimePosition()
@@ -100,6 +100,28 @@ static const uint32_t kParameterIsTrigger = 0x20 | kParameterIsBoolean;
 
 /** @} */
 
+/* ------------------------------------------------------------------------------------------------------------
+ * State Hints */
+
+/**
+   @defgroup StateHints State Hints
+
+   Various state hints.
+   @see Plugin::initStateHints(uint32_t, uint32_t&)
+   @{
+ */
+
+/**
+   State value is binary data instead of a string.@n
+   Binary states are saved and restored through Plugin::getBinaryState() and Plugin::setBinaryState(),
+   they are never passed to Plugin::setState() nor sent to the %UI.
+
+   @note Only available if DISTRHO_PLUGIN_WANT_BINARY_STATE is enabled.
+ */
+static const uint32_t kStateIsBinary = 0x01;
+
+/** @} */
+
 /* ------------------------------------------------------------------------------------------------------------
  * Base Plugin structs */
 
@@ -634,6 +656,9 @@ struct TimePosition {
    DISTRHO_PLUGIN_WANT_STATE activates internal state features.@n
    When enabled you need to implement initStateKey() and setState().
 
+   DISTRHO_PLUGIN_WANT_BINARY_STATE allows states to hold binary data.@n
+   When enabled you need to implement initStateHints(), getBinaryState() and setBinaryState().
+
    The process function run() changes wherever DISTRHO_PLUGIN_WANT_MIDI_INPUT is enabled or not.@n
    When enabled it provides midi input events.
  */
@@ -696,6 +721,22 @@ public:
       Returns false when the host buffer is full, in which case do not call this again until the next run().
     */
     bool writeMidiEvent(const MidiEvent& midiEvent) noexcept;
+
+   /**
+      Reserve a MIDI output event of @a size bytes at @a frame and return where to write its data.@n
+      The data is written straight into the host buffer, without a copy or a callback per byte.@n
+      This function must only be called during run(), with frames in time order.@n
+      Returns null when the host buffer is full or the plugin format cannot do this,
+      use writeMidiEvent() in that case.
+    */
+    uint8_t* reserveMidiEvent(uint32_t frame, uint32_t size) noexcept;
+
+   /**
+      Write several MIDI output events at once, in time order.@n
+      This function must only be called during run().@n
+      Returns how many events were written, less than @a count when the host buffer is full.
+    */
+    uint32_t writeMidiEvents(const MidiEvent* midiEvents, uint32_t count) noexcept;
 #endif
 
 protected:
@@ -783,6 +824,15 @@ protected:
     virtual void initState(uint32_t index, String& stateKey, String& defaultStateValue) = 0;
 #endif
 
+#if DISTRHO_PLUGIN_WANT_BINARY_STATE
+   /**
+      Set the hints of state @a index, called right after initState().@n
+      @a hints starts at 0x0, set @ref kStateIsBinary for states holding binary data.@n
+      Must be implemented by your plugin class only if DISTRHO_PLUGIN_WANT_BINARY_STATE is enabled.
+    */
+    virtual void initStateHints(uint32_t index, uint32_t& hints) = 0;
+#endif
+
    /* --------------------------------------------------------------------------------------------------------
     * Internal data */
 
@@ -827,6 +877,25 @@ protected:
     virtual void setState(const char* key, const char* value) = 0;
 #endif
 
+#if DISTRHO_PLUGIN_WANT_BINARY_STATE
+   /**
+      Get the data of a binary state.@n
+      The host may call this function from any non-realtime context.@n
+      @a data must stay valid and unchanged until getBinaryState() is called again for the same @a key,
+      or until setBinaryState() is called.@n
+      Must be implemented by your plugin class only if DISTRHO_PLUGIN_WANT_BINARY_STATE is enabled.
+    */
+    virtual void getBinaryState(const char* key, const void*& data, size_t& size) const = 0;
+
+   /**
+      Change a binary state @a key to @a size bytes of @a data.@n
+      @a data is only valid during this call and has no particular alignment, copy what you need to keep.@n
+      An empty state is passed as a null @a data with a @a size of 0.@n
+      Must be implemented by your plugin class only if DISTRHO_PLUGIN_WANT_BINARY_STATE is enabled.
+    */
+    virtual void setBinaryState(const char* key, const void* data, size_t size) = 0;
+#endif
+
    /* --------------------------------------------------------------------------------------------------------
     * Audio/MIDI Processing */
 
@@ -97,6 +97,13 @@ public:
     */
     void setParameterValue(uint32_t index, float value);
 
+   /**
+      Ask the host to map the next MIDI control change it receives to input parameter @a index (MIDI learn).@n
+      Pass -1 to cancel a pending request. The mapping replaces any previous one of the parameter.
+      @note Only implemented for the JACK standalone, other hosts have their own MIDI learn.
+    */
+    void requestParameterMidiLearn(int32_t index);
+
 #if DISTRHO_PLUGIN_WANT_STATE
    /**
       setState.
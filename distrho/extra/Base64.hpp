@@ -17,11 +17,14 @@
 #ifndef DISTRHO_BASE64_HPP_INCLUDED
 #define DISTRHO_BASE64_HPP_INCLUDED
 
-#include "../DistrhoUtils.hpp"
+#include "String.hpp"
 
-#include <cctype>
 #include <vector>
 
+#ifdef __SSSE3__
+# include <tmmintrin.h>
+#endif
+
 // -----------------------------------------------------------------------
 // base64 stuff, based on http://www.adp-gmbh.ch/cpp/common/base64.html
 
@@ -60,46 +63,157 @@ static const char* const kBase64Chars =
     "abcdefghijklmnopqrstuvwxyz"
     "0123456789+/";
 
+static const uint8_t kInv = 0xff;
+
+// index of each base64 character, kInv for everything else
+static const uint8_t kBase64DecodeTable[256] = {
+    kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv,
+    kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv,
+    kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv,   62, kInv, kInv, kInv,   63,
+      52,   53,   54,   55,   56,   57,   58,   59,   60,   61, kInv, kInv, kInv, kInv, kInv, kInv,
+    kInv,    0,    1,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,   12,   13,   14,
+      15,   16,   17,   18,   19,   20,   21,   22,   23,   24,   25, kInv, kInv, kInv, kInv, kInv,
+    kInv,   26,   27,   28,   29,   30,   31,   32,   33,   34,   35,   36,   37,   38,   39,   40,
+      41,   42,   43,   44,   45,   46,   47,   48,   49,   50,   51, kInv, kInv, kInv, kInv, kInv,
+    kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv,
+    kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv,
+    kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv,
+    kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv,
+    kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv,
+    kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv,
+    kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv,
+    kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv, kInv
+};
+
 static inline
-uint8_t findBase64CharIndex(const char c)
+bool isBase64Char(const char c)
 {
-    static const uint8_t kBase64CharsLen(static_cast<uint8_t>(std::strlen(kBase64Chars)));
+    return kBase64DecodeTable[static_cast<uint8_t>(c)] != kInv;
+}
 
-    for (uint8_t i=0; i<kBase64CharsLen; ++i)
-    {
-        if (kBase64Chars[i] == c)
-            return i;
-    }
+#ifdef __SSSE3__
+// SIMD codec from Wojciech Muła and Daniel Lemire, "Faster Base64 Encoding and Decoding Using AVX2 Instructions".
+// Each call handles a full block, reading 16 bytes in both directions.
 
-    d_stderr2("findBase64CharIndex('%c') - failed", c);
-    return 0;
+// 12 bytes from the first 16 of @a src into 16 characters
+static inline
+void encodeBase64BlockSSSE3(const uint8_t* const src, char* const dst)
+{
+    __m128i in = _mm_loadu_si128((const __m128i*)src);
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+    // split each 3 bytes into four 6-bit indexes, one per byte
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    const __m128i indexes = _mm_or_si128(t1, t3);
+
+    // offset from index to ascii, picked per index range
+    __m128i ranges = _mm_subs_epu8(indexes, _mm_set1_epi8(51));
+    const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indexes);
+    ranges = _mm_or_si128(ranges, _mm_and_si128(less, _mm_set1_epi8(13)));
+
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+    _mm_storeu_si128((__m128i*)dst, _mm_add_epi8(indexes, _mm_shuffle_epi8(offsets, ranges)));
 }
 
+// 16 characters from @a src into 12 bytes, writing 16 bytes to @a dst.
+// Returns false without writing anything if the block has characters other than base64 ones.
 static inline
-bool isBase64Char(const char c)
+bool decodeBase64BlockSSSE3(const char* const src, uint8_t* const dst)
 {
-    return (std::isalnum(c) || (c == '+') || (c == '/'));
+    const __m128i in = _mm_loadu_si128((const __m128i*)src);
+    const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+    const __m128i loNibbles = _mm_and_si128(in, _mm_set1_epi8(0x0f));
+
+    const __m128i loTable = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                          0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i hiTable = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                          0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lo = _mm_shuffle_epi8(loTable, loNibbles);
+    const __m128i hi = _mm_shuffle_epi8(hiTable, hiNibbles);
+
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0)
+        return false;
+
+    // ascii to index, '/' shares its high nibble with '+' and needs its own offset
+    const __m128i rollTable = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i eq2F = _mm_cmpeq_epi8(in, _mm_set1_epi8(0x2f));
+    const __m128i values = _mm_add_epi8(in, _mm_shuffle_epi8(rollTable, _mm_add_epi8(eq2F, hiNibbles)));
+
+    // pack four 6-bit values into 3 bytes
+    const __m128i mergedPairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    const __m128i merged = _mm_madd_epi16(mergedPairs, _mm_set1_epi32(0x00011000));
+    const __m128i out = _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+    _mm_storeu_si128((__m128i*)dst, out);
+    return true;
 }
+#endif
 
 } // namespace DistrhoBase64Helpers
 #endif
 
 // -----------------------------------------------------------------------
 
+/**
+   Decode a base64 string of @a base64stringLength characters.@n
+   Spaces and newlines are skipped, decoding stops at the first '=' or null character.
+ */
 static inline
-std::vector<uint8_t> d_getChunkFromBase64String(const char* const base64string)
+std::vector<uint8_t> d_getChunkFromBase64String(const char* const base64string, const std::size_t base64stringLength)
 {
     DISTRHO_SAFE_ASSERT_RETURN(base64string != nullptr, std::vector<uint8_t>());
 
-    uint i=0, j=0;
-    uint charArray3[3], charArray4[4];
+    using DistrhoBase64Helpers::kBase64DecodeTable;
 
-    std::vector<uint8_t> ret;
-    ret.reserve(std::strlen(base64string)*3/4 + 4);
+    // every 4 characters give at most 3 bytes, plus room for the 16 byte SIMD stores
+    std::vector<uint8_t> ret(base64stringLength/4*3 + 16);
 
-    for (std::size_t l=0, len=std::strlen(base64string); l<len; ++l)
+    const uint8_t* const src = (const uint8_t*)base64string;
+    uint8_t* const dst = ret.data();
+
+    std::size_t l = 0, o = 0;
+    uint i = 0, charArray4[4];
+
+    for (;;)
     {
-        const char c = base64string[l];
+        if (i == 0)
+        {
+#ifdef __SSSE3__
+            while (base64stringLength - l >= 16 && DistrhoBase64Helpers::decodeBase64BlockSSSE3((const char*)src + l, dst + o))
+            {
+                l += 16;
+                o += 12;
+            }
+#endif
+            // whole groups of 4 base64 characters
+            while (base64stringLength - l >= 4)
+            {
+                const uint a = kBase64DecodeTable[src[l]];
+                const uint b = kBase64DecodeTable[src[l+1]];
+                const uint c = kBase64DecodeTable[src[l+2]];
+                const uint d = kBase64DecodeTable[src[l+3]];
+
+                // kInv has the top bits set, valid indexes never do
+                if (((a | b | c | d) & 0xc0) != 0)
+                    break;
+
+                dst[o++] = static_cast<uint8_t>((a << 2) | (b >> 4));
+                dst[o++] = static_cast<uint8_t>((b << 4) | (c >> 2));
+                dst[o++] = static_cast<uint8_t>((c << 6) | d);
+                l += 4;
+            }
+        }
+
+        if (l == base64stringLength)
+            break;
+
+        // one character at a time until the next group boundary
+        const char c = base64string[l++];
 
         if (c == '\0' || c == '=')
             break;
@@ -108,43 +222,112 @@ std::vector<uint8_t> d_getChunkFromBase64String(const char* const base64string)
 
         DISTRHO_SAFE_ASSERT_CONTINUE(DistrhoBase64Helpers::isBase64Char(c));
 
-        charArray4[i++] = static_cast<uint>(c);
+        charArray4[i++] = kBase64DecodeTable[static_cast<uint8_t>(c)];
 
         if (i == 4)
         {
-            for (i=0; i<4; ++i)
-                charArray4[i] = DistrhoBase64Helpers::findBase64CharIndex(static_cast<char>(charArray4[i]));
-
-            charArray3[0] =  (charArray4[0] << 2)        + ((charArray4[1] & 0x30) >> 4);
-            charArray3[1] = ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
-            charArray3[2] = ((charArray4[2] & 0x3) << 6) +   charArray4[3];
-
-            for (i=0; i<3; ++i)
-                ret.push_back(static_cast<uint8_t>(charArray3[i]));
-
+            dst[o++] = static_cast<uint8_t>((charArray4[0] << 2) | (charArray4[1] >> 4));
+            dst[o++] = static_cast<uint8_t>((charArray4[1] << 4) | (charArray4[2] >> 2));
+            dst[o++] = static_cast<uint8_t>((charArray4[2] << 6) |  charArray4[3]);
             i = 0;
         }
     }
 
     if (i != 0)
     {
-        for (j=0; j<i && j<4; ++j)
-            charArray4[j] = DistrhoBase64Helpers::findBase64CharIndex(static_cast<char>(charArray4[j]));
-
-        for (j=i; j<4; ++j)
+        for (uint j=i; j<4; ++j)
             charArray4[j] = 0;
 
-        charArray3[0] =  (charArray4[0] << 2)        + ((charArray4[1] & 0x30) >> 4);
-        charArray3[1] = ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
-        charArray3[2] = ((charArray4[2] & 0x3) << 6) +   charArray4[3];
+        const uint8_t charArray3[3] = {
+            static_cast<uint8_t>((charArray4[0] << 2) | (charArray4[1] >> 4)),
+            static_cast<uint8_t>((charArray4[1] << 4) | (charArray4[2] >> 2)),
+            static_cast<uint8_t>((charArray4[2] << 6) |  charArray4[3])
+        };
 
-        for (j=0; i>0 && j<i-1; j++)
-            ret.push_back(static_cast<uint8_t>(charArray3[j]));
+        for (uint j=0; j<i-1; ++j)
+            dst[o++] = charArray3[j];
     }
 
+    ret.resize(o);
     return ret;
 }
 
+/**
+   Decode a null-terminated base64 string.
+   @see d_getChunkFromBase64String(const char*, std::size_t)
+ */
+static inline
+std::vector<uint8_t> d_getChunkFromBase64String(const char* const base64string)
+{
+    DISTRHO_SAFE_ASSERT_RETURN(base64string != nullptr, std::vector<uint8_t>());
+
+    return d_getChunkFromBase64String(base64string, std::strlen(base64string));
+}
+
+/**
+   Encode @a dataSize bytes of @a data as a base64 string, padded with '='.
+ */
+static inline
+String d_getBase64StringFromChunk(const void* const data, const std::size_t dataSize)
+{
+    DISTRHO_SAFE_ASSERT_RETURN(data != nullptr || dataSize == 0, String());
+
+    if (dataSize == 0)
+        return String();
+
+    using DistrhoBase64Helpers::kBase64Chars;
+
+    const std::size_t strSize = (dataSize + 2) / 3 * 4;
+
+    char* const strBuf = (char*)std::malloc(strSize + 1);
+    DISTRHO_SAFE_ASSERT_RETURN(strBuf != nullptr, String());
+
+    const uint8_t* const src = (const uint8_t*)data;
+    std::size_t s = 0, o = 0;
+
+#ifdef __SSSE3__
+    for (; dataSize - s >= 16; s += 12, o += 16)
+        DistrhoBase64Helpers::encodeBase64BlockSSSE3(src + s, strBuf + o);
+#endif
+
+    for (; dataSize - s >= 3; s += 3)
+    {
+        const uint value = (static_cast<uint>(src[s]) << 16) | (static_cast<uint>(src[s+1]) << 8) | src[s+2];
+
+        strBuf[o++] = kBase64Chars[(value >> 18) & 0x3f];
+        strBuf[o++] = kBase64Chars[(value >> 12) & 0x3f];
+        strBuf[o++] = kBase64Chars[(value >>  6) & 0x3f];
+        strBuf[o++] = kBase64Chars[value & 0x3f];
+    }
+
+    if (const std::size_t remaining = dataSize - s)
+    {
+        const uint value = (static_cast<uint>(src[s]) << 16) | (remaining == 2 ? static_cast<uint>(src[s+1]) << 8 : 0);
+
+        strBuf[o++] = kBase64Chars[(value >> 18) & 0x3f];
+        strBuf[o++] = kBase64Chars[(value >> 12) & 0x3f];
+        strBuf[o++] = remaining == 2 ? kBase64Chars[(value >> 6) & 0x3f] : '=';
+        strBuf[o++] = '=';
+    }
+
+    strBuf[o] = '\0';
+
+    // String takes ownership of the buffer
+    return String(strBuf, false);
+}
+
+// -----------------------------------------------------------------------
+
+START_NAMESPACE_DISTRHO
+
+inline
+String String::asBase64(const void* const data, const std::size_t dataSize)
+{
+    return d_getBase64StringFromChunk(data, dataSize);
+}
+
+END_NAMESPACE_DISTRHO
+
 // -----------------------------------------------------------------------
 
 #endif // DISTRHO_BASE64_HPP_INCLUDED
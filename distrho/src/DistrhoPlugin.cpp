@@ -64,6 +64,10 @@ Plugin::Plugin(uint32_t parameterCount, uint32_t programCount, uint32_t stateCou
         pData->stateCount     = stateCount;
         pData->stateKeys      = new String[stateCount];
         pData->stateDefValues = new String[stateCount];
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+        pData->stateHints     = new uint32_t[stateCount];
+        std::memset(pData->stateHints, 0, sizeof(uint32_t)*stateCount);
+# endif
     }
 #else
     DISTRHO_SAFE_ASSERT(stateCount == 0);
@@ -107,6 +111,16 @@ bool Plugin::writeMidiEvent(const MidiEvent& midiEvent) noexcept
 {
     return pData->writeMidiCallback(midiEvent);
 }
+
+uint8_t* Plugin::reserveMidiEvent(const uint32_t frame, const uint32_t size) noexcept
+{
+    return pData->reserveMidiCallback(frame, size);
+}
+
+uint32_t Plugin::writeMidiEvents(const MidiEvent* const midiEvents, const uint32_t count) noexcept
+{
+    return pData->writeMidiEventsCallback(midiEvents, count);
+}
 #endif
 
 /* ------------------------------------------------------------------------------------------------------------
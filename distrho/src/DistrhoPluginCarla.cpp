@@ -187,6 +187,11 @@ public:
           fPlugin(this, writeMidiCallback),
           fScalePointsCache(nullptr)
     {
+#if DISTRHO_PLUGIN_MIDI_THRU
+        fMidiThruEvents = nullptr;
+        fMidiThruCount  = 0;
+        fMidiThruIndex  = 0;
+#endif
 #if DISTRHO_PLUGIN_HAS_UI
         fUiPtr = nullptr;
 #endif
@@ -362,26 +367,41 @@ protected:
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
     void process(float** const inBuffer, float** const outBuffer, const uint32_t frames, const NativeMidiEvent* const midiEvents, const uint32_t midiEventCount) override
     {
-        MidiEvent realMidiEvents[midiEventCount];
+#if DISTRHO_PLUGIN_MIDI_THRU
+        // input is merged with the plugin output by frame in writeMidiCallback
+        fMidiThruEvents = midiEvents;
+        fMidiThruCount  = midiEventCount;
+        fMidiThruIndex  = 0;
+#endif
+
+        // the plugin may already run while events are added, when the staging area fills up
+        fPlugin.beginRun(const_cast<const float**>(inBuffer), outBuffer, frames);
 
         for (uint32_t i=0; i < midiEventCount; ++i)
         {
             const NativeMidiEvent& midiEvent(midiEvents[i]);
-            MidiEvent& realMidiEvent(realMidiEvents[i]);
+            MidiEvent realMidiEvent;
 
             realMidiEvent.frame = midiEvent.time;
             realMidiEvent.size  = midiEvent.size;
 
             uint8_t j=0;
-            for (; j<midiEvent.size; ++j)
-                realMidiEvent.data[j] = midiEvent.data[j];
-            for (; j<midiEvent.size; ++j)
+            for (; j<midiEvent.size && j<MidiEvent::kDataSize; ++j)
                 realMidiEvent.data[j] = midiEvent.data[j];
+            for (; j<MidiEvent::kDataSize; ++j)
+                realMidiEvent.data[j] = 0;
 
             realMidiEvent.dataExt = nullptr;
+
+            fPlugin.addMidiEvent(realMidiEvent);
         }
 
-        fPlugin.run(const_cast<const float**>(inBuffer), outBuffer, frames, realMidiEvents, midiEventCount);
+        fPlugin.endRun();
+
+#if DISTRHO_PLUGIN_MIDI_THRU
+        flushMidiThru(UINT32_MAX);
+        fMidiThruEvents = nullptr;
+#endif
     }
 #else
     void process(float** const inBuffer, float** const outBuffer, const uint32_t frames, const NativeMidiEvent* const, const uint32_t) override
@@ -484,6 +504,12 @@ private:
     PluginExporter fPlugin;
     mutable NativeParameterScalePoint* fScalePointsCache;
 
+#if DISTRHO_PLUGIN_MIDI_THRU
+    const NativeMidiEvent* fMidiThruEvents;
+    uint32_t fMidiThruCount;
+    uint32_t fMidiThruIndex;
+#endif
+
 #if DISTRHO_PLUGIN_HAS_UI
     // UI
     UICarla* fUiPtr;
@@ -499,16 +525,45 @@ private:
 #endif
 
 #if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
-    static bool writeMidiCallback(void* ptr, const MidiEvent& midiEvent)
+# if DISTRHO_PLUGIN_MIDI_THRU
+    // Forward MIDI input events up to and including @a frame.
+    void flushMidiThru(const uint32_t frame)
+    {
+        for (; fMidiThruIndex < fMidiThruCount; ++fMidiThruIndex)
+        {
+            const NativeMidiEvent& midiEvent(fMidiThruEvents[fMidiThruIndex]);
+
+            if (midiEvent.time > frame)
+                break;
+
+            writeMidiEvent(&midiEvent);
+        }
+    }
+# endif
+
+    bool writeMidi(const MidiEvent& midiEvent)
     {
         if (midiEvent.size > 4)
-            return;
+            return false;
+
+# if DISTRHO_PLUGIN_MIDI_THRU
+        flushMidiThru(midiEvent.frame);
+# endif
+
+        NativeMidiEvent event;
+        event.time = midiEvent.frame;
+        event.port = 0;
+        event.size = midiEvent.size;
+
+        for (uint8_t i=0; i<4; ++i)
+            event.data[i] = i < midiEvent.size ? midiEvent.data[i] : 0;
 
-        const NativeMidiEvent event = {
-            midiEvent.frame, 0, midiEvent.size, midiEvent.data
-        };
+        return writeMidiEvent(&event);
+    }
 
-        return ((PluginCarla*)ptr)->fPlugin.writeMidiEvent(midiEvent);
+    static bool writeMidiCallback(void* ptr, const MidiEvent& midiEvent)
+    {
+        return ((PluginCarla*)ptr)->writeMidi(midiEvent);
     }
 #endif
 
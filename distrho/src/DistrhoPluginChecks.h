@@ -69,6 +69,18 @@
 # define DISTRHO_PLUGIN_WANT_MIDI_OUTPUT 0
 #endif
 
+#ifndef DISTRHO_PLUGIN_MIDI_THRU
+# define DISTRHO_PLUGIN_MIDI_THRU 0
+#endif
+
+#ifndef DISTRHO_PLUGIN_WANT_SAMPLE_ACCURATE_PARAMETERS
+# define DISTRHO_PLUGIN_WANT_SAMPLE_ACCURATE_PARAMETERS 0
+#endif
+
+#ifndef DISTRHO_PLUGIN_MIN_PARAMETER_SPLIT
+# define DISTRHO_PLUGIN_MIN_PARAMETER_SPLIT 32
+#endif
+
 #ifndef DISTRHO_PLUGIN_WANT_PROGRAMS
 # define DISTRHO_PLUGIN_WANT_PROGRAMS 0
 #endif
@@ -81,6 +93,10 @@
 # define DISTRHO_PLUGIN_WANT_FULL_STATE 0
 #endif
 
+#ifndef DISTRHO_PLUGIN_WANT_BINARY_STATE
+# define DISTRHO_PLUGIN_WANT_BINARY_STATE 0
+#endif
+
 #ifndef DISTRHO_PLUGIN_WANT_TIMEPOS
 # define DISTRHO_PLUGIN_WANT_TIMEPOS 0
 #endif
@@ -123,6 +139,34 @@
 # error Synths need MIDI input to work!
 #endif
 
+// -----------------------------------------------------------------------
+// Test if MIDI thru has both MIDI input and output
+
+#if DISTRHO_PLUGIN_MIDI_THRU && ! (DISTRHO_PLUGIN_WANT_MIDI_INPUT && DISTRHO_PLUGIN_WANT_MIDI_OUTPUT)
+# error MIDI thru needs both MIDI input and output!
+#endif
+
+// -----------------------------------------------------------------------
+// Test if sample-accurate parameters have MIDI input
+
+#if DISTRHO_PLUGIN_WANT_SAMPLE_ACCURATE_PARAMETERS && ! DISTRHO_PLUGIN_WANT_MIDI_INPUT
+# error Sample-accurate parameters need MIDI input!
+#endif
+
+// -----------------------------------------------------------------------
+// Test if the minimum parameter split is at least one frame
+
+#if DISTRHO_PLUGIN_MIN_PARAMETER_SPLIT < 1
+# error DISTRHO_PLUGIN_MIN_PARAMETER_SPLIT must be at least 1!
+#endif
+
+// -----------------------------------------------------------------------
+// Test if binary state has state
+
+#if DISTRHO_PLUGIN_WANT_BINARY_STATE && ! DISTRHO_PLUGIN_WANT_STATE
+# error Binary state needs state!
+#endif
+
 // -----------------------------------------------------------------------
 // Enable full state if plugin exports presets
 
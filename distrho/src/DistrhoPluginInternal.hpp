@@ -35,7 +35,9 @@ extern double   d_lastSampleRate;
 // -----------------------------------------------------------------------
 // DSP callbacks
 
-typedef bool (*writeMidiFunc) (void* ptr, const MidiEvent& midiEvent);
+typedef bool     (*writeMidiFunc)       (void* ptr, const MidiEvent& midiEvent);
+typedef uint8_t* (*reserveMidiFunc)     (void* ptr, uint32_t frame, uint32_t size);
+typedef uint32_t (*writeMidiEventsFunc) (void* ptr, const MidiEvent* midiEvents, uint32_t count, uint32_t frameOffset);
 
 // -----------------------------------------------------------------------
 // Plugin private data
@@ -60,6 +62,9 @@ struct Plugin::PrivateData {
     uint32_t stateCount;
     String*  stateKeys;
     String*  stateDefValues;
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+    uint32_t* stateHints;
+# endif
 #endif
 
 #if DISTRHO_PLUGIN_WANT_LATENCY
@@ -71,8 +76,15 @@ struct Plugin::PrivateData {
 #endif
 
     // Callbacks
-    void*         callbacksPtr;
-    writeMidiFunc writeMidiCallbackFunc;
+    void*               callbacksPtr;
+    writeMidiFunc       writeMidiCallbackFunc;
+    reserveMidiFunc     reserveMidiCallbackFunc;
+    writeMidiEventsFunc writeMidiEventsCallbackFunc;
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT && DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+    // Start of the current run within the host block, see PluginExporter::addMidiEvent()
+    uint32_t runFrameOffset;
+#endif
 
     uint32_t bufferSize;
     double   sampleRate;
@@ -93,12 +105,20 @@ struct Plugin::PrivateData {
           stateCount(0),
           stateKeys(nullptr),
           stateDefValues(nullptr),
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+          stateHints(nullptr),
+# endif
 #endif
 #if DISTRHO_PLUGIN_WANT_LATENCY
           latency(0),
 #endif
           callbacksPtr(nullptr),
           writeMidiCallbackFunc(nullptr),
+          reserveMidiCallbackFunc(nullptr),
+          writeMidiEventsCallbackFunc(nullptr),
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT && DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+          runFrameOffset(0),
+#endif
           bufferSize(d_lastBufferSize),
           sampleRate(d_lastSampleRate)
     {
@@ -158,16 +178,67 @@ struct Plugin::PrivateData {
             delete[] stateDefValues;
             stateDefValues = nullptr;
         }
+
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+        if (stateHints != nullptr)
+        {
+            delete[] stateHints;
+            stateHints = nullptr;
+        }
+# endif
 #endif
     }
 
 #if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
     bool writeMidiCallback(const MidiEvent& midiEvent)
     {
-        if (writeMidiCallbackFunc != nullptr)
-            return writeMidiCallbackFunc(callbacksPtr, midiEvent);
+        if (writeMidiCallbackFunc == nullptr)
+            return false;
 
-        return false;
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        // the plugin sees frames relative to its run, the host expects them relative to its block
+        if (runFrameOffset != 0)
+        {
+            MidiEvent offsetEvent(midiEvent);
+            offsetEvent.frame += runFrameOffset;
+            return writeMidiCallbackFunc(callbacksPtr, offsetEvent);
+        }
+# endif
+
+        return writeMidiCallbackFunc(callbacksPtr, midiEvent);
+    }
+
+    uint8_t* reserveMidiCallback(const uint32_t frame, const uint32_t size)
+    {
+        if (reserveMidiCallbackFunc == nullptr)
+            return nullptr;
+
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        return reserveMidiCallbackFunc(callbacksPtr, frame + runFrameOffset, size);
+# else
+        return reserveMidiCallbackFunc(callbacksPtr, frame, size);
+# endif
+    }
+
+    uint32_t writeMidiEventsCallback(const MidiEvent* const midiEvents, const uint32_t count)
+    {
+        if (writeMidiEventsCallbackFunc != nullptr)
+        {
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+            return writeMidiEventsCallbackFunc(callbacksPtr, midiEvents, count, runFrameOffset);
+# else
+            return writeMidiEventsCallbackFunc(callbacksPtr, midiEvents, count, 0);
+# endif
+        }
+
+        // the host only takes one event at a time
+        for (uint32_t i=0; i < count; ++i)
+        {
+            if (! writeMidiCallback(midiEvents[i]))
+                return i;
+        }
+
+        return count;
     }
 #endif
 };
@@ -178,11 +249,47 @@ struct Plugin::PrivateData {
 class PluginExporter
 {
 public:
-    PluginExporter(void* const callbacksPtr, const writeMidiFunc writeMidiCall)
+    PluginExporter(void* const callbacksPtr, const writeMidiFunc writeMidiCall,
+                   const reserveMidiFunc reserveMidiCall = nullptr,
+                   const writeMidiEventsFunc writeMidiEventsCall = nullptr)
         : fPlugin(createPlugin()),
           fData((fPlugin != nullptr) ? fPlugin->pData : nullptr),
-          fIsActive(false)
+          fIsActive(false),
+          fParameterIndexes(nullptr),
+          fParameterRangeValues(nullptr),
+          fInputParameterCount(0),
+          fOutputParameterCount(0),
+          fTriggerParameterCount(0),
+          fBypassParameterIndex(-1),
+          fMidiCCTables(new int32_t[kMidiCCTableSize*2]),
+          fMidiCCTable(fMidiCCTables),
+          fMidiCCSwapRunCount(UINT32_MAX),
+          fRunCount(0),
+          fOutputValueBits(nullptr),
+          fDirtyOutputs(nullptr),
+          fDirtyOutputWords(0),
+          fOutputSequence(0)
+#if DISTRHO_PLUGIN_WANT_STATE
+        , fStateKeyHashes(nullptr)
+#endif
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        , fMidiEvents(new MidiEvent[kMaxMidiEvents]),
+          fMidiEventCapacity(kMaxMidiEvents),
+          fMidiEventCount(0),
+          fMidiEventOverflowCount(0),
+          fMidiEventDropCount(0),
+          fRunInputs(nullptr),
+          fRunOutputs(nullptr),
+          fRunFrames(0),
+          fRunOffset(0)
+# if DISTRHO_PLUGIN_WANT_SAMPLE_ACCURATE_PARAMETERS
+        , fParameterSplitCount(0)
+# endif
+#endif
     {
+        for (uint32_t i=0; i < kMidiCCTableSize*2; ++i)
+            fMidiCCTables[i] = -1;
+
         DISTRHO_SAFE_ASSERT_RETURN(fPlugin != nullptr,);
         DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr,);
 
@@ -203,23 +310,69 @@ public:
         for (uint32_t i=0, count=fData->parameterCount; i < count; ++i)
             fPlugin->initParameter(i, fData->parameters[i]);
 
+        if (const uint32_t count = fData->parameterCount)
+        {
+            initParameterTables(count);
+
+            fOutputValueBits  = new uint32_t[count];
+            fDirtyOutputWords = (count + 31) / 32;
+            fDirtyOutputs     = new uint32_t[fDirtyOutputWords];
+            std::memset(fDirtyOutputs, 0, sizeof(uint32_t)*fDirtyOutputWords);
+
+            // start with every output dirty, so the first readers get the initial values
+            for (uint32_t i=0; i < count; ++i)
+                fOutputValueBits[i] = getFloatBits(fPlugin->getParameterValue(i));
+
+            for (uint32_t j=0; j < fOutputParameterCount; ++j)
+            {
+                const uint32_t i = getOutputParameterIndexes()[j];
+                fDirtyOutputs[i/32] |= 1U << (i%32);
+            }
+
+            fOutputSequence = 1;
+        }
+
 #if DISTRHO_PLUGIN_WANT_PROGRAMS
         for (uint32_t i=0, count=fData->programCount; i < count; ++i)
             fPlugin->initProgramName(i, fData->programNames[i]);
 #endif
 
 #if DISTRHO_PLUGIN_WANT_STATE
-        for (uint32_t i=0, count=fData->stateCount; i < count; ++i)
-            fPlugin->initState(i, fData->stateKeys[i], fData->stateDefValues[i]);
+        if (const uint32_t count = fData->stateCount)
+        {
+            fStateKeyHashes = new uint32_t[count];
+
+            for (uint32_t i=0; i < count; ++i)
+            {
+                fPlugin->initState(i, fData->stateKeys[i], fData->stateDefValues[i]);
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+                fPlugin->initStateHints(i, fData->stateHints[i]);
+# endif
+                fStateKeyHashes[i] = getStateKeyHash(fData->stateKeys[i]);
+            }
+        }
 #endif
 
         fData->callbacksPtr          = callbacksPtr;
         fData->writeMidiCallbackFunc = writeMidiCall;
+        fData->reserveMidiCallbackFunc = reserveMidiCall;
+        fData->writeMidiEventsCallbackFunc = writeMidiEventsCall;
     }
 
     ~PluginExporter()
     {
         delete fPlugin;
+        delete[] fParameterIndexes;
+        delete[] fParameterRangeValues;
+        delete[] fMidiCCTables;
+        delete[] fOutputValueBits;
+        delete[] fDirtyOutputs;
+#if DISTRHO_PLUGIN_WANT_STATE
+        delete[] fStateKeyHashes;
+#endif
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        delete[] fMidiEvents;
+#endif
     }
 
     // -------------------------------------------------------------------
@@ -368,6 +521,117 @@ public:
         return false;
     }
 
+    // -------------------------------------------------------------------
+    // Parameter tables, built once at init so wrappers can skip per-block scans
+
+    uint32_t getInputParameterCount() const noexcept
+    {
+        return fInputParameterCount;
+    }
+
+    const uint32_t* getInputParameterIndexes() const noexcept
+    {
+        return fParameterIndexes;
+    }
+
+    uint32_t getOutputParameterCount() const noexcept
+    {
+        return fOutputParameterCount;
+    }
+
+    const uint32_t* getOutputParameterIndexes() const noexcept
+    {
+        return fParameterIndexes + fInputParameterCount;
+    }
+
+    // Input parameters with the trigger hint
+    uint32_t getTriggerParameterCount() const noexcept
+    {
+        return fTriggerParameterCount;
+    }
+
+    const uint32_t* getTriggerParameterIndexes() const noexcept
+    {
+        return fParameterIndexes + fInputParameterCount + fOutputParameterCount;
+    }
+
+    // Index of the input parameter designated as bypass, -1 if none
+    int32_t getBypassParameterIndex() const noexcept
+    {
+        return fBypassParameterIndex;
+    }
+
+    // Input parameter mapped to control change @a control on MIDI @a channel, -1 if none.
+    // Starts with Parameter::midiCC on channel 1, realtime safe.
+    int32_t getParameterIndexForMidiCC(const uint8_t channel, const uint8_t control) const noexcept
+    {
+        if (channel >= 16 || control >= 128)
+            return -1;
+
+        return fMidiCCTable[channel*128 + control];
+    }
+
+    // Whether control change @a control can be mapped to a parameter.
+    // 0 and 32 are bank select, anything past 119 is a channel mode message.
+    static bool isValidMidiCC(const uint8_t control) noexcept
+    {
+        return control != 0 && control != 32 && control < 0x78;
+    }
+
+    // Map control change @a control on MIDI @a channel to input parameter @a index, or unmap it with -1.
+    // Any previous mapping of that parameter is removed. Not realtime safe, a new table is built and
+    // swapped in atomically. Returns false if the process thread could still be reading the table this
+    // would overwrite, in which case the caller should try again after the next run.
+    bool setParameterMidiCC(const uint8_t channel, const uint8_t control, const int32_t index)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr, false);
+        DISTRHO_SAFE_ASSERT_RETURN(channel < 16 && isValidMidiCC(control), false);
+        DISTRHO_SAFE_ASSERT_RETURN(index < static_cast<int32_t>(fData->parameterCount), false);
+        DISTRHO_SAFE_ASSERT_RETURN(index < 0 || ! isParameterOutput(static_cast<uint32_t>(index)), false);
+
+        if (fIsActive && fRunCount == fMidiCCSwapRunCount)
+            return false;
+
+        int32_t* const current = fMidiCCTable;
+        int32_t* const next = current == fMidiCCTables ? fMidiCCTables + kMidiCCTableSize : fMidiCCTables;
+
+        std::memcpy(next, current, sizeof(int32_t)*kMidiCCTableSize);
+
+        if (index >= 0)
+        {
+            for (uint32_t i=0; i < kMidiCCTableSize; ++i)
+            {
+                if (next[i] == index)
+                    next[i] = -1;
+            }
+        }
+
+        next[channel*128 + control] = index;
+
+        if (! __sync_bool_compare_and_swap(&fMidiCCTable, current, next))
+            return false;
+
+        // nothing can be reading the old table while inactive
+        fMidiCCSwapRunCount = fIsActive ? fRunCount : fRunCount - 1;
+        return true;
+    }
+
+    // Default, minimum and maximum values of all parameters, indexed by parameter
+    const float* getParameterDefValues() const noexcept
+    {
+        return fParameterRangeValues;
+    }
+
+    const float* getParameterMinValues() const noexcept
+    {
+        return fParameterRangeValues + (fData != nullptr ? fData->parameterCount : 0);
+    }
+
+    const float* getParameterMaxValues() const noexcept
+    {
+        return fParameterRangeValues + (fData != nullptr ? fData->parameterCount*2 : 0);
+    }
+
     const String& getParameterName(const uint32_t index) const noexcept
     {
         DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr && index < fData->parameterCount, sFallbackString);
@@ -472,6 +736,17 @@ public:
         return fData->stateDefValues[index];
     }
 
+    bool isStateBinary(const uint32_t index) const noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr && index < fData->stateCount, false);
+
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+        return (fData->stateHints[index] & kStateIsBinary);
+# else
+        return false;
+# endif
+    }
+
 # if DISTRHO_PLUGIN_WANT_FULL_STATE
     String getState(const char* key) const
     {
@@ -491,18 +766,59 @@ public:
         fPlugin->setState(key, value);
     }
 
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+    void getBinaryState(const char* const key, const void*& data, size_t& size) const
+    {
+        data = nullptr;
+        size = 0;
+
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr,);
+        DISTRHO_SAFE_ASSERT_RETURN(key != nullptr && key[0] != '\0',);
+
+        fPlugin->getBinaryState(key, data, size);
+
+        if (data == nullptr)
+            size = 0;
+    }
+
+    void setBinaryState(const char* const key, const void* const data, const size_t size)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr,);
+        DISTRHO_SAFE_ASSERT_RETURN(key != nullptr && key[0] != '\0',);
+
+        fPlugin->setBinaryState(key, size != 0 ? data : nullptr, data != nullptr ? size : 0);
+    }
+# endif
+
     bool wantStateKey(const char* const key) const noexcept
     {
-        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr, false);
-        DISTRHO_SAFE_ASSERT_RETURN(key != nullptr && key[0] != '\0', false);
+        return getStateIndex(key) >= 0;
+    }
+
+    // Index of state @a key, -1 if the plugin has no such state.
+    // Keys are compared by hash first, so only a match costs a string compare.
+    int32_t getStateIndex(const char* const key) const noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr, -1);
+        DISTRHO_SAFE_ASSERT_RETURN(key != nullptr && key[0] != '\0', -1);
+
+        const uint32_t hash = getStateKeyHash(key);
 
         for (uint32_t i=0; i < fData->stateCount; ++i)
         {
-            if (fData->stateKeys[i] == key)
-                return true;
+            if (fStateKeyHashes[i] == hash && fData->stateKeys[i] == key)
+                return static_cast<int32_t>(i);
         }
 
-        return false;
+        return -1;
+    }
+
+    // Hash of the symbol of parameter @a index, saved with its value so state can be matched by symbol.
+    uint32_t getParameterSymbolHash(const uint32_t index) const noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr && index < fData->parameterCount, 0);
+
+        return getStateKeyHash(fData->parameters[index].symbol);
     }
 #endif
 
@@ -564,6 +880,7 @@ public:
             fPlugin->activate();
         }
 
+        ++fRunCount;
         fData->isProcessing = true;
         fPlugin->run(inputs, outputs, frames, midiEvents, midiEventCount);
         fData->isProcessing = false;
@@ -580,12 +897,107 @@ public:
             fPlugin->activate();
         }
 
+        ++fRunCount;
         fData->isProcessing = true;
         fPlugin->run(inputs, outputs, frames);
         fData->isProcessing = false;
     }
 #endif
 
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    // -------------------------------------------------------------------
+    // Streaming run, for wrappers that decode host events one by one.
+    // Call beginRun(), addMidiEvent() for each event in time order, then endRun().
+    // Events are staged in a fixed buffer, when it is full the block is split at an event frame and
+    // the plugin runs once per part with offset audio pointers, so nothing is dropped or allocated.
+
+    void beginRun(const float** const inputs, float** const outputs, const uint32_t frames) noexcept
+    {
+        fRunInputs  = inputs;
+        fRunOutputs = outputs;
+        fRunFrames  = frames;
+        fRunOffset  = 0;
+        fMidiEventCount = 0;
+    }
+
+    bool addMidiEvent(const MidiEvent& midiEvent)
+    {
+        // frame relative to the host block, hosts should never send it past the end
+        const uint32_t frame = midiEvent.frame < fRunFrames ? midiEvent.frame : (fRunFrames != 0 ? fRunFrames - 1 : 0);
+
+        if (fMidiEventCount == fMidiEventCapacity && ! runStagedMidiEvents(frame))
+        {
+            ++fMidiEventDropCount;
+            return false;
+        }
+
+        MidiEvent& staged(fMidiEvents[fMidiEventCount++]);
+        staged = midiEvent;
+        staged.frame = frame > fRunOffset ? frame - fRunOffset : 0;
+        return true;
+    }
+
+# if DISTRHO_PLUGIN_WANT_SAMPLE_ACCURATE_PARAMETERS
+    // Change input parameter @a index at block frame @a frame, in time order with addMidiEvent().
+    // The block is split there, unless that is closer than DISTRHO_PLUGIN_MIN_PARAMETER_SPLIT frames to the
+    // previous split, then the change is applied at that split instead.
+    void addParameterChange(const uint32_t index, const float value, const uint32_t frame)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fPlugin != nullptr,);
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr && index < fData->parameterCount,);
+
+        if (frame < fRunFrames && frame >= fRunOffset + DISTRHO_PLUGIN_MIN_PARAMETER_SPLIT)
+        {
+            ++fParameterSplitCount;
+            runPartUntil(frame - fRunOffset);
+        }
+
+        fPlugin->setParameterValue(index, value);
+    }
+
+    // Number of times a block was split for a parameter change
+    uint64_t getParameterSplitCount() const noexcept
+    {
+        return fParameterSplitCount;
+    }
+# endif
+
+    void endRun()
+    {
+        runPart(fRunFrames - fRunOffset, fMidiEventCount);
+        fMidiEventCount = 0;
+
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        if (fData != nullptr)
+            fData->runFrameOffset = 0;
+#endif
+    }
+
+    // Grow the staging area, not realtime safe and never to be called during a run.
+    void setMidiEventCapacity(const uint32_t capacity)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData == nullptr || ! fData->isProcessing,);
+
+        if (capacity <= fMidiEventCapacity)
+            return;
+
+        delete[] fMidiEvents;
+        fMidiEvents = new MidiEvent[capacity];
+        fMidiEventCapacity = capacity;
+    }
+
+    // Blocks split because the staging area was full, and events that still could not be delivered.
+    uint64_t getMidiEventOverflowCount() const noexcept
+    {
+        return fMidiEventOverflowCount;
+    }
+
+    uint64_t getMidiEventDropCount() const noexcept
+    {
+        return fMidiEventDropCount;
+    }
+#endif
+
     // -------------------------------------------------------------------
 
     uint32_t getBufferSize() const noexcept
@@ -638,7 +1050,214 @@ public:
         }
     }
 
+    // -------------------------------------------------------------------
+    // Output parameter change tracking
+
+    // Mark the output parameters whose value changed since the last call.
+    // Values are compared by bit pattern, so packed data and NaNs are tracked exactly.
+    // Called by the wrappers after each run, bumps the output sequence when anything changed.
+    void updateOutputParameters()
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fPlugin != nullptr,);
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr,);
+
+        const uint32_t* const outputIndexes = getOutputParameterIndexes();
+        bool changed = false;
+
+        for (uint32_t j=0; j < fOutputParameterCount; ++j)
+        {
+            const uint32_t i = outputIndexes[j];
+            const uint32_t bits = getFloatBits(fPlugin->getParameterValue(i));
+
+            if (bits == fOutputValueBits[i])
+                continue;
+
+            fOutputValueBits[i] = bits;
+            __sync_fetch_and_or(&fDirtyOutputs[i/32], 1U << (i%32));
+            changed = true;
+        }
+
+        if (changed)
+            __sync_fetch_and_add(&fOutputSequence, 1U);
+    }
+
+    // Changes whenever updateOutputParameters() marks something, lets idle callbacks skip the bitset scan.
+    uint32_t getOutputSequence() const noexcept
+    {
+        return fOutputSequence;
+    }
+
+    uint32_t getDirtyOutputWordCount() const noexcept
+    {
+        return fDirtyOutputWords;
+    }
+
+    // Return and clear the dirty flags of output parameters @a word*32 up to @a word*32+31.
+    // Bit n set means parameter @a word*32+n changed.
+    uint32_t takeDirtyOutputs(const uint32_t word) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(word < fDirtyOutputWords, 0);
+
+        if (fDirtyOutputs[word] == 0)
+            return 0;
+
+        return __sync_fetch_and_and(&fDirtyOutputs[word], 0U);
+    }
+
 private:
+    static const uint32_t kMidiCCTableSize = 16*128;
+
+#if DISTRHO_PLUGIN_WANT_STATE
+    // FNV-1a
+    static uint32_t getStateKeyHash(const char* key) noexcept
+    {
+        uint32_t hash = 2166136261U;
+
+        for (; *key != '\0'; ++key)
+            hash = (hash ^ static_cast<uint8_t>(*key)) * 16777619U;
+
+        return hash;
+    }
+#endif
+
+    void initParameterTables(const uint32_t count)
+    {
+        // inputs, outputs, then triggers
+        fParameterIndexes     = new uint32_t[count*2];
+        fParameterRangeValues = new float[count*3];
+
+        for (uint32_t i=0; i < count; ++i)
+        {
+            const Parameter& param(fData->parameters[i]);
+
+            fParameterRangeValues[i]         = param.ranges.def;
+            fParameterRangeValues[count+i]   = param.ranges.min;
+            fParameterRangeValues[count*2+i] = param.ranges.max;
+
+            if ((param.hints & kParameterIsOutput) == 0)
+            {
+                fParameterIndexes[fInputParameterCount++] = i;
+
+                if (param.designation == kParameterDesignationBypass && fBypassParameterIndex < 0)
+                    fBypassParameterIndex = static_cast<int32_t>(i);
+
+                if (isValidMidiCC(param.midiCC) && fMidiCCTable[param.midiCC] < 0)
+                    fMidiCCTable[param.midiCC] = static_cast<int32_t>(i);
+            }
+        }
+
+        for (uint32_t i=0; i < count; ++i)
+        {
+            if (fData->parameters[i].hints & kParameterIsOutput)
+                fParameterIndexes[fInputParameterCount + fOutputParameterCount++] = i;
+        }
+
+        uint32_t* const triggerIndexes = fParameterIndexes + count;
+
+        for (uint32_t j=0; j < fInputParameterCount; ++j)
+        {
+            const uint32_t i = fParameterIndexes[j];
+
+            if ((fData->parameters[i].hints & kParameterIsTrigger) == kParameterIsTrigger)
+                triggerIndexes[fTriggerParameterCount++] = i;
+        }
+    }
+
+    static uint32_t getFloatBits(const float value) noexcept
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(uint32_t));
+        return bits;
+    }
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    // -------------------------------------------------------------------
+    // Streaming run helpers
+
+    // Run the plugin from the current offset over @a frames frames with the first @a midiEventCount staged events.
+    void runPart(const uint32_t frames, const uint32_t midiEventCount)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr,);
+
+# if DISTRHO_PLUGIN_NUM_INPUTS > 0
+        const float* inputs[DISTRHO_PLUGIN_NUM_INPUTS];
+
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
+            inputs[i] = fRunInputs[i] + fRunOffset;
+# else
+        const float** const inputs = fRunInputs;
+# endif
+
+# if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+        float* outputs[DISTRHO_PLUGIN_NUM_OUTPUTS];
+
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+            outputs[i] = fRunOutputs[i] + fRunOffset;
+# else
+        float** const outputs = fRunOutputs;
+# endif
+
+# if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        fData->runFrameOffset = fRunOffset;
+# endif
+
+# if DISTRHO_PLUGIN_WANT_TIMEPOS
+        const uint64_t frame = fData->timePosition.frame;
+
+        if (fData->timePosition.playing)
+            fData->timePosition.frame += fRunOffset;
+# endif
+
+        run(inputs, outputs, frames, midiEventCount != 0 ? fMidiEvents : nullptr, midiEventCount);
+
+# if DISTRHO_PLUGIN_WANT_TIMEPOS
+        fData->timePosition.frame = frame;
+# endif
+    }
+
+    // The staging area is full and the event at block frame @a frame does not fit.
+    // Run the staged events that come before that frame, keep the others and move the offset past them.
+    // If every staged event is on that same frame, run them together over that one frame, the new event
+    // comes one frame late. Returns false (drop the event) only if that would reach the end of the block.
+    bool runStagedMidiEvents(const uint32_t frame)
+    {
+        const uint32_t eventFrame = frame > fRunOffset ? frame - fRunOffset : 0;
+        uint32_t split = eventFrame;
+
+        if (fMidiEventCount != 0 && fMidiEvents[0].frame >= eventFrame)
+        {
+            if (fRunOffset + eventFrame + 1 >= fRunFrames)
+                return false;
+
+            split = eventFrame + 1;
+        }
+
+        ++fMidiEventOverflowCount;
+        runPartUntil(split);
+        return true;
+    }
+
+    // Run the next @a split frames with the staged events before that point, keep the rest for later.
+    void runPartUntil(const uint32_t split)
+    {
+        uint32_t count = 0;
+
+        while (count < fMidiEventCount && fMidiEvents[count].frame < split)
+            ++count;
+
+        runPart(split, count);
+
+        for (uint32_t i=count; i < fMidiEventCount; ++i)
+        {
+            fMidiEvents[i-count] = fMidiEvents[i];
+            fMidiEvents[i-count].frame -= split;
+        }
+
+        fMidiEventCount -= count;
+        fRunOffset += split;
+    }
+#endif
+
     // -------------------------------------------------------------------
     // Plugin and DistrhoPlugin data
 
@@ -646,6 +1265,46 @@ private:
     Plugin::PrivateData* const fData;
     bool fIsActive;
 
+    // Parameter tables
+    uint32_t* fParameterIndexes;
+    float*    fParameterRangeValues;
+    uint32_t  fInputParameterCount;
+    uint32_t  fOutputParameterCount;
+    uint32_t  fTriggerParameterCount;
+    int32_t   fBypassParameterIndex;
+
+    // MIDI CC to input parameter, two tables so learning never writes the one being read
+    int32_t*          fMidiCCTables;
+    int32_t* volatile fMidiCCTable;
+    uint32_t          fMidiCCSwapRunCount;
+    volatile uint32_t fRunCount;
+
+    // Output parameter change tracking
+    uint32_t* fOutputValueBits;
+    uint32_t* fDirtyOutputs;
+    uint32_t  fDirtyOutputWords;
+    volatile uint32_t fOutputSequence;
+
+#if DISTRHO_PLUGIN_WANT_STATE
+    uint32_t* fStateKeyHashes;
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    // Streaming run state
+    MidiEvent*     fMidiEvents;
+    uint32_t       fMidiEventCapacity;
+    uint32_t       fMidiEventCount;
+    uint64_t       fMidiEventOverflowCount;
+    uint64_t       fMidiEventDropCount;
+    const float**  fRunInputs;
+    float**        fRunOutputs;
+    uint32_t       fRunFrames;
+    uint32_t       fRunOffset;
+# if DISTRHO_PLUGIN_WANT_SAMPLE_ACCURATE_PARAMETERS
+    uint64_t       fParameterSplitCount;
+# endif
+#endif
+
     // -------------------------------------------------------------------
     // Static fallback data, see DistrhoPlugin.cpp
 
@@ -658,6 +1317,134 @@ private:
     DISTRHO_PREVENT_HEAP_ALLOCATION
 };
 
+#if DISTRHO_PLUGIN_WANT_STATE
+// -----------------------------------------------------------------------
+// Current value of each state, addressed by state index.
+// Used by wrappers that save state or send it to the UI. Buffers are sized for the default value
+// and only grow in set(), which must never be called from the audio thread.
+
+class PluginStateValues
+{
+public:
+    PluginStateValues() noexcept
+        : fValues(nullptr),
+          fLengths(nullptr),
+          fSizes(nullptr),
+          fCount(0) {}
+
+    ~PluginStateValues()
+    {
+        clear();
+    }
+
+    void init(const PluginExporter& plugin)
+    {
+        clear();
+
+        fCount = plugin.getStateCount();
+
+        if (fCount == 0)
+            return;
+
+        fValues  = new char*[fCount];
+        fLengths = new uint32_t[fCount];
+        fSizes   = new uint32_t[fCount];
+
+        for (uint32_t i=0; i < fCount; ++i)
+        {
+            const String& value(plugin.getStateDefaultValue(i));
+
+            fValues[i]  = nullptr;
+            fLengths[i] = 0;
+            fSizes[i]   = 0;
+
+            // binary states are kept by the plugin, they stay empty here
+            if (plugin.isStateBinary(i))
+                set(i, "", 0);
+            else
+                set(i, value.buffer(), static_cast<uint32_t>(value.length()));
+        }
+    }
+
+    void clear() noexcept
+    {
+        for (uint32_t i=0; i < fCount; ++i)
+            delete[] fValues[i];
+
+        delete[] fValues;
+        delete[] fLengths;
+        delete[] fSizes;
+
+        fValues  = nullptr;
+        fLengths = nullptr;
+        fSizes   = nullptr;
+        fCount   = 0;
+    }
+
+    uint32_t getCount() const noexcept
+    {
+        return fCount;
+    }
+
+    const char* get(const uint32_t index) const noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(index < fCount, "");
+
+        return fValues[index];
+    }
+
+    uint32_t getLength(const uint32_t index) const noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(index < fCount, 0);
+
+        return fLengths[index];
+    }
+
+    void set(const uint32_t index, const char* const value)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(value != nullptr,);
+
+        set(index, value, static_cast<uint32_t>(std::strlen(value)));
+    }
+
+    void set(const uint32_t index, const char* const value, const uint32_t length)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(index < fCount,);
+        DISTRHO_SAFE_ASSERT_RETURN(value != nullptr,);
+
+        if (length >= fSizes[index])
+        {
+            uint32_t size = fSizes[index] != 0 ? fSizes[index] : 64;
+
+            while (size <= length)
+                size *= 2;
+
+            char* const buffer = new char[size];
+            std::memcpy(buffer, value, length);
+
+            delete[] fValues[index];
+            fValues[index] = buffer;
+            fSizes[index]  = size;
+        }
+        else
+        {
+            std::memmove(fValues[index], value, length);
+        }
+
+        fValues[index][length] = '\0';
+        fLengths[index] = length;
+    }
+
+private:
+    char**    fValues;
+    uint32_t* fLengths;
+    uint32_t* fSizes;
+    uint32_t  fCount;
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(PluginStateValues)
+};
+#endif
+
 // -----------------------------------------------------------------------
 
 END_NAMESPACE_DISTRHO
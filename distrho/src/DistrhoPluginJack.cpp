@@ -23,9 +23,13 @@
 
 #if DISTRHO_PLUGIN_HAS_UI
 # include "DistrhoUIInternal.hpp"
-#else
+#endif
+#if ! DISTRHO_PLUGIN_HAS_UI
 # include "../extra/Sleep.hpp"
 #endif
+#if DISTRHO_PLUGIN_HAS_UI && DISTRHO_PLUGIN_WANT_STATE
+# include "../extra/Thread.hpp"
+#endif
 
 #include "jack/jack.h"
 #include "jack/midiport.h"
@@ -42,8 +46,13 @@ START_NAMESPACE_DISTRHO
 #if DISTRHO_PLUGIN_HAS_UI && ! DISTRHO_PLUGIN_WANT_STATE
 static const setStateFunc setStateCallback = nullptr;
 #endif
+#if DISTRHO_PLUGIN_HAS_UI && ! DISTRHO_PLUGIN_WANT_MIDI_INPUT
+static const sendNoteFunc sendNoteCallback = nullptr;
+#endif
 #if ! DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
-static const writeMidiFunc writeMidiCallback = nullptr;
+static const writeMidiFunc       writeMidiCallback       = nullptr;
+static const reserveMidiFunc     reserveMidiCallback     = nullptr;
+static const writeMidiEventsFunc writeMidiEventsCallback = nullptr;
 #endif
 
 // -----------------------------------------------------------------------
@@ -86,6 +95,201 @@ static void initSignalHandler()
 
 // -----------------------------------------------------------------------
 
+#if DISTRHO_PLUGIN_HAS_UI && DISTRHO_PLUGIN_WANT_MIDI_INPUT
+// Bounded single-producer single-consumer queue of notes, from the UI thread to the process thread.
+struct UiNoteQueue {
+    static const uint32_t kSize = 128; // must be a power of 2
+
+    uint8_t data[kSize][3];
+    volatile uint32_t writeIndex;
+    volatile uint32_t readIndex;
+
+    UiNoteQueue() noexcept
+        : writeIndex(0),
+          readIndex(0) {}
+
+    bool push(const uint8_t status, const uint8_t note, const uint8_t velocity) noexcept
+    {
+        const uint32_t index = writeIndex;
+
+        if (index - readIndex == kSize)
+            return false;
+
+        uint8_t* const msg = data[index % kSize];
+        msg[0] = status;
+        msg[1] = note;
+        msg[2] = velocity;
+
+        __sync_synchronize();
+        writeIndex = index + 1;
+        return true;
+    }
+
+    bool pop(MidiEvent& midiEvent) noexcept
+    {
+        const uint32_t index = readIndex;
+
+        if (index == writeIndex)
+            return false;
+
+        __sync_synchronize();
+
+        midiEvent.frame   = 0;
+        midiEvent.size    = 3;
+        midiEvent.dataExt = nullptr;
+        std::memcpy(midiEvent.data, data[index % kSize], 3);
+
+        __sync_synchronize();
+        readIndex = index + 1;
+        return true;
+    }
+};
+#endif
+
+#if DISTRHO_PLUGIN_HAS_UI && DISTRHO_PLUGIN_WANT_STATE
+// Applies state changes from the UI on its own thread, like the LV2 worker does.
+// setState() may allocate or do file I/O, so it never runs on the process thread and the UI thread never waits
+// for it. Only the latest value of each state is kept until the worker gets to it.
+class UiStateWorker : public Thread
+{
+public:
+    UiStateWorker(PluginExporter& plugin)
+        : Thread("UiStateWorker"),
+          fPlugin(plugin),
+          fMutex(),
+          fWakeUp(),
+          fValues(),
+          fPending(nullptr)
+    {
+        fValues.init(plugin);
+
+        if (const uint32_t count = fValues.getCount())
+        {
+            fPending = new bool[count];
+            std::memset(fPending, 0, sizeof(bool)*count);
+        }
+    }
+
+    ~UiStateWorker() override
+    {
+        stop();
+        delete[] fPending;
+    }
+
+    void stop()
+    {
+        signalThreadShouldExit();
+        fWakeUp.signal();
+        stopThread(-1);
+    }
+
+    // UI thread, replaces a value the worker did not get to yet
+    void push(const char* const key, const char* const value)
+    {
+        const int32_t index = fPlugin.getStateIndex(key);
+        DISTRHO_SAFE_ASSERT_RETURN(index >= 0,);
+
+        {
+            const MutexLocker cml(fMutex);
+            fValues.set(static_cast<uint32_t>(index), value);
+            fPending[index] = true;
+        }
+
+        fWakeUp.signal();
+    }
+
+protected:
+    void run() override
+    {
+        String value;
+
+        while (! shouldThreadExit())
+        {
+            fWakeUp.wait();
+
+            for (uint32_t i=0, count=fValues.getCount(); i < count && ! shouldThreadExit(); ++i)
+            {
+                {
+                    const MutexLocker cml(fMutex);
+
+                    if (! fPending[i])
+                        continue;
+
+                    fPending[i] = false;
+                    value = fValues.get(i);
+                }
+
+                fPlugin.setState(fPlugin.getStateKey(i), value);
+            }
+        }
+    }
+
+private:
+    PluginExporter& fPlugin;
+    Mutex  fMutex;
+    Signal fWakeUp;
+
+    // protected by fMutex
+    PluginStateValues fValues;
+    bool* fPending;
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(UiStateWorker)
+};
+#endif
+
+#if DISTRHO_PLUGIN_HAS_UI
+// MIDI learn request from the UI thread. The process thread only records the first control change that
+// arrives while a request is pending, the mapping is then changed on the UI thread, see setParameterMidiCC().
+struct MidiLearnRequest {
+    volatile int32_t index;   // parameter to map, -1 if none
+    volatile int32_t control; // channel*128 + control caught by the process thread, -1 if none
+
+    MidiLearnRequest() noexcept
+        : index(-1),
+          control(-1) {}
+
+    // UI thread, -1 cancels
+    void request(const int32_t newIndex) noexcept
+    {
+        // forget a control caught for an earlier request
+        index = -1;
+        __sync_synchronize();
+        control = -1;
+        __sync_synchronize();
+        index = newIndex < 0 ? -1 : newIndex;
+    }
+
+    // process thread
+    void controlChange(const uint8_t channel, const uint8_t cc) noexcept
+    {
+        if (index >= 0 && control < 0 && PluginExporter::isValidMidiCC(cc))
+            control = channel*128 + cc;
+    }
+
+    // UI thread
+    void apply(PluginExporter& plugin)
+    {
+        const int32_t caught = control;
+
+        if (caught < 0)
+            return;
+
+        const int32_t target = index;
+
+        // on false the process thread may still read the spare table, try again on the next idle
+        if (target >= 0 && ! plugin.setParameterMidiCC(static_cast<uint8_t>(caught/128),
+                                                       static_cast<uint8_t>(caught%128), target))
+            return;
+
+        index = -1;
+        __sync_synchronize();
+        control = -1;
+    }
+};
+#endif
+
+// -----------------------------------------------------------------------
+
 #if DISTRHO_PLUGIN_HAS_UI
 class PluginJack : public IdleCallback
 #else
@@ -94,11 +298,14 @@ class PluginJack
 {
 public:
     PluginJack(jack_client_t* const client)
-        : fPlugin(this, writeMidiCallback),
+        : fPlugin(this, writeMidiCallback, reserveMidiCallback, writeMidiEventsCallback),
 #if DISTRHO_PLUGIN_HAS_UI
-          fUI(this, 0, nullptr, setParameterValueCallback, setStateCallback, nullptr, setSizeCallback, fPlugin.getInstancePointer()),
+          fUI(this, 0, nullptr, setParameterValueCallback, setStateCallback, sendNoteCallback, setSizeCallback, fPlugin.getInstancePointer()),
 #endif
           fClient(client)
+#if DISTRHO_PLUGIN_HAS_UI && DISTRHO_PLUGIN_WANT_STATE
+        , fStateWorker(fPlugin)
+#endif
     {
 #if DISTRHO_PLUGIN_NUM_INPUTS > 0 || DISTRHO_PLUGIN_NUM_OUTPUTS > 0
         char strBuf[0xff+1];
@@ -126,6 +333,11 @@ public:
         fPortMidiOut = jack_port_register(fClient, "midi-out", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
         fPortMidiOutBuffer = nullptr;
 #endif
+#if DISTRHO_PLUGIN_MIDI_THRU
+        fMidiThruBuffer = nullptr;
+        fMidiThruIndex = fMidiThruCount = 0;
+        fMidiThruFrame = UINT32_MAX;
+#endif
 
 #if DISTRHO_PLUGIN_WANT_PROGRAMS
         if (fPlugin.getProgramCount() > 0)
@@ -142,12 +354,14 @@ public:
 
         if (const uint32_t count = fPlugin.getParameterCount())
         {
-            fLastOutputValues = new float[count];
-            std::memset(fLastOutputValues, 0, sizeof(float)*count);
-
 #if DISTRHO_PLUGIN_HAS_UI
             fParametersChanged = new bool[count];
             std::memset(fParametersChanged, 0, sizeof(bool)*count);
+
+            fUiParameterWordCount = (count + 31) / 32;
+            fUiParameterValues = new float[count];
+            fUiParameterBits = new uint32_t[fUiParameterWordCount];
+            std::memset(fUiParameterBits, 0, sizeof(uint32_t)*fUiParameterWordCount);
 #endif
 
             for (uint32_t i=0; i < count; ++i)
@@ -160,12 +374,24 @@ public:
         }
         else
         {
-            fLastOutputValues = nullptr;
 #if DISTRHO_PLUGIN_HAS_UI
             fParametersChanged = nullptr;
+            fUiParameterValues = nullptr;
+            fUiParameterBits = nullptr;
+            fUiParameterWordCount = 0;
 #endif
         }
 
+#if DISTRHO_PLUGIN_HAS_UI
+        fLastOutputSequence = 0;
+        fUI.setMidiLearnCallback(midiLearnCallback);
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        // one event per frame, a denser period is split into several runs
+        fPlugin.setMidiEventCapacity(jack_get_buffer_size(fClient));
+#endif
+
         jack_set_buffer_size_callback(fClient, jackBufferSizeCallback, this);
         jack_set_sample_rate_callback(fClient, jackSampleRateCallback, this);
         jack_set_process_callback(fClient, jackProcessCallback, this);
@@ -173,6 +399,10 @@ public:
 
         fPlugin.activate();
 
+#if DISTRHO_PLUGIN_HAS_UI && DISTRHO_PLUGIN_WANT_STATE
+        fStateWorker.startThread();
+#endif
+
         jack_activate(fClient);
 
 #if DISTRHO_PLUGIN_HAS_UI
@@ -190,21 +420,31 @@ public:
 
     ~PluginJack()
     {
+#if DISTRHO_PLUGIN_HAS_UI && DISTRHO_PLUGIN_WANT_STATE
+        fStateWorker.stop();
+#endif
+
         if (fClient != nullptr)
             jack_deactivate(fClient);
 
-        if (fLastOutputValues != nullptr)
-        {
-            delete[] fLastOutputValues;
-            fLastOutputValues = nullptr;
-        }
-
 #if DISTRHO_PLUGIN_HAS_UI
         if (fParametersChanged != nullptr)
         {
             delete[] fParametersChanged;
             fParametersChanged = nullptr;
         }
+
+        if (fUiParameterValues != nullptr)
+        {
+            delete[] fUiParameterValues;
+            fUiParameterValues = nullptr;
+        }
+
+        if (fUiParameterBits != nullptr)
+        {
+            delete[] fUiParameterBits;
+            fUiParameterBits = nullptr;
+        }
 #endif
 
         fPlugin.deactivate();
@@ -256,20 +496,28 @@ protected:
         }
 # endif
 
-        for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
+        // only visit outputs that changed since the last idle
+        const uint32_t outputSequence = fPlugin.getOutputSequence();
+
+        if (outputSequence != fLastOutputSequence)
         {
-            if (fPlugin.isParameterOutput(i))
+            fLastOutputSequence = outputSequence;
+
+            for (uint32_t w=0, wcount=fPlugin.getDirtyOutputWordCount(); w < wcount; ++w)
             {
-                const float value = fPlugin.getParameterValue(i);
+                for (uint32_t bits = fPlugin.takeDirtyOutputs(w); bits != 0; bits &= bits - 1)
+                {
+                    const uint32_t i = w*32 + static_cast<uint32_t>(__builtin_ctz(bits));
+                    fUI.parameterChanged(i, fPlugin.getParameterValue(i));
+                }
+            }
+        }
 
-                //TODO CjD Figure out why the values are always true for the midi events
-                // if (d_isEqual(fLastOutputValues[i], value))
-                //     continue;
+        fMidiLearn.apply(fPlugin);
 
-                fLastOutputValues[i] = value;
-                fUI.parameterChanged(i, value);
-            }
-            else if (fParametersChanged[i])
+        for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
+        {
+            if (fParametersChanged[i])
             {
                 fParametersChanged[i] = false;
                 fUI.parameterChanged(i, fPlugin.getParameterValue(i));
@@ -283,6 +531,10 @@ protected:
     void jackBufferSize(const jack_nframes_t nframes)
     {
         fPlugin.setBufferSize(nframes, true);
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        // JACK never calls this while processing, so the staging area can be reallocated here
+        fPlugin.setMidiEventCapacity(nframes);
+#endif
     }
 
     void jackSampleRate(const jack_nframes_t nframes)
@@ -310,6 +562,21 @@ protected:
         static float** audioOuts = nullptr;
 #endif
 
+#if DISTRHO_PLUGIN_HAS_UI
+        // parameter changes from the UI, only the latest value of each is applied
+        for (uint32_t w=0; w < fUiParameterWordCount; ++w)
+        {
+            if (fUiParameterBits[w] == 0)
+                continue;
+
+            for (uint32_t bits = __sync_fetch_and_and(&fUiParameterBits[w], 0U); bits != 0; bits &= bits - 1)
+            {
+                const uint32_t i = w*32 + static_cast<uint32_t>(__builtin_ctz(bits));
+                fPlugin.setParameterValue(i, fUiParameterValues[i]);
+            }
+        }
+#endif
+
 #if DISTRHO_PLUGIN_WANT_TIMEPOS
         jack_position_t pos;
         fTimePosition.playing = (jack_transport_query(fClient, &pos) == JackTransportRolling);
@@ -352,12 +619,30 @@ protected:
         jack_midi_clear_buffer(fPortMidiOutBuffer);
 #endif
 
-        if (const uint32_t eventCount = jack_midi_get_event_count(midiBuf))
-        {
+#if DISTRHO_PLUGIN_MIDI_THRU
+        // input is forwarded lazily, merged with whatever the plugin writes
+        fMidiThruBuffer = midiBuf;
+        fMidiThruIndex  = 0;
+        fMidiThruCount  = jack_midi_get_event_count(midiBuf);
+        fMidiThruFrame  = fMidiThruCount != 0 ? 0 : UINT32_MAX;
+#endif
+
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-            uint32_t  midiEventCount = 0;
-            MidiEvent midiEvents[eventCount];
+        fPlugin.beginRun(audioIns, audioOuts, nframes);
+
+# if DISTRHO_PLUGIN_HAS_UI
+        // notes from the UI go first, at frame 0
+        {
+            MidiEvent midiEvent;
+
+            while (fUiNotes.pop(midiEvent))
+                fPlugin.addMidiEvent(midiEvent);
+        }
+# endif
 #endif
+
+        if (const uint32_t eventCount = jack_midi_get_event_count(midiBuf))
+        {
             jack_midi_event_t jevent;
 
             for (uint32_t i=0; i < eventCount; ++i)
@@ -365,28 +650,28 @@ protected:
                 if (jack_midi_event_get(&jevent, midiBuf, i) != 0)
                     break;
 
-                // Check if message is control change on channel 1
-                if (jevent.buffer[0] == 0xB0 && jevent.size == 3)
+                // Check if message is control change mapped to a parameter
+                if ((jevent.buffer[0] & 0xF0) == 0xB0 && jevent.size == 3)
                 {
-                    const uint8_t control = jevent.buffer[1];
-                    const uint8_t value   = jevent.buffer[2];
+#if DISTRHO_PLUGIN_HAS_UI
+                    fMidiLearn.controlChange(jevent.buffer[0] & 0x0F, jevent.buffer[1]);
+#endif
 
-                    /* NOTE: This is not optimal, we're iterating all parameters on every CC message.
-                             Since the JACK standalone is more of a test tool, this will do for now. */
-                    for (uint32_t j=0, paramCount=fPlugin.getParameterCount(); j < paramCount; ++j)
-                    {
-                        if (fPlugin.isParameterOutput(j))
-                            continue;
-                        if (fPlugin.getParameterMidiCC(j) != control)
-                            continue;
+                    const int32_t index = fPlugin.getParameterIndexForMidiCC(jevent.buffer[0] & 0x0F, jevent.buffer[1]);
 
-                        const float scaled = static_cast<float>(value)/127.0f;
+                    if (index >= 0)
+                    {
+                        const uint32_t j = static_cast<uint32_t>(index);
+                        const float scaled = static_cast<float>(jevent.buffer[2])/127.0f;
                         const float fvalue = fPlugin.getParameterRanges(j).getUnnormalizedValue(scaled);
+#if DISTRHO_PLUGIN_WANT_SAMPLE_ACCURATE_PARAMETERS
+                        fPlugin.addParameterChange(j, fvalue, jevent.time);
+#else
                         fPlugin.setParameterValue(j, fvalue);
+#endif
 #if DISTRHO_PLUGIN_HAS_UI
                         fParametersChanged[j] = true;
 #endif
-                        break;
                     }
                 }
 #if DISTRHO_PLUGIN_WANT_PROGRAMS
@@ -406,31 +691,41 @@ protected:
 #endif
 
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-                MidiEvent& midiEvent(midiEvents[midiEventCount++]);
+                MidiEvent midiEvent;
 
                 midiEvent.frame = jevent.time;
                 midiEvent.size  = jevent.size;
 
                 if (midiEvent.size > MidiEvent::kDataSize)
+                {
                     midiEvent.dataExt = jevent.buffer;
+                }
                 else
+                {
+                    midiEvent.dataExt = nullptr;
                     std::memcpy(midiEvent.data, jevent.buffer, midiEvent.size);
-#endif
-            }
+                }
 
-#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-            fPlugin.run(audioIns, audioOuts, nframes, midiEvents, midiEventCount);
+                fPlugin.addMidiEvent(midiEvent);
 #endif
+            }
         }
+
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-        else
-        {
-            fPlugin.run(audioIns, audioOuts, nframes, nullptr, 0);
-        }
+        fPlugin.endRun();
 #else
         fPlugin.run(audioIns, audioOuts, nframes);
 #endif
 
+#if DISTRHO_PLUGIN_MIDI_THRU
+        flushMidiThru(UINT32_MAX);
+        fMidiThruBuffer = nullptr;
+#endif
+
+#if DISTRHO_PLUGIN_HAS_UI
+        fPlugin.updateOutputParameters();
+#endif
+
 #if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
         fPortMidiOutBuffer = nullptr;
 #endif
@@ -449,23 +744,51 @@ protected:
 
     // -------------------------------------------------------------------
 
+#if DISTRHO_PLUGIN_HAS_UI
+    // Called from the UI thread, applied at the start of the next period
     void setParameterValue(const uint32_t index, const float value)
     {
-        fPlugin.setParameterValue(index, value);
+        DISTRHO_SAFE_ASSERT_RETURN(index < fPlugin.getParameterCount(),);
+
+        fUiParameterValues[index] = value;
+        __sync_fetch_and_or(&fUiParameterBits[index/32], 1U << (index%32));
     }
 
-#if DISTRHO_PLUGIN_WANT_STATE
+# if DISTRHO_PLUGIN_WANT_STATE
+    // Called from the UI thread, applied by the state worker
     void setState(const char* const key, const char* const value)
     {
-        fPlugin.setState(key, value);
+        fStateWorker.push(key, value);
     }
-#endif
+# endif
+
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    // Called from the UI thread, sent to the plugin at the start of the next period
+    void sendNote(const uint8_t channel, const uint8_t note, const uint8_t velocity)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(channel < 16,);
+        DISTRHO_SAFE_ASSERT_RETURN(note < 128,);
+
+        const uint8_t status = static_cast<uint8_t>((velocity != 0 ? 0x90 : 0x80) | channel);
+
+        if (! fUiNotes.push(status, note, velocity))
+            d_stderr2("UI note queue is full, note dropped");
+    }
+# endif
 
-#if DISTRHO_PLUGIN_HAS_UI
     void setSize(const uint width, const uint height)
     {
         fUI.setWindowSize(width, height);
     }
+
+    // Called from the UI thread, the next control change received is mapped to @a index, -1 cancels
+    void midiLearn(const int32_t index)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(index < static_cast<int32_t>(fPlugin.getParameterCount()),);
+        DISTRHO_SAFE_ASSERT_RETURN(index < 0 || ! fPlugin.isParameterOutput(static_cast<uint32_t>(index)),);
+
+        fMidiLearn.request(index);
+    }
 #endif
 
 #if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
@@ -473,27 +796,90 @@ protected:
     {
         DISTRHO_SAFE_ASSERT_RETURN(fPortMidiOutBuffer != nullptr, false);
 
+# if DISTRHO_PLUGIN_MIDI_THRU
+        if (midiEvent.frame >= fMidiThruFrame)
+            flushMidiThru(midiEvent.frame);
+# endif
+
         return jack_midi_event_write(fPortMidiOutBuffer,
                                      midiEvent.frame,
                                      midiEvent.size > MidiEvent::kDataSize ? midiEvent.dataExt : midiEvent.data,
                                      midiEvent.size) == 0;
     }
+
+    uint8_t* reserveMidi(const uint32_t frame, const uint32_t size)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fPortMidiOutBuffer != nullptr, nullptr);
+
+# if DISTRHO_PLUGIN_MIDI_THRU
+        if (frame >= fMidiThruFrame)
+            flushMidiThru(frame);
+# endif
+
+        return jack_midi_event_reserve(fPortMidiOutBuffer, frame, size);
+    }
+
+    uint32_t writeMidiEvents(const MidiEvent* const midiEvents, const uint32_t count, const uint32_t frameOffset)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fPortMidiOutBuffer != nullptr, 0);
+
+        for (uint32_t i=0; i < count; ++i)
+        {
+            const MidiEvent& midiEvent(midiEvents[i]);
+
+# if DISTRHO_PLUGIN_MIDI_THRU
+            if (midiEvent.frame + frameOffset >= fMidiThruFrame)
+                flushMidiThru(midiEvent.frame + frameOffset);
+# endif
+
+            if (jack_midi_event_write(fPortMidiOutBuffer,
+                                      midiEvent.frame + frameOffset,
+                                      midiEvent.size > MidiEvent::kDataSize ? midiEvent.dataExt : midiEvent.data,
+                                      midiEvent.size) != 0)
+                return i;
+        }
+
+        return count;
+    }
 #endif
 
-    // NOTE: no trigger support for JACK, simulate it here
-    void updateParameterTriggers()
+#if DISTRHO_PLUGIN_MIDI_THRU
+    // Copy input events up to and including @a frame to the output, ahead of plugin events on the same frame.
+    void flushMidiThru(const uint32_t frame)
     {
-        float defValue;
+        jack_midi_event_t jevent;
 
-        for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
+        for (; fMidiThruIndex < fMidiThruCount; ++fMidiThruIndex)
         {
-            if ((fPlugin.getParameterHints(i) & kParameterIsTrigger) != kParameterIsTrigger)
+            if (jack_midi_event_get(&jevent, fMidiThruBuffer, fMidiThruIndex) != 0)
                 continue;
 
-            defValue = fPlugin.getParameterRanges(i).def;
+            if (jevent.time > frame)
+            {
+                fMidiThruFrame = jevent.time;
+                return;
+            }
 
-            if (d_isNotEqual(defValue, fPlugin.getParameterValue(i)))
-                fPlugin.setParameterValue(i, defValue);
+            if (jack_midi_data_t* const data = jack_midi_event_reserve(fPortMidiOutBuffer, jevent.time, jevent.size))
+                std::memcpy(data, jevent.buffer, jevent.size);
+        }
+
+        fMidiThruFrame = UINT32_MAX;
+    }
+#endif
+
+    // NOTE: no trigger support for JACK, simulate it here
+    void updateParameterTriggers()
+    {
+        const uint32_t* const triggerIndexes = fPlugin.getTriggerParameterIndexes();
+        const float*    const defValues      = fPlugin.getParameterDefValues();
+
+        for (uint32_t j=0, count=fPlugin.getTriggerParameterCount(); j < count; ++j)
+        {
+            const uint32_t i = triggerIndexes[j];
+
+            if (d_isNotEqual(defValues[i], fPlugin.getParameterValue(i)))
+                fPlugin.setParameterValue(i, defValues[i]);
         }
     }
 
@@ -518,16 +904,32 @@ private:
     jack_port_t* fPortMidiOut;
     void*        fPortMidiOutBuffer;
 #endif
+#if DISTRHO_PLUGIN_MIDI_THRU
+    void*        fMidiThruBuffer;
+    uint32_t     fMidiThruIndex, fMidiThruCount;
+    uint32_t     fMidiThruFrame; // time of the next event to forward
+#endif
 #if DISTRHO_PLUGIN_WANT_TIMEPOS
     TimePosition fTimePosition;
 #endif
 
-    // Temporary data
-    float* fLastOutputValues;
-
 #if DISTRHO_PLUGIN_HAS_UI
     // Store DSP changes to send to UI
     bool* fParametersChanged;
+    uint32_t fLastOutputSequence;
+
+    MidiLearnRequest fMidiLearn;
+
+    // Store UI changes to send to DSP
+    float*    fUiParameterValues;
+    uint32_t* fUiParameterBits;
+    uint32_t  fUiParameterWordCount;
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    UiNoteQueue fUiNotes;
+# endif
+# if DISTRHO_PLUGIN_WANT_STATE
+    UiStateWorker fStateWorker;
+# endif
 # if DISTRHO_PLUGIN_WANT_PROGRAMS
     int fProgramChanged;
 # endif
@@ -561,23 +963,35 @@ private:
         thisPtr->jackShutdown();
     }
 
+#if DISTRHO_PLUGIN_HAS_UI
     static void setParameterValueCallback(void* ptr, uint32_t index, float value)
     {
         thisPtr->setParameterValue(index, value);
     }
 
-#if DISTRHO_PLUGIN_WANT_STATE
+# if DISTRHO_PLUGIN_WANT_STATE
     static void setStateCallback(void* ptr, const char* key, const char* value)
     {
         thisPtr->setState(key, value);
     }
-#endif
+# endif
+
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    static void sendNoteCallback(void* ptr, uint8_t channel, uint8_t note, uint8_t velocity)
+    {
+        thisPtr->sendNote(channel, note, velocity);
+    }
+# endif
 
-#if DISTRHO_PLUGIN_HAS_UI
     static void setSizeCallback(void* ptr, uint width, uint height)
     {
         thisPtr->setSize(width, height);
     }
+
+    static void midiLearnCallback(void* ptr, int32_t index)
+    {
+        thisPtr->midiLearn(index);
+    }
 #endif
 
 #if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
@@ -585,6 +999,16 @@ private:
     {
         return thisPtr->writeMidi(midiEvent);
     }
+
+    static uint8_t* reserveMidiCallback(void* ptr, uint32_t frame, uint32_t size)
+    {
+        return thisPtr->reserveMidi(frame, size);
+    }
+
+    static uint32_t writeMidiEventsCallback(void* ptr, const MidiEvent* midiEvents, uint32_t count, uint32_t frameOffset)
+    {
+        return thisPtr->writeMidiEvents(midiEvents, count, frameOffset);
+    }
 #endif
 
     #undef thisPtr
@@ -178,16 +178,19 @@ public:
             return updateParameterOutputsAndTriggers();
 
         // Check for updated parameters
+        const uint32_t* const inputIndexes = fPlugin.getInputParameterIndexes();
         float curValue;
 
-        for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
+        for (uint32_t j=0, count=fPlugin.getInputParameterCount(); j < count; ++j)
         {
+            const uint32_t i = inputIndexes[j];
+
             if (fPortControls[i] == nullptr)
                 continue;
 
             curValue = *fPortControls[i];
 
-            if (fPlugin.isParameterInput(i) && d_isNotEqual(fLastControlValues[i], curValue))
+            if (d_isNotEqual(fLastControlValues[i], curValue))
             {
                 fLastControlValues[i] = curValue;
                 fPlugin.setParameterValue(i, curValue);
@@ -195,14 +198,16 @@ public:
         }
 
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-        // Get MIDI Events
-        uint32_t  midiEventCount = 0;
-        MidiEvent midiEvents[eventCount];
+        // Get MIDI Events, streamed to the plugin as they are decoded
+        fPlugin.beginRun(fPortAudioIns, fPortAudioOuts, sampleCount);
 
-        for (uint32_t i=0, j; i < eventCount; ++i)
+        for (uint32_t i=0; i < eventCount; ++i)
         {
             const snd_seq_event_t& seqEvent(events[i]);
 
+            MidiEvent midiEvent;
+            midiEvent.dataExt = nullptr;
+
             // FIXME
             if (seqEvent.data.note.channel > 0xF || seqEvent.data.control.channel > 0xF)
                 continue;
@@ -210,64 +215,63 @@ public:
             switch (seqEvent.type)
             {
             case SND_SEQ_EVENT_NOTEOFF:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 3;
-                midiEvents[j].data[0] = 0x80 + seqEvent.data.note.channel;
-                midiEvents[j].data[1] = seqEvent.data.note.note;
-                midiEvents[j].data[2] = 0;
-                midiEvents[j].data[3] = 0;
+                midiEvent.frame   = seqEvent.time.tick;
+                midiEvent.size    = 3;
+                midiEvent.data[0] = 0x80 + seqEvent.data.note.channel;
+                midiEvent.data[1] = seqEvent.data.note.note;
+                midiEvent.data[2] = 0;
+                midiEvent.data[3] = 0;
                 break;
             case SND_SEQ_EVENT_NOTEON:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 3;
-                midiEvents[j].data[0] = 0x90 + seqEvent.data.note.channel;
-                midiEvents[j].data[1] = seqEvent.data.note.note;
-                midiEvents[j].data[2] = seqEvent.data.note.velocity;
-                midiEvents[j].data[3] = 0;
+                midiEvent.frame   = seqEvent.time.tick;
+                midiEvent.size    = 3;
+                midiEvent.data[0] = 0x90 + seqEvent.data.note.channel;
+                midiEvent.data[1] = seqEvent.data.note.note;
+                midiEvent.data[2] = seqEvent.data.note.velocity;
+                midiEvent.data[3] = 0;
                 break;
             case SND_SEQ_EVENT_KEYPRESS:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 3;
-                midiEvents[j].data[0] = 0xA0 + seqEvent.data.note.channel;
-                midiEvents[j].data[1] = seqEvent.data.note.note;
-                midiEvents[j].data[2] = seqEvent.data.note.velocity;
-                midiEvents[j].data[3] = 0;
+                midiEvent.frame   = seqEvent.time.tick;
+                midiEvent.size    = 3;
+                midiEvent.data[0] = 0xA0 + seqEvent.data.note.channel;
+                midiEvent.data[1] = seqEvent.data.note.note;
+                midiEvent.data[2] = seqEvent.data.note.velocity;
+                midiEvent.data[3] = 0;
                 break;
             case SND_SEQ_EVENT_CONTROLLER:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 3;
-                midiEvents[j].data[0] = 0xB0 + seqEvent.data.control.channel;
-                midiEvents[j].data[1] = seqEvent.data.control.param;
-                midiEvents[j].data[2] = seqEvent.data.control.value;
-                midiEvents[j].data[3] = 0;
+                midiEvent.frame   = seqEvent.time.tick;
+                midiEvent.size    = 3;
+                midiEvent.data[0] = 0xB0 + seqEvent.data.control.channel;
+                midiEvent.data[1] = seqEvent.data.control.param;
+                midiEvent.data[2] = seqEvent.data.control.value;
+                midiEvent.data[3] = 0;
                 break;
             case SND_SEQ_EVENT_CHANPRESS:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 2;
-                midiEvents[j].data[0] = 0xD0 + seqEvent.data.control.channel;
-                midiEvents[j].data[1] = seqEvent.data.control.value;
-                midiEvents[j].data[2] = 0;
-                midiEvents[j].data[3] = 0;
+                midiEvent.frame   = seqEvent.time.tick;
+                midiEvent.size    = 2;
+                midiEvent.data[0] = 0xD0 + seqEvent.data.control.channel;
+                midiEvent.data[1] = seqEvent.data.control.value;
+                midiEvent.data[2] = 0;
+                midiEvent.data[3] = 0;
                 break;
-            case SND_SEQ_EVENT_PITCHBEND:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 3;
-                midiEvents[j].data[0] = 0xE0 + seqEvent.data.control.channel;
+            case SND_SEQ_EVENT_PITCHBEND: {
+                midiEvent.frame   = seqEvent.time.tick;
+                midiEvent.size    = 3;
+                midiEvent.data[0] = 0xE0 + seqEvent.data.control.channel;
                 uint16_t tempvalue = seqEvent.data.control.value + 8192;
-                midiEvents[j].data[1] = tempvalue & 0x7F;
-                midiEvents[j].data[2] = tempvalue >> 7;
-                midiEvents[j].data[3] = 0;
+                midiEvent.data[1] = tempvalue & 0x7F;
+                midiEvent.data[2] = tempvalue >> 7;
+                midiEvent.data[3] = 0;
                 break;
             }
+            default:
+                continue;
+            }
+
+            fPlugin.addMidiEvent(midiEvent);
         }
 
-        fPlugin.run(fPortAudioIns, fPortAudioOuts, sampleCount, midiEvents, midiEventCount);
+        fPlugin.endRun();
 #else
         fPlugin.run(fPortAudioIns, fPortAudioOuts, sampleCount);
 #endif
@@ -337,12 +341,14 @@ public:
     {
         const uint32_t parameterOffset = fPlugin.getParameterOffset();
 
-        if (port > parameterOffset)
+        if (port < parameterOffset || port - parameterOffset >= fPlugin.getParameterCount())
             return DSSI_NONE;
 
-        const uint8_t midiCC = fPlugin.getParameterMidiCC(port-parameterOffset);
+        const uint32_t index  = port - parameterOffset;
+        const uint8_t  midiCC = fPlugin.getParameterMidiCC(index);
 
-        if (midiCC == 0 || midiCC == 32 || midiCC >= 0x78)
+        // only report valid controls that are not taken by an earlier parameter
+        if (fPlugin.getParameterIndexForMidiCC(0, midiCC) != static_cast<int32_t>(index))
             return DSSI_NONE;
 
         return DSSI_CC(midiCC);
@@ -377,31 +383,36 @@ private:
 
     void updateParameterOutputsAndTriggers()
     {
+        const uint32_t* const outputIndexes  = fPlugin.getOutputParameterIndexes();
+        const uint32_t* const triggerIndexes = fPlugin.getTriggerParameterIndexes();
+        const float*    const defValues      = fPlugin.getParameterDefValues();
         float value;
 
-        for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
+        for (uint32_t j=0, count=fPlugin.getOutputParameterCount(); j < count; ++j)
         {
-            if (fPlugin.isParameterOutput(i))
-            {
-                value = fLastControlValues[i] = fPlugin.getParameterValue(i);
+            const uint32_t i = outputIndexes[j];
 
-                if (fPortControls[i] != nullptr)
-                    *fPortControls[i] = value;
-            }
-            else if ((fPlugin.getParameterHints(i) & kParameterIsTrigger) == kParameterIsTrigger)
-            {
-                // NOTE: no trigger support in LADSPA control ports, simulate it here
-                value = fPlugin.getParameterRanges(i).def;
+            value = fLastControlValues[i] = fPlugin.getParameterValue(i);
 
-                if (d_isEqual(value, fPlugin.getParameterValue(i)))
-                    continue;
+            if (fPortControls[i] != nullptr)
+                *fPortControls[i] = value;
+        }
 
-                fLastControlValues[i] = value;
-                fPlugin.setParameterValue(i, value);
+        for (uint32_t j=0, count=fPlugin.getTriggerParameterCount(); j < count; ++j)
+        {
+            const uint32_t i = triggerIndexes[j];
 
-                if (fPortControls[i] != nullptr)
-                    *fPortControls[i] = value;
-            }
+            // NOTE: no trigger support in LADSPA control ports, simulate it here
+            value = defValues[i];
+
+            if (d_isEqual(value, fPlugin.getParameterValue(i)))
+                continue;
+
+            fLastControlValues[i] = value;
+            fPlugin.setParameterValue(i, value);
+
+            if (fPortControls[i] != nullptr)
+                *fPortControls[i] = value;
         }
 
 #if DISTRHO_PLUGIN_WANT_LATENCY
@@ -35,12 +35,21 @@
 # include "libmodla.h"
 #endif
 
+#if DISTRHO_PLUGIN_WANT_BINARY_STATE
+# include <cstdio>
+# include <cstdlib>
+# ifndef DISTRHO_OS_WINDOWS
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+# endif
+#endif
+
 #ifdef noexcept
 # undef noexcept
 #endif
 
-#include <map>
-
 #ifndef DISTRHO_PLUGIN_URI
 # error DISTRHO_PLUGIN_URI undefined!
 #endif
@@ -49,24 +58,51 @@
 # define DISTRHO_PLUGIN_LV2_STATE_PREFIX "urn:distrho:"
 #endif
 
+// binary states of at least this size are saved as separate files when the host supports it
+#ifndef DISTRHO_PLUGIN_LV2_STATE_FILE_THRESHOLD
+# define DISTRHO_PLUGIN_LV2_STATE_FILE_THRESHOLD (1024*1024)
+#endif
+
 #define DISTRHO_LV2_USE_EVENTS_IN  (DISTRHO_PLUGIN_WANT_MIDI_INPUT || DISTRHO_PLUGIN_WANT_TIMEPOS || (DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI))
 #define DISTRHO_LV2_USE_EVENTS_OUT (DISTRHO_PLUGIN_WANT_MIDI_OUTPUT || (DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI))
 
 START_NAMESPACE_DISTRHO
 
-typedef std::map<const String, String> StringMap;
-
 #if ! DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
-static const writeMidiFunc writeMidiCallback = nullptr;
+static const writeMidiFunc       writeMidiCallback       = nullptr;
+static const reserveMidiFunc     reserveMidiCallback     = nullptr;
+static const writeMidiEventsFunc writeMidiEventsCallback = nullptr;
 #endif
 
 // -----------------------------------------------------------------------
 
+// URIDs the run loop dispatches on
+enum UridKind {
+    kUridUnknown = 0,
+    kUridAtomObject,
+    kUridAtomDouble,
+    kUridAtomFloat,
+    kUridAtomInt,
+    kUridAtomLong,
+    kUridDistrhoState,
+    kUridMidiEvent,
+    kUridTimeBar,
+    kUridTimeBarBeat,
+    kUridTimeBeatUnit,
+    kUridTimeBeatsPerBar,
+    kUridTimeBeatsPerMinute,
+    kUridTimeTicksPerBeat,
+    kUridTimeFrame,
+    kUridTimeSpeed
+};
+
+// -----------------------------------------------------------------------
+
 class PluginLv2
 {
 public:
     PluginLv2(const double sampleRate, const LV2_URID_Map* const uridMap, const LV2_Worker_Schedule* const worker, const bool usingNominal)
-        : fPlugin(this, writeMidiCallback),
+        : fPlugin(this, writeMidiCallback, reserveMidiCallback, writeMidiEventsCallback),
           fUsingNominal(usingNominal),
 #ifdef DISTRHO_PLUGIN_LICENSED_FOR_MOD
           fRunCount(0),
@@ -112,6 +148,12 @@ public:
 #if DISTRHO_LV2_USE_EVENTS_IN
         fPortEventsIn = nullptr;
 #endif
+#if DISTRHO_PLUGIN_MIDI_THRU
+        fMidiThruEvent = nullptr;
+#endif
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+        fUnknownTimeValueCount = 0;
+#endif
 #if DISTRHO_PLUGIN_WANT_LATENCY
         fPortLatency = nullptr;
 #endif
@@ -122,17 +164,14 @@ public:
             fNeededUiSends = new bool[count];
 
             for (uint32_t i=0; i < count; ++i)
-            {
                 fNeededUiSends[i] = false;
-
-                const String& dkey(fPlugin.getStateKey(i));
-                fStateMap[dkey] = fPlugin.getStateDefaultValue(i);
-            }
         }
         else
         {
             fNeededUiSends = nullptr;
         }
+
+        fStateValues.init(fPlugin);
 #else
         // unused
         (void)fWorker;
@@ -160,7 +199,7 @@ public:
             fNeededUiSends = nullptr;
         }
 
-        fStateMap.clear();
+        fStateValues.clear();
 #endif
     }
 
@@ -169,7 +208,7 @@ public:
     void lv2_activate()
     {
 #if DISTRHO_PLUGIN_WANT_TIMEPOS
-        std::memset(&fTimePosition, 0, sizeof(TimePosition));
+        fTimePosition = TimePosition();
 
         // hosts may not send all values, resulting on some invalid data
         fTimePosition.bbt.bar   = 1;
@@ -187,6 +226,14 @@ public:
     void lv2_deactivate()
     {
         fPlugin.deactivate();
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+        if (fUnknownTimeValueCount != 0)
+        {
+            d_stderr("Got %u lv2 time position values of unknown type", fUnknownTimeValueCount);
+            fUnknownTimeValueCount = 0;
+        }
+#endif
     }
 
     // -------------------------------------------------------------------
@@ -255,30 +302,82 @@ public:
 
     void lv2_run(const uint32_t sampleCount)
     {
-        // cache midi input and time position first
+        // Check for updated parameters
+        const uint32_t* const inputIndexes = fPlugin.getInputParameterIndexes();
+        const int32_t bypassIndex = fPlugin.getBypassParameterIndex();
+        float curValue;
+
+        for (uint32_t j=0, count=fPlugin.getInputParameterCount(); j < count; ++j)
+        {
+            const uint32_t i = inputIndexes[j];
+
+            if (fPortControls[i] == nullptr)
+                continue;
+
+            curValue = *fPortControls[i];
+
+            if (d_isNotEqual(fLastControlValues[i], curValue))
+            {
+                fLastControlValues[i] = curValue;
+
+                if (static_cast<int32_t>(i) == bypassIndex)
+                    curValue = 1.0f - curValue;
+
+                fPlugin.setParameterValue(i, curValue);
+            }
+        }
+
+#if DISTRHO_PLUGIN_MIDI_THRU
+        // input is forwarded lazily, merged with whatever the plugin writes
+        fMidiThruEvent = lv2_atom_sequence_begin(&fPortEventsIn->body);
+#endif
+
+        // Run plugin
+        if (sampleCount != 0)
+        {
+#ifdef DISTRHO_PLUGIN_LICENSED_FOR_MOD
+            fRunCount = mod_license_run_begin(fRunCount, sampleCount);
+#endif
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-        uint32_t midiEventCount = 0;
+            fPlugin.beginRun(fPortAudioIns, fPortAudioOuts, sampleCount);
 #endif
+        }
 
-#if DISTRHO_PLUGIN_WANT_MIDI_INPUT || DISTRHO_PLUGIN_WANT_TIMEPOS
+#if DISTRHO_LV2_USE_EVENTS_IN
+        // single pass over input events, MIDI is streamed to the plugin while it runs
         LV2_ATOM_SEQUENCE_FOREACH(fPortEventsIn, event)
         {
             if (event == nullptr)
                 break;
 
-# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-            if (event->body.type == fURIDs.midiEvent)
+            switch (fURIDs.getKind(event->body.type))
             {
-                if (midiEventCount >= kMaxMidiEvents)
-                    continue;
+# if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+            case kUridMidiEvent: {
+                if (sampleCount == 0)
+                    break;
 
                 const uint8_t* const data((const uint8_t*)(event + 1));
 
-                MidiEvent& midiEvent(fMidiEvents[midiEventCount++]);
-
+                MidiEvent midiEvent;
                 midiEvent.frame = event->time.frames;
                 midiEvent.size  = event->body.size;
 
+#  if DISTRHO_PLUGIN_WANT_SAMPLE_ACCURATE_PARAMETERS
+                // control change mapped to a parameter, applied at its own frame
+                if (midiEvent.size == 3 && (data[0] & 0xF0) == 0xB0)
+                {
+                    const int32_t index = fPlugin.getParameterIndexForMidiCC(data[0] & 0x0F, data[1]);
+
+                    if (index >= 0)
+                    {
+                        const uint32_t j = static_cast<uint32_t>(index);
+                        const float scaled = static_cast<float>(data[2])/127.0f;
+                        fPlugin.addParameterChange(j, fPlugin.getParameterRanges(j).getUnnormalizedValue(scaled), midiEvent.frame);
+                    }
+                }
+#  endif
+
                 if (midiEvent.size > MidiEvent::kDataSize)
                 {
                     midiEvent.dataExt = data;
@@ -290,255 +389,50 @@ public:
                     std::memcpy(midiEvent.data, data, midiEvent.size);
                 }
 
-                continue;
+                fPlugin.addMidiEvent(midiEvent);
+                break;
             }
 # endif
 # if DISTRHO_PLUGIN_WANT_TIMEPOS
-            if (event->body.type == fURIDs.atomBlank || event->body.type == fURIDs.atomObject)
-            {
+            case kUridAtomObject: {
                 const LV2_Atom_Object* const obj((const LV2_Atom_Object*)&event->body);
 
-                if (obj->body.otype != fURIDs.timePosition)
-                    continue;
-
-                LV2_Atom* bar     = nullptr;
-                LV2_Atom* barBeat = nullptr;
-                LV2_Atom* beatUnit = nullptr;
-                LV2_Atom* beatsPerBar = nullptr;
-                LV2_Atom* beatsPerMinute = nullptr;
-                LV2_Atom* frame = nullptr;
-                LV2_Atom* speed = nullptr;
-                LV2_Atom* ticksPerBeat = nullptr;
-
-                lv2_atom_object_get(obj,
-                                    fURIDs.timeBar, &bar,
-                                    fURIDs.timeBarBeat, &barBeat,
-                                    fURIDs.timeBeatUnit, &beatUnit,
-                                    fURIDs.timeBeatsPerBar, &beatsPerBar,
-                                    fURIDs.timeBeatsPerMinute, &beatsPerMinute,
-                                    fURIDs.timeFrame, &frame,
-                                    fURIDs.timeSpeed, &speed,
-                                    fURIDs.timeTicksPerBeat, &ticksPerBeat,
-                                    0);
-
-                // need to handle this first as other values depend on it
-                if (ticksPerBeat != nullptr)
-                {
-                    /**/ if (ticksPerBeat->type == fURIDs.atomDouble)
-                        fLastPositionData.ticksPerBeat = ((LV2_Atom_Double*)ticksPerBeat)->body;
-                    else if (ticksPerBeat->type == fURIDs.atomFloat)
-                        fLastPositionData.ticksPerBeat = ((LV2_Atom_Float*)ticksPerBeat)->body;
-                    else if (ticksPerBeat->type == fURIDs.atomInt)
-                        fLastPositionData.ticksPerBeat = ((LV2_Atom_Int*)ticksPerBeat)->body;
-                    else if (ticksPerBeat->type == fURIDs.atomLong)
-                        fLastPositionData.ticksPerBeat = ((LV2_Atom_Long*)ticksPerBeat)->body;
-                    else
-                        d_stderr("Unknown lv2 ticksPerBeat value type");
-
-                    if (fLastPositionData.ticksPerBeat > 0.0)
-                        fTimePosition.bbt.ticksPerBeat = fLastPositionData.ticksPerBeat;
-                }
-
-                // same
-                if (speed != nullptr)
-                {
-                    /**/ if (speed->type == fURIDs.atomDouble)
-                        fLastPositionData.speed = ((LV2_Atom_Double*)speed)->body;
-                    else if (speed->type == fURIDs.atomFloat)
-                        fLastPositionData.speed = ((LV2_Atom_Float*)speed)->body;
-                    else if (speed->type == fURIDs.atomInt)
-                        fLastPositionData.speed = ((LV2_Atom_Int*)speed)->body;
-                    else if (speed->type == fURIDs.atomLong)
-                        fLastPositionData.speed = ((LV2_Atom_Long*)speed)->body;
-                    else
-                        d_stderr("Unknown lv2 speed value type");
-
-                    fTimePosition.playing = d_isNotZero(fLastPositionData.speed);
-                }
-
-                if (bar != nullptr)
-                {
-                    /**/ if (bar->type == fURIDs.atomDouble)
-                        fLastPositionData.bar = ((LV2_Atom_Double*)bar)->body;
-                    else if (bar->type == fURIDs.atomFloat)
-                        fLastPositionData.bar = ((LV2_Atom_Float*)bar)->body;
-                    else if (bar->type == fURIDs.atomInt)
-                        fLastPositionData.bar = ((LV2_Atom_Int*)bar)->body;
-                    else if (bar->type == fURIDs.atomLong)
-                        fLastPositionData.bar = ((LV2_Atom_Long*)bar)->body;
-                    else
-                        d_stderr("Unknown lv2 bar value type");
-
-                    if (fLastPositionData.bar >= 0)
-                        fTimePosition.bbt.bar = fLastPositionData.bar + 1;
-                }
-
-                if (barBeat != nullptr)
-                {
-                    /**/ if (barBeat->type == fURIDs.atomDouble)
-                        fLastPositionData.barBeat = ((LV2_Atom_Double*)barBeat)->body;
-                    else if (barBeat->type == fURIDs.atomFloat)
-                        fLastPositionData.barBeat = ((LV2_Atom_Float*)barBeat)->body;
-                    else if (barBeat->type == fURIDs.atomInt)
-                        fLastPositionData.barBeat = ((LV2_Atom_Int*)barBeat)->body;
-                    else if (barBeat->type == fURIDs.atomLong)
-                        fLastPositionData.barBeat = ((LV2_Atom_Long*)barBeat)->body;
-                    else
-                        d_stderr("Unknown lv2 barBeat value type");
-
-                    if (fLastPositionData.barBeat >= 0.0f)
-                    {
-                        const double rest = std::fmod(fLastPositionData.barBeat, 1.0f);
-                        fTimePosition.bbt.beat = std::round(fLastPositionData.barBeat-rest+1.0);
-                        fTimePosition.bbt.tick = rest*fTimePosition.bbt.ticksPerBeat+0.5;
-                    }
-                }
-
-                if (beatUnit != nullptr)
-                {
-                    /**/ if (beatUnit->type == fURIDs.atomDouble)
-                        fLastPositionData.beatUnit = ((LV2_Atom_Double*)beatUnit)->body;
-                    else if (beatUnit->type == fURIDs.atomFloat)
-                        fLastPositionData.beatUnit = ((LV2_Atom_Float*)beatUnit)->body;
-                    else if (beatUnit->type == fURIDs.atomInt)
-                        fLastPositionData.beatUnit = ((LV2_Atom_Int*)beatUnit)->body;
-                    else if (beatUnit->type == fURIDs.atomLong)
-                        fLastPositionData.beatUnit = ((LV2_Atom_Long*)beatUnit)->body;
-                    else
-                        d_stderr("Unknown lv2 beatUnit value type");
-
-                    if (fLastPositionData.beatUnit > 0)
-                        fTimePosition.bbt.beatType = fLastPositionData.beatUnit;
-                }
-
-                if (beatsPerBar != nullptr)
-                {
-                    /**/ if (beatsPerBar->type == fURIDs.atomDouble)
-                        fLastPositionData.beatsPerBar = ((LV2_Atom_Double*)beatsPerBar)->body;
-                    else if (beatsPerBar->type == fURIDs.atomFloat)
-                        fLastPositionData.beatsPerBar = ((LV2_Atom_Float*)beatsPerBar)->body;
-                    else if (beatsPerBar->type == fURIDs.atomInt)
-                        fLastPositionData.beatsPerBar = ((LV2_Atom_Int*)beatsPerBar)->body;
-                    else if (beatsPerBar->type == fURIDs.atomLong)
-                        fLastPositionData.beatsPerBar = ((LV2_Atom_Long*)beatsPerBar)->body;
-                    else
-                        d_stderr("Unknown lv2 beatsPerBar value type");
-
-                    if (fLastPositionData.beatsPerBar > 0.0f)
-                        fTimePosition.bbt.beatsPerBar = fLastPositionData.beatsPerBar;
-                }
-
-                if (beatsPerMinute != nullptr)
-                {
-                    /**/ if (beatsPerMinute->type == fURIDs.atomDouble)
-                        fLastPositionData.beatsPerMinute = ((LV2_Atom_Double*)beatsPerMinute)->body;
-                    else if (beatsPerMinute->type == fURIDs.atomFloat)
-                        fLastPositionData.beatsPerMinute = ((LV2_Atom_Float*)beatsPerMinute)->body;
-                    else if (beatsPerMinute->type == fURIDs.atomInt)
-                        fLastPositionData.beatsPerMinute = ((LV2_Atom_Int*)beatsPerMinute)->body;
-                    else if (beatsPerMinute->type == fURIDs.atomLong)
-                        fLastPositionData.beatsPerMinute = ((LV2_Atom_Long*)beatsPerMinute)->body;
-                    else
-                        d_stderr("Unknown lv2 beatsPerMinute value type");
-
-                    if (fLastPositionData.beatsPerMinute > 0.0f)
-                    {
-                        fTimePosition.bbt.beatsPerMinute = fLastPositionData.beatsPerMinute;
-
-                        if (d_isNotZero(fLastPositionData.speed))
-                            fTimePosition.bbt.beatsPerMinute *= std::abs(fLastPositionData.speed);
-                    }
-                }
-
-                if (frame != nullptr)
-                {
-                    /**/ if (frame->type == fURIDs.atomDouble)
-                        fLastPositionData.frame = ((LV2_Atom_Double*)frame)->body;
-                    else if (frame->type == fURIDs.atomFloat)
-                        fLastPositionData.frame = ((LV2_Atom_Float*)frame)->body;
-                    else if (frame->type == fURIDs.atomInt)
-                        fLastPositionData.frame = ((LV2_Atom_Int*)frame)->body;
-                    else if (frame->type == fURIDs.atomLong)
-                        fLastPositionData.frame = ((LV2_Atom_Long*)frame)->body;
-                    else
-                        d_stderr("Unknown lv2 frame value type");
-
-                    if (fLastPositionData.frame >= 0)
-                        fTimePosition.frame = fLastPositionData.frame;
-                }
-
-                fTimePosition.bbt.barStartTick = fTimePosition.bbt.ticksPerBeat*
-                                                 fTimePosition.bbt.beatsPerBar*
-                                                 (fTimePosition.bbt.bar-1);
-
-                fTimePosition.bbt.valid = (fLastPositionData.beatsPerMinute > 0.0 &&
-                                           fLastPositionData.beatUnit > 0 &&
-                                           fLastPositionData.beatsPerBar > 0.0f);
-
-                fPlugin.setTimePosition(fTimePosition);
-
-                continue;
+                if (obj->body.otype == fURIDs.timePosition)
+                    readTimePosition(obj);
+                break;
             }
 # endif
-        }
-#endif
-
-        // check for messages from UI
-#if DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI
-        LV2_ATOM_SEQUENCE_FOREACH(fPortEventsIn, event)
-        {
-            if (event == nullptr)
-                break;
+# if DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI
+            case kUridDistrhoState: {
+                if (fWorker == nullptr)
+                    break;
 
-            if (event->body.type == fURIDs.distrhoState && fWorker != nullptr)
-            {
                 const void* const data((const void*)(event + 1));
 
                 // check if this is our special message
                 if (std::strcmp((const char*)data, "__dpf_ui_data__") == 0)
                 {
                     for (uint32_t i=0, count=fPlugin.getStateCount(); i < count; ++i)
-                        fNeededUiSends[i] = true;
+                        fNeededUiSends[i] = ! fPlugin.isStateBinary(i);
                 }
                 else
                 // no, send to DSP as usual
                 {
                     fWorker->schedule_work(fWorker->handle, event->body.size, data);
                 }
+                break;
             }
-        }
-#endif
-
-        // Check for updated parameters
-        float curValue;
-
-        for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
-        {
-            if (fPortControls[i] == nullptr)
-                continue;
-
-            curValue = *fPortControls[i];
-
-            if (fPlugin.isParameterInput(i) && d_isNotEqual(fLastControlValues[i], curValue))
-            {
-                fLastControlValues[i] = curValue;
-
-                if (fPlugin.getParameterDesignation(i) == kParameterDesignationBypass)
-                    curValue = 1.0f - curValue;
-
-                fPlugin.setParameterValue(i, curValue);
+# endif
+            default:
+                break;
             }
         }
+#endif
 
-        // Run plugin
         if (sampleCount != 0)
         {
-#ifdef DISTRHO_PLUGIN_LICENSED_FOR_MOD
-            fRunCount = mod_license_run_begin(fRunCount, sampleCount);
-#endif
-
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-            fPlugin.run(fPortAudioIns, fPortAudioOuts, sampleCount, fMidiEvents, midiEventCount);
+            fPlugin.endRun();
 #else
             fPlugin.run(fPortAudioIns, fPortAudioOuts, sampleCount);
 #endif
@@ -607,6 +501,11 @@ public:
 #endif
         }
 
+#if DISTRHO_PLUGIN_MIDI_THRU
+        flushMidiThru(UINT32_MAX);
+        fMidiThruEvent = nullptr;
+#endif
+
         updateParameterOutputsAndTriggers();
 
 #if DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI
@@ -620,47 +519,33 @@ public:
             if (! fNeededUiSends[i])
                 continue;
 
-            const String& key = fPlugin.getStateKey(i);
-
-            for (StringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
-            {
-                const String& curKey = cit->first;
-
-                if (curKey != key)
-                    continue;
-
-                const String& value = cit->second;
-
-                // set msg size (key + value + separator + 2x null terminator)
-                const size_t msgSize(key.length()+value.length()+3);
+            const String&  key(fPlugin.getStateKey(i));
+            const uint32_t keyLength   = static_cast<uint32_t>(key.length());
+            const uint32_t valueLength = fStateValues.getLength(i);
 
-                if (sizeof(LV2_Atom_Event) + msgSize > capacity - fEventsOutData.offset)
-                {
-                    d_stdout("Sending key '%s' to UI failed, out of space", key.buffer());
-                    break;
-                }
+            // set msg size (key + value + separator + 2x null terminator)
+            const uint32_t msgSize = keyLength + valueLength + 3;
 
-                // reserve msg space
-                // FIXME create a large enough buffer beforehand
-                char msgBuf[msgSize];
-                std::memset(msgBuf, 0, msgSize);
+            if (sizeof(LV2_Atom_Event) + msgSize > capacity - fEventsOutData.offset)
+            {
+                d_stdout("Sending key '%s' to UI failed, out of space", key.buffer());
+                break;
+            }
 
-                // write key and value in atom bufer
-                std::memcpy(msgBuf, key.buffer(), key.length()+1);
-                std::memcpy(msgBuf+(key.length()+1), value.buffer(), value.length()+1);
+            // write key and value straight into the atom buffer
+            aev = (LV2_Atom_Event*)(LV2_ATOM_CONTENTS(LV2_Atom_Sequence, fEventsOutData.port) + fEventsOutData.offset);
+            aev->time.frames = 0;
+            aev->body.type   = fURIDs.distrhoState;
+            aev->body.size   = msgSize;
 
-                // put data
-                aev = (LV2_Atom_Event*)(LV2_ATOM_CONTENTS(LV2_Atom_Sequence, fEventsOutData.port) + fEventsOutData.offset);
-                aev->time.frames = 0;
-                aev->body.type   = fURIDs.distrhoState;
-                aev->body.size   = msgSize;
-                std::memcpy(LV2_ATOM_BODY(&aev->body), msgBuf, msgSize);
+            char* const msg = (char*)LV2_ATOM_BODY(&aev->body);
+            std::memcpy(msg, key.buffer(), keyLength+1);
+            std::memcpy(msg+keyLength+1, fStateValues.get(i), valueLength+1);
+            msg[msgSize-1] = '\0';
 
-                fEventsOutData.growBy(lv2_atom_pad_size(sizeof(LV2_Atom_Event) + msgSize));
+            fEventsOutData.growBy(lv2_atom_pad_size(sizeof(LV2_Atom_Event) + msgSize));
 
-                fNeededUiSends[i] = false;
-                break;
-            }
+            fNeededUiSends[i] = false;
         }
 #endif
 
@@ -763,11 +648,7 @@ public:
 
 # if DISTRHO_PLUGIN_WANT_FULL_STATE
         // Update state
-        for (StringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
-        {
-            const String& key = cit->first;
-            fStateMap[key] = fPlugin.getState(key);
-        }
+        updateStateValues();
 # endif
     }
 #endif
@@ -775,36 +656,65 @@ public:
     // -------------------------------------------------------------------
 
 #if DISTRHO_PLUGIN_WANT_STATE
-    LV2_State_Status lv2_save(const LV2_State_Store_Function store, const LV2_State_Handle handle)
+    LV2_State_Status lv2_save(const LV2_State_Store_Function store, const LV2_State_Handle handle, const LV2_Feature* const* const features)
     {
 # if DISTRHO_PLUGIN_WANT_FULL_STATE
         // Update current state
-        for (StringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
+        updateStateValues();
+# endif
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+        const LV2_State_Make_Path* makePath = nullptr;
+        const LV2_State_Map_Path*  mapPath  = nullptr;
+
+        for (int i=0; features != nullptr && features[i] != nullptr; ++i)
         {
-            const String& key = cit->first;
-            fStateMap[key] = fPlugin.getState(key);
+            if (std::strcmp(features[i]->URI, LV2_STATE__makePath) == 0)
+                makePath = (const LV2_State_Make_Path*)features[i]->data;
+            else if (std::strcmp(features[i]->URI, LV2_STATE__mapPath) == 0)
+                mapPath = (const LV2_State_Map_Path*)features[i]->data;
         }
+# else
+        // unused
+        (void)features;
 # endif
 
-        for (StringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
+        for (uint32_t i=0, count=fStateValues.getCount(); i < count; ++i)
         {
-            const String& key   = cit->first;
-            const String& value = cit->second;
+            const String urnKey(DISTRHO_PLUGIN_LV2_STATE_PREFIX + fPlugin.getStateKey(i));
 
-            const String urnKey(DISTRHO_PLUGIN_LV2_STATE_PREFIX + key);
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+            if (fPlugin.isStateBinary(i))
+            {
+                saveBinaryState(store, handle, fUridMap->map(fUridMap->handle, urnKey.buffer()), i, makePath, mapPath);
+                continue;
+            }
+# endif
 
             // some hosts need +1 for the null terminator, even though the type is string
-            store(handle, fUridMap->map(fUridMap->handle, urnKey.buffer()), value.buffer(), value.length()+1, fURIDs.atomString, LV2_STATE_IS_POD|LV2_STATE_IS_PORTABLE);
+            store(handle, fUridMap->map(fUridMap->handle, urnKey.buffer()), fStateValues.get(i), fStateValues.getLength(i)+1, fURIDs.atomString, LV2_STATE_IS_POD|LV2_STATE_IS_PORTABLE);
         }
 
         return LV2_STATE_SUCCESS;
     }
 
-    LV2_State_Status lv2_restore(const LV2_State_Retrieve_Function retrieve, const LV2_State_Handle handle)
+    LV2_State_Status lv2_restore(const LV2_State_Retrieve_Function retrieve, const LV2_State_Handle handle, const LV2_Feature* const* const features)
     {
         size_t   size;
         uint32_t type, flags;
 
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+        const LV2_State_Map_Path* mapPath = nullptr;
+
+        for (int i=0; features != nullptr && features[i] != nullptr; ++i)
+        {
+            if (std::strcmp(features[i]->URI, LV2_STATE__mapPath) == 0)
+                mapPath = (const LV2_State_Map_Path*)features[i]->data;
+        }
+# else
+        // unused
+        (void)features;
+# endif
+
         for (uint32_t i=0, count=fPlugin.getStateCount(); i < count; ++i)
         {
             const String& key(fPlugin.getStateKey(i));
@@ -815,6 +725,15 @@ public:
             flags = LV2_STATE_IS_POD|LV2_STATE_IS_PORTABLE;
             const void* data = retrieve(handle, fUridMap->map(fUridMap->handle, urnKey.buffer()), &size, &type, &flags);
 
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+            if (fPlugin.isStateBinary(i))
+            {
+                if (data != nullptr)
+                    restoreBinaryState(key, data, size, type, mapPath);
+                continue;
+            }
+# endif
+
             if (data == nullptr || size == 0)
                 continue;
 
@@ -824,7 +743,8 @@ public:
             const std::size_t length(std::strlen(value));
             DISTRHO_SAFE_ASSERT_CONTINUE(length == size || length+1 == size);
 
-            setState(key, value);
+            fPlugin.setState(key, value);
+            fStateValues.set(i, value, static_cast<uint32_t>(length));
 
 #if DISTRHO_LV2_USE_EVENTS_OUT
             // signal msg needed for UI
@@ -882,6 +802,9 @@ private:
 #if DISTRHO_LV2_USE_EVENTS_IN
     LV2_Atom_Sequence* fPortEventsIn;
 #endif
+#if DISTRHO_PLUGIN_MIDI_THRU
+    const LV2_Atom_Event* fMidiThruEvent; // next input event to forward
+#endif
 #if DISTRHO_PLUGIN_WANT_LATENCY
     float* fPortLatency;
 #endif
@@ -889,9 +812,6 @@ private:
     // Temporary data
     float* fLastControlValues;
     double fSampleRate;
-#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-    MidiEvent fMidiEvents[kMaxMidiEvents];
-#endif
 #if DISTRHO_PLUGIN_WANT_TIMEPOS
     TimePosition fTimePosition;
 
@@ -916,6 +836,145 @@ private:
               ticksPerBeat(-1.0) {}
 
     } fLastPositionData;
+    uint32_t fUnknownTimeValueCount;
+
+    // Read a time:Position object in one walk over its properties
+    void readTimePosition(const LV2_Atom_Object* const obj) noexcept
+    {
+        const LV2_Atom* bar            = nullptr;
+        const LV2_Atom* barBeat        = nullptr;
+        const LV2_Atom* beatUnit       = nullptr;
+        const LV2_Atom* beatsPerBar    = nullptr;
+        const LV2_Atom* beatsPerMinute = nullptr;
+        const LV2_Atom* frame          = nullptr;
+        const LV2_Atom* speed          = nullptr;
+        const LV2_Atom* ticksPerBeat   = nullptr;
+
+        LV2_ATOM_OBJECT_FOREACH(obj, prop)
+        {
+            switch (fURIDs.getKind(prop->key))
+            {
+            case kUridTimeBar:            bar            = &prop->value; break;
+            case kUridTimeBarBeat:        barBeat        = &prop->value; break;
+            case kUridTimeBeatUnit:       beatUnit       = &prop->value; break;
+            case kUridTimeBeatsPerBar:    beatsPerBar    = &prop->value; break;
+            case kUridTimeBeatsPerMinute: beatsPerMinute = &prop->value; break;
+            case kUridTimeFrame:          frame          = &prop->value; break;
+            case kUridTimeSpeed:          speed          = &prop->value; break;
+            case kUridTimeTicksPerBeat:   ticksPerBeat   = &prop->value; break;
+            default: break;
+            }
+        }
+
+        // need to handle this first as other values depend on it
+        if (ticksPerBeat != nullptr)
+        {
+            readAtomNumber(ticksPerBeat, fLastPositionData.ticksPerBeat);
+
+            if (fLastPositionData.ticksPerBeat > 0.0)
+                fTimePosition.bbt.ticksPerBeat = fLastPositionData.ticksPerBeat;
+        }
+
+        // same
+        if (speed != nullptr)
+        {
+            readAtomNumber(speed, fLastPositionData.speed);
+
+            fTimePosition.playing = d_isNotZero(fLastPositionData.speed);
+        }
+
+        if (bar != nullptr)
+        {
+            readAtomNumber(bar, fLastPositionData.bar);
+
+            if (fLastPositionData.bar >= 0)
+                fTimePosition.bbt.bar = fLastPositionData.bar + 1;
+        }
+
+        if (barBeat != nullptr)
+        {
+            readAtomNumber(barBeat, fLastPositionData.barBeat);
+
+            if (fLastPositionData.barBeat >= 0.0f)
+            {
+                const double rest = std::fmod(fLastPositionData.barBeat, 1.0f);
+                fTimePosition.bbt.beat = std::round(fLastPositionData.barBeat-rest+1.0);
+                fTimePosition.bbt.tick = rest*fTimePosition.bbt.ticksPerBeat+0.5;
+            }
+        }
+
+        if (beatUnit != nullptr)
+        {
+            readAtomNumber(beatUnit, fLastPositionData.beatUnit);
+
+            if (fLastPositionData.beatUnit > 0)
+                fTimePosition.bbt.beatType = fLastPositionData.beatUnit;
+        }
+
+        if (beatsPerBar != nullptr)
+        {
+            readAtomNumber(beatsPerBar, fLastPositionData.beatsPerBar);
+
+            if (fLastPositionData.beatsPerBar > 0.0f)
+                fTimePosition.bbt.beatsPerBar = fLastPositionData.beatsPerBar;
+        }
+
+        if (beatsPerMinute != nullptr)
+        {
+            readAtomNumber(beatsPerMinute, fLastPositionData.beatsPerMinute);
+
+            if (fLastPositionData.beatsPerMinute > 0.0f)
+            {
+                fTimePosition.bbt.beatsPerMinute = fLastPositionData.beatsPerMinute;
+
+                if (d_isNotZero(fLastPositionData.speed))
+                    fTimePosition.bbt.beatsPerMinute *= std::abs(fLastPositionData.speed);
+            }
+        }
+
+        if (frame != nullptr)
+        {
+            readAtomNumber(frame, fLastPositionData.frame);
+
+            if (fLastPositionData.frame >= 0)
+                fTimePosition.frame = fLastPositionData.frame;
+        }
+
+        fTimePosition.bbt.barStartTick = fTimePosition.bbt.ticksPerBeat*
+                                         fTimePosition.bbt.beatsPerBar*
+                                         (fTimePosition.bbt.bar-1);
+
+        fTimePosition.bbt.valid = (fLastPositionData.beatsPerMinute > 0.0 &&
+                                   fLastPositionData.beatUnit > 0 &&
+                                   fLastPositionData.beatsPerBar > 0.0f);
+
+        fPlugin.setTimePosition(fTimePosition);
+    }
+
+    // Read any numeric atom into @a value, leaving it untouched for other types
+    template <typename T>
+    void readAtomNumber(const LV2_Atom* const atom, T& value) noexcept
+    {
+        switch (fURIDs.getKind(atom->type))
+        {
+        case kUridAtomDouble:
+            value = static_cast<T>(((const LV2_Atom_Double*)atom)->body);
+            break;
+        case kUridAtomFloat:
+            value = static_cast<T>(((const LV2_Atom_Float*)atom)->body);
+            break;
+        case kUridAtomInt:
+            value = static_cast<T>(((const LV2_Atom_Int*)atom)->body);
+            break;
+        case kUridAtomLong:
+            value = static_cast<T>(((const LV2_Atom_Long*)atom)->body);
+            break;
+        default:
+            // reported later from lv2_deactivate, never print from the audio thread
+            ++fUnknownTimeValueCount;
+            break;
+        }
+    }
 #endif
 
 #if DISTRHO_LV2_USE_EVENTS_OUT
@@ -964,6 +1023,8 @@ private:
         LV2_URID atomFloat;
         LV2_URID atomInt;
         LV2_URID atomLong;
+        LV2_URID atomChunk;
+        LV2_URID atomPath;
         LV2_URID atomSequence;
         LV2_URID atomString;
         LV2_URID distrhoState;
@@ -985,6 +1046,8 @@ private:
               atomFloat(uridMap->map(uridMap->handle, LV2_ATOM__Float)),
               atomInt(uridMap->map(uridMap->handle, LV2_ATOM__Int)),
               atomLong(uridMap->map(uridMap->handle, LV2_ATOM__Long)),
+              atomChunk(uridMap->map(uridMap->handle, LV2_ATOM__Chunk)),
+              atomPath(uridMap->map(uridMap->handle, LV2_ATOM__Path)),
               atomSequence(uridMap->map(uridMap->handle, LV2_ATOM__Sequence)),
               atomString(uridMap->map(uridMap->handle, LV2_ATOM__String)),
               distrhoState(uridMap->map(uridMap->handle, DISTRHO_PLUGIN_LV2_STATE_PREFIX "KeyValueState")),
@@ -997,7 +1060,62 @@ private:
               timeBeatsPerMinute(uridMap->map(uridMap->handle, LV2_TIME__beatsPerMinute)),
               timeTicksPerBeat(uridMap->map(uridMap->handle, LV2_KXSTUDIO_PROPERTIES__TimePositionTicksPerBeat)),
               timeFrame(uridMap->map(uridMap->handle, LV2_TIME__frame)),
-              timeSpeed(uridMap->map(uridMap->handle, LV2_TIME__speed)) {}
+              timeSpeed(uridMap->map(uridMap->handle, LV2_TIME__speed))
+        {
+            std::memset(kinds, 0, sizeof(kinds));
+
+            addKind(atomBlank, kUridAtomObject);
+            addKind(atomObject, kUridAtomObject);
+            addKind(atomDouble, kUridAtomDouble);
+            addKind(atomFloat, kUridAtomFloat);
+            addKind(atomInt, kUridAtomInt);
+            addKind(atomLong, kUridAtomLong);
+            addKind(distrhoState, kUridDistrhoState);
+            addKind(midiEvent, kUridMidiEvent);
+            addKind(timeBar, kUridTimeBar);
+            addKind(timeBarBeat, kUridTimeBarBeat);
+            addKind(timeBeatUnit, kUridTimeBeatUnit);
+            addKind(timeBeatsPerBar, kUridTimeBeatsPerBar);
+            addKind(timeBeatsPerMinute, kUridTimeBeatsPerMinute);
+            addKind(timeTicksPerBeat, kUridTimeTicksPerBeat);
+            addKind(timeFrame, kUridTimeFrame);
+            addKind(timeSpeed, kUridTimeSpeed);
+        }
+
+        // What a URID means to us, one probe for the common case of small sequential URIDs
+        UridKind getKind(const LV2_URID urid) const noexcept
+        {
+            for (uint32_t i = urid & (kKindsSize-1);; i = (i + 1) & (kKindsSize-1))
+            {
+                if (kinds[i].urid == urid)
+                    return static_cast<UridKind>(kinds[i].kind);
+                if (kinds[i].urid == 0)
+                    return kUridUnknown;
+            }
+        }
+
+    private:
+        // open addressing keyed by the URID itself, 0 is never a valid URID and marks empty slots
+        static const uint32_t kKindsSize = 64;
+
+        struct {
+            LV2_URID urid;
+            uint32_t kind;
+        } kinds[kKindsSize];
+
+        void addKind(const LV2_URID urid, const UridKind kind) noexcept
+        {
+            if (urid == 0)
+                return;
+
+            uint32_t i = urid & (kKindsSize-1);
+
+            while (kinds[i].urid != 0 && kinds[i].urid != urid)
+                i = (i + 1) & (kKindsSize-1);
+
+            kinds[i].urid = urid;
+            kinds[i].kind = kind;
+        }
     } fURIDs;
 
     // LV2 features
@@ -1005,52 +1123,191 @@ private:
     const LV2_Worker_Schedule* const fWorker;
 
 #if DISTRHO_PLUGIN_WANT_STATE
-    StringMap fStateMap;
+    PluginStateValues fStateValues;
     bool* fNeededUiSends;
 
     void setState(const char* const key, const char* const newValue)
     {
         fPlugin.setState(key, newValue);
 
-        // check if we want to save this key
-        if (! fPlugin.wantStateKey(key))
-            return;
+        // only keys the plugin declared are saved
+        const int32_t index = fPlugin.getStateIndex(key);
 
-        // check if key already exists
-        for (StringMap::iterator it=fStateMap.begin(), ite=fStateMap.end(); it != ite; ++it)
+        if (index >= 0)
+            fStateValues.set(static_cast<uint32_t>(index), newValue);
+    }
+
+# if DISTRHO_PLUGIN_WANT_FULL_STATE
+    void updateStateValues()
+    {
+        for (uint32_t i=0, count=fStateValues.getCount(); i < count; ++i)
         {
-            const String& dkey(it->first);
+            if (fPlugin.isStateBinary(i))
+                continue;
+
+            const String value(fPlugin.getState(fPlugin.getStateKey(i)));
+            fStateValues.set(i, value.buffer(), static_cast<uint32_t>(value.length()));
+        }
+    }
+# endif
+
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+    // Binary states are stored as atom:Chunk, or as a file reference once they are big enough.
+    // Either way the plugin data is handed to the host as is, without any encoding.
+    void saveBinaryState(const LV2_State_Store_Function store, const LV2_State_Handle handle, const LV2_URID urid, const uint32_t index,
+                         const LV2_State_Make_Path* const makePath, const LV2_State_Map_Path* const mapPath)
+    {
+        const String& key(fPlugin.getStateKey(index));
+
+        const void* data;
+        size_t size;
+        fPlugin.getBinaryState(key, data, size);
 
-            if (dkey == key)
+        if (size >= DISTRHO_PLUGIN_LV2_STATE_FILE_THRESHOLD && makePath != nullptr && mapPath != nullptr)
+        {
+            if (char* const abstractPath = writeBinaryStateFile(index, data, size, makePath, mapPath))
             {
-                it->second = newValue;
+                store(handle, urid, abstractPath, std::strlen(abstractPath)+1, fURIDs.atomPath, LV2_STATE_IS_POD);
+                std::free(abstractPath);
                 return;
             }
         }
 
-        d_stderr("Failed to find plugin state with key \"%s\"", key);
+        store(handle, urid, data != nullptr ? data : "", size, fURIDs.atomChunk, LV2_STATE_IS_POD|LV2_STATE_IS_PORTABLE);
     }
-#endif
 
-    void updateParameterOutputsAndTriggers()
+    // Returns the abstract path of the new file, to be freed by the caller, or null on failure.
+    char* writeBinaryStateFile(const uint32_t index, const void* const data, const size_t size,
+                               const LV2_State_Make_Path* const makePath, const LV2_State_Map_Path* const mapPath)
     {
-        float curValue;
+        // state index keeps names unique, keys can contain characters we do not want in filenames
+        String filename(index);
+        filename += "-";
+        filename += String(fPlugin.getStateKey(index)).toBasic();
+        filename += ".bin";
 
-        for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
+        char* const path = makePath->path(makePath->handle, filename);
+        DISTRHO_SAFE_ASSERT_RETURN(path != nullptr, nullptr);
+
+        bool ok = false;
+
+        if (FILE* const file = std::fopen(path, "wb"))
         {
-            if (fPlugin.isParameterOutput(i))
+            ok = std::fwrite(data, 1, size, file) == size;
+            ok = (std::fclose(file) == 0) && ok;
+        }
+
+        char* const abstractPath = ok ? mapPath->abstract_path(mapPath->handle, path) : nullptr;
+
+        if (! ok)
+            d_stderr2("Failed to write state file '%s'", path);
+
+        std::free(path);
+        return abstractPath;
+    }
+
+    void restoreBinaryState(const char* const key, const void* const data, const size_t size, const uint32_t type,
+                            const LV2_State_Map_Path* const mapPath)
+    {
+        if (type == fURIDs.atomChunk)
+        {
+            // pass the host memory straight to the plugin
+            fPlugin.setBinaryState(key, data, size);
+            return;
+        }
+
+        DISTRHO_SAFE_ASSERT_RETURN(type == fURIDs.atomPath,);
+        DISTRHO_SAFE_ASSERT_RETURN(size != 0 && ((const char*)data)[size-1] == '\0',);
+
+        const char* const abstractPath((const char*)data);
+        char* const path = mapPath != nullptr ? mapPath->absolute_path(mapPath->handle, abstractPath) : nullptr;
+
+        readBinaryStateFile(key, path != nullptr ? path : abstractPath);
+
+        std::free(path);
+    }
+
+    void readBinaryStateFile(const char* const key, const char* const path)
+    {
+#  ifdef DISTRHO_OS_WINDOWS
+        FILE* const file = std::fopen(path, "rb");
+        DISTRHO_SAFE_ASSERT_RETURN(file != nullptr,);
+
+        if (std::fseek(file, 0, SEEK_END) == 0)
+        {
+            const long size = std::ftell(file);
+
+            if (size > 0 && std::fseek(file, 0, SEEK_SET) == 0)
+            {
+                if (void* const data = std::malloc(static_cast<size_t>(size)))
+                {
+                    if (std::fread(data, 1, static_cast<size_t>(size), file) == static_cast<size_t>(size))
+                        fPlugin.setBinaryState(key, data, static_cast<size_t>(size));
+                    std::free(data);
+                }
+            }
+            else if (size == 0)
             {
-                curValue = fLastControlValues[i] = fPlugin.getParameterValue(i);
+                fPlugin.setBinaryState(key, nullptr, 0);
+            }
+        }
+
+        std::fclose(file);
+#  else
+        // map the file instead of reading it, the plugin only touches the pages it copies
+        const int fd = ::open(path, O_RDONLY);
+        DISTRHO_SAFE_ASSERT_RETURN(fd >= 0,);
+
+        struct stat st;
 
-                if (fPortControls[i] != nullptr)
-                    *fPortControls[i] = curValue;
+        if (::fstat(fd, &st) == 0)
+        {
+            const size_t size = static_cast<size_t>(st.st_size);
+
+            if (size == 0)
+            {
+                fPlugin.setBinaryState(key, nullptr, 0);
             }
-            else if ((fPlugin.getParameterHints(i) & kParameterIsTrigger) == kParameterIsTrigger)
+            else
             {
-                // NOTE: host is responsible for auto-updating control port buffers
+                void* const data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+                if (data != MAP_FAILED)
+                {
+                    ::madvise(data, size, MADV_SEQUENTIAL);
+                    fPlugin.setBinaryState(key, data, size);
+                    ::munmap(data, size);
+                }
+                else
+                {
+                    d_stderr2("Failed to map state file '%s'", path);
+                }
             }
         }
 
+        ::close(fd);
+#  endif
+    }
+# endif
+#endif
+
+    void updateParameterOutputsAndTriggers()
+    {
+        const uint32_t* const outputIndexes = fPlugin.getOutputParameterIndexes();
+        float curValue;
+
+        for (uint32_t j=0, count=fPlugin.getOutputParameterCount(); j < count; ++j)
+        {
+            const uint32_t i = outputIndexes[j];
+
+            curValue = fLastControlValues[i] = fPlugin.getParameterValue(i);
+
+            if (fPortControls[i] != nullptr)
+                *fPortControls[i] = curValue;
+        }
+
+        // NOTE: host is responsible for auto-updating trigger control port buffers
+
 #if DISTRHO_PLUGIN_WANT_LATENCY
         if (fPortLatency != nullptr)
             *fPortLatency = fPlugin.getLatency();
@@ -1058,35 +1315,131 @@ private:
     }
 
 #if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
-    bool writeMidi(const MidiEvent& midiEvent)
+    // Append a MIDI atom of @a size bytes to the output sequence and return its body, null if full.
+    uint8_t* reserveMidi(const uint32_t frame, const uint32_t size)
     {
-        DISTRHO_SAFE_ASSERT_RETURN(fEventsOutData.port != nullptr, false);
+        DISTRHO_SAFE_ASSERT_RETURN(fEventsOutData.port != nullptr, nullptr);
+
+# if DISTRHO_PLUGIN_MIDI_THRU
+        flushMidiThru(frame);
+# endif
 
         fEventsOutData.initIfNeeded(fURIDs.atomSequence);
 
         const uint32_t capacity = fEventsOutData.capacity;
         const uint32_t offset = fEventsOutData.offset;
 
-        if (sizeof(LV2_Atom_Event) + midiEvent.size > capacity - offset)
-            return false;
+        if (sizeof(LV2_Atom_Event) + size > capacity - offset)
+            return nullptr;
 
         LV2_Atom_Event* const aev = (LV2_Atom_Event*)(LV2_ATOM_CONTENTS(LV2_Atom_Sequence, fEventsOutData.port) + offset);
-        aev->time.frames = midiEvent.frame;
+        aev->time.frames = frame;
         aev->body.type   = fURIDs.midiEvent;
-        aev->body.size   = midiEvent.size;
-        std::memcpy(LV2_ATOM_BODY(&aev->body),
-                    midiEvent.size > MidiEvent::kDataSize ? midiEvent.dataExt : midiEvent.data,
-                    midiEvent.size);
+        aev->body.size   = size;
 
-        fEventsOutData.growBy(lv2_atom_pad_size(sizeof(LV2_Atom_Event) + midiEvent.size));
+        fEventsOutData.growBy(lv2_atom_pad_size(sizeof(LV2_Atom_Event) + size));
 
+        return (uint8_t*)LV2_ATOM_BODY(&aev->body);
+    }
+
+    bool writeMidi(const MidiEvent& midiEvent)
+    {
+        uint8_t* const data = reserveMidi(midiEvent.frame, midiEvent.size);
+
+        if (data == nullptr)
+            return false;
+
+        std::memcpy(data, midiEvent.size > MidiEvent::kDataSize ? midiEvent.dataExt : midiEvent.data, midiEvent.size);
         return true;
     }
 
+    uint32_t writeMidiEvents(const MidiEvent* const midiEvents, const uint32_t count, const uint32_t frameOffset)
+    {
+        for (uint32_t i=0; i < count; ++i)
+        {
+            const MidiEvent& midiEvent(midiEvents[i]);
+            uint8_t* const data = reserveMidi(midiEvent.frame + frameOffset, midiEvent.size);
+
+            if (data == nullptr)
+                return i;
+
+            std::memcpy(data, midiEvent.size > MidiEvent::kDataSize ? midiEvent.dataExt : midiEvent.data, midiEvent.size);
+        }
+
+        return count;
+    }
+
+# if DISTRHO_PLUGIN_MIDI_THRU
+    // Copy MIDI input events up to and including @a frame to the output sequence.
+    // Input and output share the atom event layout, so each run of consecutive MIDI events is a single memcpy.
+    void flushMidiThru(const uint32_t frame)
+    {
+        const LV2_Atom_Event* event = fMidiThruEvent;
+
+        if (event == nullptr || fEventsOutData.port == nullptr)
+            return;
+
+        fEventsOutData.initIfNeeded(fURIDs.atomSequence);
+
+        const LV2_Atom_Sequence_Body* const body = &fPortEventsIn->body;
+        const uint32_t bodySize = fPortEventsIn->atom.size;
+        const uint8_t* const bodyEnd = (const uint8_t*)body + bodySize;
+
+        while (! lv2_atom_sequence_is_end(body, bodySize, event) && event->time.frames <= frame)
+        {
+            if (event->body.type != fURIDs.midiEvent)
+            {
+                event = lv2_atom_sequence_next(event);
+                continue;
+            }
+
+            const LV2_Atom_Event* const first = event;
+            uint32_t runSize = 0;
+
+            do {
+                const uint32_t eventSize = lv2_atom_pad_size(sizeof(LV2_Atom_Event) + event->body.size);
+
+                if (runSize + eventSize > fEventsOutData.capacity - fEventsOutData.offset)
+                    break;
+
+                runSize += eventSize;
+                event = lv2_atom_sequence_next(event);
+            }
+            while (! lv2_atom_sequence_is_end(body, bodySize, event)
+                   && event->time.frames <= frame && event->body.type == fURIDs.midiEvent);
+
+            if (runSize == 0)
+            {
+                // output is full, drop the rest
+                event = (const LV2_Atom_Event*)bodyEnd;
+                break;
+            }
+
+            // the host may leave out the padding of the last event
+            const uint32_t available = static_cast<uint32_t>(bodyEnd - (const uint8_t*)first);
+            const uint32_t copySize  = runSize < available ? runSize : available;
+            std::memcpy(LV2_ATOM_CONTENTS(LV2_Atom_Sequence, fEventsOutData.port) + fEventsOutData.offset, first, copySize);
+            fEventsOutData.growBy(runSize);
+        }
+
+        fMidiThruEvent = event;
+    }
+# endif
+
     static bool writeMidiCallback(void* ptr, const MidiEvent& midiEvent)
     {
         return ((PluginLv2*)ptr)->writeMidi(midiEvent);
     }
+
+    static uint8_t* reserveMidiCallback(void* ptr, uint32_t frame, uint32_t size)
+    {
+        return ((PluginLv2*)ptr)->reserveMidi(frame, size);
+    }
+
+    static uint32_t writeMidiEventsCallback(void* ptr, const MidiEvent* midiEvents, uint32_t count, uint32_t frameOffset)
+    {
+        return ((PluginLv2*)ptr)->writeMidiEvents(midiEvents, count, frameOffset);
+    }
 #endif
 };
 
@@ -1229,14 +1582,14 @@ static void lv2_select_program(LV2_Handle instance, uint32_t bank, uint32_t prog
 // -----------------------------------------------------------------------
 
 #if DISTRHO_PLUGIN_WANT_STATE
-static LV2_State_Status lv2_save(LV2_Handle instance, LV2_State_Store_Function store, LV2_State_Handle handle, uint32_t, const LV2_Feature* const*)
+static LV2_State_Status lv2_save(LV2_Handle instance, LV2_State_Store_Function store, LV2_State_Handle handle, uint32_t, const LV2_Feature* const* features)
 {
-    return instancePtr->lv2_save(store, handle);
+    return instancePtr->lv2_save(store, handle, features);
 }
 
-static LV2_State_Status lv2_restore(LV2_Handle instance, LV2_State_Retrieve_Function retrieve, LV2_State_Handle handle, uint32_t, const LV2_Feature* const*)
+static LV2_State_Status lv2_restore(LV2_Handle instance, LV2_State_Retrieve_Function retrieve, LV2_State_Handle handle, uint32_t, const LV2_Feature* const* features)
 {
-    return instancePtr->lv2_restore(retrieve, handle);
+    return instancePtr->lv2_restore(retrieve, handle, features);
 }
 
 LV2_Worker_Status lv2_work(LV2_Handle instance, LV2_Worker_Respond_Function, LV2_Worker_Respond_Handle, uint32_t, const void* data)
@@ -698,6 +698,10 @@ void lv2_generate_ttl(const char* const basename)
             presetString += "    state:state [\n";
             for (uint32_t j=0; j<numStates; ++j)
             {
+                // binary states have no text form to put in a preset
+                if (plugin.isStateBinary(j))
+                    continue;
+
                 const String key   = plugin.getStateKey(j);
                 const String value = plugin.getState(key);
 
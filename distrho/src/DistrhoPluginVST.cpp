@@ -33,7 +33,6 @@
 #define VST_FORCE_DEPRECATED 0
 
 #include <clocale>
-#include <map>
 #include <string>
 
 #ifdef VESTIGE_HEADER
@@ -50,21 +49,223 @@
 #define effEditKeyDown 59
 #define effEditKeyUp 60
 #define kVstVersion 2400
+#define kVstSysExType 6
 struct ERect {
     int16_t top, left, bottom, right;
 };
+struct VstMidiSysexEvent {
+    int32_t  type;
+    int32_t  byteSize;
+    int32_t  deltaFrames;
+    int32_t  flags;
+    int32_t  dumpBytes;
+    intptr_t resvd1;
+    char*    sysexDump;
+    intptr_t resvd2;
+};
 #else
 # include "vst/aeffectx.h"
 #endif
 
 START_NAMESPACE_DISTRHO
 
-typedef std::map<const String, String> StringMap;
+static const int kVstMidiEventSize  = static_cast<int>(sizeof(VstMidiEvent));
+static const int kVstSysExEventSize = static_cast<int>(sizeof(VstMidiSysexEvent));
+
+// SysEx data kept per direction and block
+static const uint32_t kVstSysExPoolSize  = 64*1024;
+static const uint32_t kMaxVstSysExEvents = 64;
+
+// Host event lists kept per block, hosts may call effProcessEvents more than once before processing
+static const uint32_t kMaxVstEventLists = 4;
+
+#if DISTRHO_PLUGIN_WANT_STATE
+// -----------------------------------------------------------------------
+// State chunk layout, all numbers are little-endian:
+//  - header: "DPFc", version, parameter count and state count, 4 bytes each
+//  - parameters: symbol hash and value of each parameter, 4 bytes each, in index order
+//  - states: key size, key, flags, 64-bit value size, value
+// Keys and string values keep their null terminator so they can be used in place.
+
+static const char     kVstChunkMagic[4]      = { 'D', 'P', 'F', 'c' };
+static const uint32_t kVstChunkVersion       = 1;
+static const uint32_t kVstChunkHeaderSize    = 16;
+static const uint32_t kVstChunkStateIsBinary = 0x1;
+
+// Sequential writer into a buffer already sized for everything written
+struct VstChunkWriter {
+    char* ptr;
+
+    VstChunkWriter(char* const buffer) noexcept
+        : ptr(buffer) {}
+
+    void writeUInt32(const uint32_t value) noexcept
+    {
+        for (uint32_t i=0; i < 4; ++i)
+            *ptr++ = static_cast<char>((value >> (8*i)) & 0xff);
+    }
+
+    void writeUInt64(const uint64_t value) noexcept
+    {
+        for (uint32_t i=0; i < 8; ++i)
+            *ptr++ = static_cast<char>((value >> (8*i)) & 0xff);
+    }
+
+    void writeFloat(const float value) noexcept
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(float));
+        writeUInt32(bits);
+    }
+
+    void writeData(const void* const data, const size_t size) noexcept
+    {
+        if (size == 0)
+            return;
 
-static const int kVstMidiEventSize = static_cast<int>(sizeof(VstMidiEvent));
+        std::memcpy(ptr, data, size);
+        ptr += size;
+    }
+};
+
+// Sequential reader over host memory, every read is bounds checked
+struct VstChunkReader {
+    const char* ptr;
+    size_t remaining;
+
+    VstChunkReader(const char* const buffer, const size_t size) noexcept
+        : ptr(buffer),
+          remaining(size) {}
+
+    bool readUInt32(uint32_t& value) noexcept
+    {
+        if (remaining < 4)
+            return false;
+
+        value = 0;
+        for (uint32_t i=0; i < 4; ++i)
+            value |= static_cast<uint32_t>(static_cast<uint8_t>(ptr[i])) << (8*i);
+
+        ptr += 4;
+        remaining -= 4;
+        return true;
+    }
+
+    bool readUInt64(uint64_t& value) noexcept
+    {
+        if (remaining < 8)
+            return false;
+
+        value = 0;
+        for (uint32_t i=0; i < 8; ++i)
+            value |= static_cast<uint64_t>(static_cast<uint8_t>(ptr[i])) << (8*i);
+
+        ptr += 8;
+        remaining -= 8;
+        return true;
+    }
+
+    bool readFloat(float& value) noexcept
+    {
+        uint32_t bits;
+
+        if (! readUInt32(bits))
+            return false;
+
+        std::memcpy(&value, &bits, sizeof(float));
+        return true;
+    }
+
+    // Returns a pointer into the chunk, or null if there are less than @a size bytes left.
+    const char* readData(const uint64_t size) noexcept
+    {
+        if (size > remaining)
+            return nullptr;
+
+        const char* const data = ptr;
+        ptr += size;
+        remaining -= static_cast<size_t>(size);
+        return data;
+    }
+};
+#endif
 
 #if ! DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
-static const writeMidiFunc writeMidiCallback = nullptr;
+static const writeMidiFunc       writeMidiCallback       = nullptr;
+static const reserveMidiFunc     reserveMidiCallback     = nullptr;
+static const writeMidiEventsFunc writeMidiEventsCallback = nullptr;
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT || DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+// -----------------------------------------------------------------------
+
+// Size of a short MIDI message, taken from its status byte
+static uint8_t getMidiMessageSize(const uint8_t status) noexcept
+{
+    if (status < 0xC0)
+        return 3;
+    if (status < 0xE0)
+        return 2;
+    if (status < 0xF0)
+        return 3;
+
+    switch (status)
+    {
+    case 0xF1:
+    case 0xF3:
+        return 2;
+    case 0xF2:
+        return 3;
+    default:
+        return 1;
+    }
+}
+
+// Frame of a host event, MIDI and SysEx events share the header layout
+static int getDeltaFrames(const VstEvent* const vstEvent) noexcept
+{
+    return vstEvent != nullptr ? ((const VstMidiEvent*)vstEvent)->deltaFrames : 0;
+}
+
+// Fixed size storage for SysEx data, cleared once per block
+struct VstSysExPool {
+    uint8_t  data[kVstSysExPoolSize];
+    uint32_t used;
+
+    VstSysExPool() noexcept
+        : used(0) {}
+
+    uint8_t* allocate(const uint32_t size) noexcept
+    {
+        if (size > kVstSysExPoolSize - used)
+            return nullptr;
+
+        uint8_t* const ptr = data + used;
+        used += size;
+        return ptr;
+    }
+
+    void clear() noexcept
+    {
+        used = 0;
+    }
+};
+
+// Read position in a host event list, a null event ends the list
+struct VstEventsCursor {
+    const VstEvents* events;
+    int index;
+
+    const VstEvent* peek() const noexcept
+    {
+        return index < events->numEvents ? events->events[index] : nullptr;
+    }
+
+    void next() noexcept
+    {
+        ++index;
+    }
+};
 #endif
 
 // -----------------------------------------------------------------------
@@ -383,7 +584,7 @@ class PluginVst : public ParameterCheckHelper
 {
 public:
     PluginVst(const audioMasterCallback audioMaster, AEffect* const effect)
-        : fPlugin(this, writeMidiCallback),
+        : fPlugin(this, writeMidiCallback, reserveMidiCallback, writeMidiEventsCallback),
           fAudioMaster(audioMaster),
           fEffect(effect)
     {
@@ -392,6 +593,15 @@ public:
 
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
         fMidiEventCount = 0;
+        fMidiEventsOverflowCount = 0;
+#endif
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        fMidiOutCount = fMidiOutEventCount = fMidiOutSysExCount = 0;
+        fMidiOutBlock.numEvents = 0;
+        fMidiOutBlock.reserved  = 0;
+#endif
+#if DISTRHO_PLUGIN_MIDI_THRU
+        fMidiThruListCount = 0;
 #endif
 
 #if DISTRHO_PLUGIN_HAS_UI
@@ -425,13 +635,21 @@ public:
 #endif // DISTRHO_PLUGIN_HAS_UI
 
 #if DISTRHO_PLUGIN_WANT_STATE
-        fStateChunk = nullptr;
-
-        for (uint32_t i=0, count=fPlugin.getStateCount(); i<count; ++i)
+        fStateChunk     = nullptr;
+        fStateChunkSize = 0;
+        fStateValues.init(fPlugin);
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+        if (const uint32_t count = fPlugin.getStateCount())
+        {
+            fChunkBinaryData  = new const void*[count];
+            fChunkBinarySizes = new size_t[count];
+        }
+        else
         {
-            const String& dkey(fPlugin.getStateKey(i));
-            fStateMap[dkey] = fPlugin.getStateDefaultValue(i);
+            fChunkBinaryData  = nullptr;
+            fChunkBinarySizes = nullptr;
         }
+# endif
 #endif
     }
 
@@ -444,7 +662,21 @@ public:
             fStateChunk = nullptr;
         }
 
-        fStateMap.clear();
+        fStateValues.clear();
+
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+        if (fChunkBinaryData != nullptr)
+        {
+            delete[] fChunkBinaryData;
+            fChunkBinaryData = nullptr;
+        }
+
+        if (fChunkBinarySizes != nullptr)
+        {
+            delete[] fChunkBinarySizes;
+            fChunkBinarySizes = nullptr;
+        }
+# endif
 #endif
     }
 
@@ -539,6 +771,11 @@ public:
             {
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
                 fMidiEventCount = 0;
+                fMidiEventsOverflowCount = 0;
+                fSysExIn.clear();
+# if DISTRHO_PLUGIN_MIDI_THRU
+                fMidiThruListCount = 0;
+# endif
 
                 // tell host we want MIDI events
                 hostCallback(audioMasterWantMidi);
@@ -600,21 +837,15 @@ public:
 
 # if DISTRHO_PLUGIN_WANT_FULL_STATE
                 // Update current state from plugin side
-                for (StringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
-                {
-                    const String& key = cit->first;
-                    fStateMap[key] = fPlugin.getState(key);
-                }
+                updateStateValues();
 # endif
 
 # if DISTRHO_PLUGIN_WANT_STATE
                 // Set state
-                for (StringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
+                for (uint32_t i=0, count=fStateValues.getCount(); i < count; ++i)
                 {
-                    const String& key   = cit->first;
-                    const String& value = cit->second;
-
-                    fVstUI->setStateFromPlugin(key, value);
+                    if (! fPlugin.isStateBinary(i))
+                        fVstUI->setStateFromPlugin(fPlugin.getStateKey(i), fStateValues.get(i));
                 }
 # endif
                 for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
@@ -653,173 +884,25 @@ public:
 
 #if DISTRHO_PLUGIN_WANT_STATE
         case effGetChunk:
-        {
             if (ptr == nullptr)
                 return 0;
 
-            if (fStateChunk != nullptr)
-            {
-                delete[] fStateChunk;
-                fStateChunk = nullptr;
-            }
-
-            const uint32_t paramCount = fPlugin.getParameterCount();
-
-            if (fPlugin.getStateCount() == 0 && paramCount == 0)
-            {
-                fStateChunk    = new char[1];
-                fStateChunk[0] = '\0';
-                ret = 1;
-            }
-            else
-            {
-# if DISTRHO_PLUGIN_WANT_FULL_STATE
-                // Update current state
-                for (StringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
-                {
-                    const String& key = cit->first;
-                    fStateMap[key] = fPlugin.getState(key);
-                }
-# endif
-
-                String chunkStr;
-
-                for (StringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
-                {
-                    const String& key   = cit->first;
-                    const String& value = cit->second;
-
-                    // join key and value
-                    String tmpStr;
-                    tmpStr  = key;
-                    tmpStr += "\xff";
-                    tmpStr += value;
-                    tmpStr += "\xff";
-
-                    chunkStr += tmpStr;
-                }
-
-                if (paramCount != 0)
-                {
-                    // add another separator
-                    chunkStr += "\xff";
-
-                    // temporarily set locale to "C" while converting floats
-                    const ScopedSafeLocale ssl;
-
-                    for (uint32_t i=0; i<paramCount; ++i)
-                    {
-                        if (fPlugin.isParameterOutputOrTrigger(i))
-                            continue;
-
-                        // join key and value
-                        String tmpStr;
-                        tmpStr  = fPlugin.getParameterSymbol(i);
-                        tmpStr += "\xff";
-                        tmpStr += String(fPlugin.getParameterValue(i));
-                        tmpStr += "\xff";
-
-                        chunkStr += tmpStr;
-                    }
-                }
-
-                const std::size_t chunkSize(chunkStr.length()+1);
-
-                fStateChunk = new char[chunkSize];
-                std::memcpy(fStateChunk, chunkStr.buffer(), chunkStr.length());
-                fStateChunk[chunkSize-1] = '\0';
-
-                for (std::size_t i=0; i<chunkSize; ++i)
-                {
-                    if (fStateChunk[i] == '\xff')
-                        fStateChunk[i] = '\0';
-                }
-
-                ret = chunkSize;
-            }
-
+            ret = static_cast<intptr_t>(writeStateChunk());
             *(void**)ptr = fStateChunk;
             return ret;
-        }
 
         case effSetChunk:
-        {
-            if (value <= 1 || ptr == nullptr)
+            if (value <= 0 || ptr == nullptr)
                 return 0;
 
-            const size_t chunkSize = static_cast<size_t>(value);
-
-            const char* key   = (const char*)ptr;
-            const char* value = nullptr;
-            size_t size, bytesRead = 0;
-
-            while (bytesRead < chunkSize)
-            {
-                if (key[0] == '\0')
-                    break;
-
-                size  = std::strlen(key)+1;
-                value = key + size;
-                bytesRead += size;
+            if (value >= 4 && std::memcmp(ptr, kVstChunkMagic, 4) == 0)
+                return readStateChunk((const char*)ptr, static_cast<size_t>(value)) ? 1 : 0;
 
-                setStateFromUI(key, value);
-
-# if DISTRHO_PLUGIN_HAS_UI
-                if (fVstUI != nullptr)
-                    fVstUI->setStateFromPlugin(key, value);
-# endif
-
-                // get next key
-                size = std::strlen(value)+1;
-                key  = value + size;
-                bytesRead += size;
-            }
-
-            const uint32_t paramCount = fPlugin.getParameterCount();
-
-            if (bytesRead+4 < chunkSize && paramCount != 0)
-            {
-                ++key;
-                float fvalue;
-
-                // temporarily set locale to "C" while converting floats
-                const ScopedSafeLocale ssl;
-
-                while (bytesRead < chunkSize)
-                {
-                    if (key[0] == '\0')
-                        break;
-
-                    size  = std::strlen(key)+1;
-                    value = key + size;
-                    bytesRead += size;
-
-                    // find parameter with this symbol, and set its value
-                    for (uint32_t i=0; i<paramCount; ++i)
-                    {
-                        if (fPlugin.isParameterOutputOrTrigger(i))
-                            continue;
-                        if (fPlugin.getParameterSymbol(i) != key)
-                            continue;
-
-                        fvalue = std::atof(value);
-                        fPlugin.setParameterValue(i, fvalue);
-# if DISTRHO_PLUGIN_HAS_UI
-                        if (fVstUI != nullptr)
-                            setParameterValueFromPlugin(i, fvalue);
-# endif
-                        break;
-                    }
-
-                    // get next key
-                    size = std::strlen(value)+1;
-                    key  = value + size;
-                    bytesRead += size;
-                }
-            }
+            // chunk saved by an older build
+            if (value <= 1)
+                return 0;
 
-            return 1;
-        }
+            return readLegacyStateChunk((const char*)ptr, static_cast<size_t>(value)) ? 1 : 0;
 #endif // DISTRHO_PLUGIN_WANT_STATE
 
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
@@ -835,21 +918,38 @@ public:
                 if (events->numEvents == 0)
                     break;
 
+# if DISTRHO_PLUGIN_MIDI_THRU
+                // passed back to the host untouched, merged with the plugin output
+                if (fMidiThruListCount < kMaxVstEventLists)
+                {
+                    VstEventsCursor& thru(fMidiThruLists[fMidiThruListCount++]);
+                    thru.events = events;
+                    thru.index  = 0;
+                }
+# endif
+
                 for (int i=0, count=events->numEvents; i < count; ++i)
                 {
-                    const VstMidiEvent* const vstMidiEvent((const VstMidiEvent*)events->events[i]);
+                    const VstEvent* const vstEvent(events->events[i]);
 
-                    if (vstMidiEvent == nullptr)
+                    if (vstEvent == nullptr)
                         break;
-                    if (vstMidiEvent->type != kVstMidiType)
-                        continue;
+
                     if (fMidiEventCount >= kMaxMidiEvents)
+                    {
+                        // hosts keep their event list alive until the next process call, read the rest from there
+                        if (fMidiEventsOverflowCount < kMaxVstEventLists)
+                        {
+                            VstEventsCursor& overflow(fMidiEventsOverflow[fMidiEventsOverflowCount++]);
+                            overflow.events = events;
+                            overflow.index  = i;
+                        }
                         break;
+                    }
 
-                    MidiEvent& midiEvent(fMidiEvents[fMidiEventCount++]);
-                    midiEvent.frame  = vstMidiEvent->deltaFrames;
-                    midiEvent.size   = 3;
-                    std::memcpy(midiEvent.data, vstMidiEvent->midiData, sizeof(uint8_t)*3);
+                    // SysEx is copied, some hosts reuse their buffers when calling us more than once per block
+                    if (convertVstEvent(vstEvent, fMidiEvents[fMidiEventCount], &fSysExIn))
+                        insertMidiEvent(fMidiEventCount++);
                 }
             }
             break;
@@ -998,17 +1098,148 @@ public:
 #endif
 
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
-        fPlugin.run(inputs, outputs, sampleFrames, fMidiEvents, fMidiEventCount);
+        fPlugin.beginRun(inputs, outputs, sampleFrames);
+
+        if (fMidiEventsOverflowCount == 0)
+        {
+            for (uint32_t i=0; i < fMidiEventCount; ++i)
+                fPlugin.addMidiEvent(fMidiEvents[i]);
+        }
+        else
+        {
+            addMidiEventsWithOverflow();
+        }
+
+        fPlugin.endRun();
         fMidiEventCount = 0;
+        fMidiEventsOverflowCount = 0;
+        fSysExIn.clear();
 #else
         fPlugin.run(inputs, outputs, sampleFrames);
 #endif
 
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        flushMidiOutput(true);
+#endif
+#if DISTRHO_PLUGIN_MIDI_THRU
+        fMidiThruListCount = 0;
+#endif
+
         updateParameterOutputsAndTriggers();
     }
 
     // -------------------------------------------------------------------
 
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    // Move the converted event at @a index back to keep fMidiEvents in time order.
+    // Each host list is already sorted, so this only moves events of a later effProcessEvents call.
+    void insertMidiEvent(uint32_t index) noexcept
+    {
+        const MidiEvent midiEvent(fMidiEvents[index]);
+
+        for (; index > 0 && fMidiEvents[index-1].frame > midiEvent.frame; --index)
+            fMidiEvents[index] = fMidiEvents[index-1];
+
+        fMidiEvents[index] = midiEvent;
+    }
+
+    // Pass fMidiEvents and the host events that did not fit there to the plugin, merged in time order.
+    // Overflow SysEx is copied into fSysExIn like the rest, and dropped once that is full.
+    void addMidiEventsWithOverflow()
+    {
+        MidiEvent midiEvent;
+        uint32_t i = 0;
+
+        for (;;)
+        {
+            VstEventsCursor* overflow = nullptr;
+            int frame = i < fMidiEventCount ? static_cast<int>(fMidiEvents[i].frame) : INT32_MAX;
+
+            for (uint32_t j=0; j < fMidiEventsOverflowCount; ++j)
+            {
+                if (const VstEvent* const vstEvent = fMidiEventsOverflow[j].peek())
+                {
+                    if (getDeltaFrames(vstEvent) < frame)
+                    {
+                        overflow = &fMidiEventsOverflow[j];
+                        frame = getDeltaFrames(vstEvent);
+                    }
+                }
+            }
+
+            if (overflow != nullptr)
+            {
+                if (convertVstEvent(overflow->peek(), midiEvent, &fSysExIn))
+                    fPlugin.addMidiEvent(midiEvent);
+                overflow->next();
+            }
+            else if (i < fMidiEventCount)
+            {
+                fPlugin.addMidiEvent(fMidiEvents[i++]);
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+
+    // Convert a host event, returns false for unsupported types or when @a sysExPool is full.
+    // SysEx data is copied into @a sysExPool, or referenced in place if null.
+    static bool convertVstEvent(const VstEvent* const vstEvent, MidiEvent& midiEvent, VstSysExPool* const sysExPool) noexcept
+    {
+        const VstMidiEvent* const vstMidiEvent((const VstMidiEvent*)vstEvent);
+
+        if (vstMidiEvent->type == kVstMidiType)
+        {
+            midiEvent.frame   = vstMidiEvent->deltaFrames;
+            midiEvent.size    = getMidiMessageSize(static_cast<uint8_t>(vstMidiEvent->midiData[0]));
+            midiEvent.dataExt = nullptr;
+            std::memcpy(midiEvent.data, vstMidiEvent->midiData, MidiEvent::kDataSize);
+            return true;
+        }
+
+        if (vstMidiEvent->type == kVstSysExType)
+        {
+            const VstMidiSysexEvent* const vstSysExEvent((const VstMidiSysexEvent*)vstEvent);
+
+            if (vstSysExEvent->dumpBytes <= 0 || vstSysExEvent->sysexDump == nullptr)
+                return false;
+
+            const uint32_t size = static_cast<uint32_t>(vstSysExEvent->dumpBytes);
+
+            midiEvent.frame = vstSysExEvent->deltaFrames;
+            midiEvent.size  = size;
+
+            if (size <= MidiEvent::kDataSize)
+            {
+                midiEvent.dataExt = nullptr;
+                std::memcpy(midiEvent.data, vstSysExEvent->sysexDump, size);
+                return true;
+            }
+
+            if (sysExPool == nullptr)
+            {
+                midiEvent.dataExt = (const uint8_t*)vstSysExEvent->sysexDump;
+                return true;
+            }
+
+            uint8_t* const data = sysExPool->allocate(size);
+
+            if (data == nullptr)
+                return false;
+
+            std::memcpy(data, vstSysExEvent->sysexDump, size);
+            midiEvent.dataExt = data;
+            return true;
+        }
+
+        return false;
+    }
+#endif
+
+    // -------------------------------------------------------------------
+
     friend class UIVst;
 
 private:
@@ -1025,6 +1256,35 @@ private:
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
     uint32_t  fMidiEventCount;
     MidiEvent fMidiEvents[kMaxMidiEvents];
+
+    // Host events that did not fit in fMidiEvents, passed to the plugin in the next process call
+    VstEventsCursor fMidiEventsOverflow[kMaxVstEventLists];
+    uint32_t        fMidiEventsOverflowCount;
+
+    // Input SysEx data, valid until the end of the next process call
+    VstSysExPool fSysExIn;
+#endif
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+    // Output events of the current block, in the order written by the plugin
+    VstEvent*         fMidiOutList[kMaxMidiEvents];
+    uint32_t          fMidiOutCount;
+    VstMidiEvent      fMidiOutEvents[kMaxMidiEvents];
+    uint32_t          fMidiOutEventCount;
+    VstMidiSysexEvent fMidiOutSysExEvents[kMaxVstSysExEvents];
+    uint32_t          fMidiOutSysExCount;
+    VstSysExPool      fSysExOut;
+
+    // What gets sent to the host, VstEvents with room for a full block
+    struct {
+        int32_t   numEvents;
+        intptr_t  reserved;
+        VstEvent* events[kMaxMidiEvents];
+    } fMidiOutBlock;
+#endif
+#if DISTRHO_PLUGIN_MIDI_THRU
+    // Host event lists of this cycle, merged as-is into the output
+    VstEventsCursor fMidiThruLists[kMaxVstEventLists];
+    uint32_t        fMidiThruListCount;
 #endif
 
 #if DISTRHO_PLUGIN_WANT_TIMEPOS
@@ -1041,8 +1301,14 @@ private:
 #endif
 
 #if DISTRHO_PLUGIN_WANT_STATE
-    char*     fStateChunk;
-    StringMap fStateMap;
+    char*             fStateChunk;
+    size_t            fStateChunkSize;
+    PluginStateValues fStateValues;
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+    // binary state data of the chunk being written, indexed by state
+    const void**      fChunkBinaryData;
+    size_t*           fChunkBinarySizes;
+# endif
 #endif
 
     // -------------------------------------------------------------------
@@ -1064,16 +1330,16 @@ private:
     {
         float curValue;
 
-        for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
+        // NOTE: no output parameter support in VST, simulate it here
+        fPlugin.updateOutputParameters();
+
+        for (uint32_t w=0, wcount=fPlugin.getDirtyOutputWordCount(); w < wcount; ++w)
         {
-            if (fPlugin.isParameterOutput(i))
+            for (uint32_t bits = fPlugin.takeDirtyOutputs(w); bits != 0; bits &= bits - 1)
             {
-                // NOTE: no output parameter support in VST, simulate it here
+                const uint32_t i = w*32 + static_cast<uint32_t>(__builtin_ctz(bits));
                 curValue = fPlugin.getParameterValue(i);
 
-                if (d_isEqual(curValue, parameterValues[i]))
-                    continue;
-
 #if DISTRHO_PLUGIN_HAS_UI
                 if (fVstUI != nullptr)
                     setParameterValueFromPlugin(i, curValue);
@@ -1081,29 +1347,31 @@ private:
 #endif
                 parameterValues[i] = curValue;
 
-#ifndef DPF_VST_SHOW_PARAMETER_OUTPUTS
-                // skip automating parameter outputs from plugin if we disable them on VST
-                continue;
+#ifdef DPF_VST_SHOW_PARAMETER_OUTPUTS
+                const ParameterRanges& ranges(fPlugin.getParameterRanges(i));
+                hostCallback(audioMasterAutomate, i, 0, nullptr, ranges.getNormalizedValue(curValue));
 #endif
             }
-            else if ((fPlugin.getParameterHints(i) & kParameterIsTrigger) == kParameterIsTrigger)
-            {
-                // NOTE: no trigger support in VST parameters, simulate it here
-                curValue = fPlugin.getParameterValue(i);
+        }
 
-                if (d_isEqual(curValue, fPlugin.getParameterRanges(i).def))
-                    continue;
+        const uint32_t* const triggerIndexes = fPlugin.getTriggerParameterIndexes();
+        const float*    const defValues      = fPlugin.getParameterDefValues();
+
+        for (uint32_t j=0, count=fPlugin.getTriggerParameterCount(); j < count; ++j)
+        {
+            const uint32_t i = triggerIndexes[j];
+
+            // NOTE: no trigger support in VST parameters, simulate it here
+            curValue = fPlugin.getParameterValue(i);
+
+            if (d_isEqual(curValue, defValues[i]))
+                continue;
 
 #if DISTRHO_PLUGIN_HAS_UI
-                if (fVstUI != nullptr)
-                    setParameterValueFromPlugin(i, curValue);
+            if (fVstUI != nullptr)
+                setParameterValueFromPlugin(i, curValue);
 #endif
-                fPlugin.setParameterValue(i, curValue);
-            }
-            else
-            {
-                continue;
-            }
+            fPlugin.setParameterValue(i, curValue);
 
             const ParameterRanges& ranges(fPlugin.getParameterRanges(i));
             hostCallback(audioMasterAutomate, i, 0, nullptr, ranges.getNormalizedValue(curValue));
@@ -1119,34 +1387,163 @@ private:
 #endif
 
 #if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
-    bool writeMidi(const MidiEvent& midiEvent)
+    // Take an output slot for an event of @a size bytes, returns where its data goes or null if out of space.
+    uint8_t* allocateMidiOutput(const uint32_t frame, const uint32_t size, const bool sysEx)
     {
-        if (midiEvent.size > 4)
-            return true;
+        if (fMidiOutCount == kMaxMidiEvents)
+            flushMidiOutput(false);
+
+        if (! sysEx)
+        {
+            DISTRHO_SAFE_ASSERT_RETURN(size <= 4, nullptr);
+
+            VstMidiEvent& vstMidiEvent(fMidiOutEvents[fMidiOutEventCount++]);
+            std::memset(&vstMidiEvent, 0, sizeof(VstMidiEvent));
+
+            vstMidiEvent.type        = kVstMidiType;
+            vstMidiEvent.byteSize    = kVstMidiEventSize;
+            vstMidiEvent.deltaFrames = static_cast<int>(frame);
+
+            fMidiOutList[fMidiOutCount++] = (VstEvent*)&vstMidiEvent;
+            return (uint8_t*)vstMidiEvent.midiData;
+        }
+
+        if (fMidiOutSysExCount == kMaxVstSysExEvents || size > kVstSysExPoolSize - fSysExOut.used)
+            flushMidiOutput(false);
+
+        // still null if larger than the whole pool
+        uint8_t* const data = fSysExOut.allocate(size);
+        DISTRHO_SAFE_ASSERT_RETURN(data != nullptr, nullptr);
+
+        VstMidiSysexEvent& vstSysExEvent(fMidiOutSysExEvents[fMidiOutSysExCount++]);
+        std::memset(&vstSysExEvent, 0, sizeof(VstMidiSysexEvent));
+
+        vstSysExEvent.type        = kVstSysExType;
+        vstSysExEvent.byteSize    = kVstSysExEventSize;
+        vstSysExEvent.deltaFrames = static_cast<int>(frame);
+        vstSysExEvent.dumpBytes   = static_cast<int>(size);
+        vstSysExEvent.sysexDump   = (char*)data;
+
+        fMidiOutList[fMidiOutCount++] = (VstEvent*)&vstSysExEvent;
+        return data;
+    }
+
+    // Send the block's output to the host in one call, merged in time order with the thru events if any.
+    // Unless @a endOfBlock, thru events after the last plugin event are kept back so more output can follow.
+    void flushMidiOutput(const bool endOfBlock)
+    {
+        uint32_t count = 0, i = 0;
+
+# if ! DISTRHO_PLUGIN_MIDI_THRU
+        // only matters for thru
+        (void)endOfBlock;
+# endif
+
+        for (;;)
+        {
+            VstEvent* vstEvent;
+
+# if DISTRHO_PLUGIN_MIDI_THRU
+            VstEventsCursor* const thru = getNextMidiThru();
+
+            if (thru != nullptr &&
+                (i < fMidiOutCount ? getDeltaFrames(thru->peek()) <= getDeltaFrames(fMidiOutList[i]) : endOfBlock))
+            {
+                vstEvent = const_cast<VstEvent*>(thru->peek());
+                thru->next();
+            }
+            else
+# endif
+            if (i < fMidiOutCount)
+                vstEvent = fMidiOutList[i++];
+            else
+                break;
+
+            fMidiOutBlock.events[count++] = vstEvent;
+
+            if (count == kMaxMidiEvents)
+            {
+                sendMidiOutput(count);
+                count = 0;
+            }
+        }
+
+        if (count != 0)
+            sendMidiOutput(count);
+
+        fMidiOutCount = fMidiOutEventCount = fMidiOutSysExCount = 0;
+        fSysExOut.clear();
+    }
+
+# if DISTRHO_PLUGIN_MIDI_THRU
+    // Thru list whose next event comes first, null once all of them are done
+    VstEventsCursor* getNextMidiThru() noexcept
+    {
+        VstEventsCursor* next = nullptr;
+
+        for (uint32_t j=0; j < fMidiThruListCount; ++j)
+        {
+            if (const VstEvent* const vstEvent = fMidiThruLists[j].peek())
+            {
+                if (next == nullptr || getDeltaFrames(vstEvent) < getDeltaFrames(next->peek()))
+                    next = &fMidiThruLists[j];
+            }
+        }
 
-        VstEvents vstEvents;
-        std::memset(&vstEvents, 0, sizeof(VstEvents));
+        return next;
+    }
+# endif
 
-        VstMidiEvent vstMidiEvent;
-        std::memset(&vstMidiEvent, 0, sizeof(VstMidiEvent));
+    void sendMidiOutput(const uint32_t count)
+    {
+        fMidiOutBlock.numEvents = static_cast<int>(count);
+        hostCallback(audioMasterProcessEvents, 0, 0, &fMidiOutBlock);
+    }
 
-        vstEvents.numEvents = 1;
-        vstEvents.events[0] = (VstEvent*)&vstMidiEvent;
+    bool writeMidi(const MidiEvent& midiEvent, const uint32_t frameOffset = 0)
+    {
+        const uint8_t* const data = midiEvent.size > MidiEvent::kDataSize ? midiEvent.dataExt : midiEvent.data;
+        const bool sysEx = midiEvent.size > 4 || data[0] == 0xF0;
+
+        uint8_t* const dest = allocateMidiOutput(midiEvent.frame + frameOffset, midiEvent.size, sysEx);
 
-        vstMidiEvent.type = kVstMidiType;
-        vstMidiEvent.byteSize    = kVstMidiEventSize;
-        vstMidiEvent.deltaFrames = midiEvent.frame;
+        if (dest == nullptr)
+            return false;
 
-        for (uint8_t i=0; i<midiEvent.size; ++i)
-            vstMidiEvent.midiData[i] = midiEvent.data[i];
+        std::memcpy(dest, data, midiEvent.size);
+        return true;
+    }
 
-        return hostCallback(audioMasterProcessEvents, 0, 0, &vstEvents) == 1;
+    uint8_t* reserveMidi(const uint32_t frame, const uint32_t size)
+    {
+        return allocateMidiOutput(frame, size, size > 4);
+    }
+
+    uint32_t writeMidiEvents(const MidiEvent* const midiEvents, const uint32_t count, const uint32_t frameOffset)
+    {
+        for (uint32_t i=0; i < count; ++i)
+        {
+            if (! writeMidi(midiEvents[i], frameOffset))
+                return i;
+        }
+
+        return count;
     }
 
     static bool writeMidiCallback(void* ptr, const MidiEvent& midiEvent)
     {
         return ((PluginVst*)ptr)->writeMidi(midiEvent);
     }
+
+    static uint8_t* reserveMidiCallback(void* ptr, uint32_t frame, uint32_t size)
+    {
+        return ((PluginVst*)ptr)->reserveMidi(frame, size);
+    }
+
+    static uint32_t writeMidiEventsCallback(void* ptr, const MidiEvent* midiEvents, uint32_t count, uint32_t frameOffset)
+    {
+        return ((PluginVst*)ptr)->writeMidiEvents(midiEvents, count, frameOffset);
+    }
 #endif
 
 #if DISTRHO_PLUGIN_WANT_STATE
@@ -1161,24 +1558,277 @@ private:
     {
         fPlugin.setState(key, newValue);
 
-        // check if we want to save this key
-        if (! fPlugin.wantStateKey(key))
-            return;
+        // only keys the plugin declared are saved
+        const int32_t index = fPlugin.getStateIndex(key);
 
-        // check if key already exists
-        for (StringMap::iterator it=fStateMap.begin(), ite=fStateMap.end(); it != ite; ++it)
+        if (index >= 0)
+            fStateValues.set(static_cast<uint32_t>(index), newValue);
+    }
+
+# if DISTRHO_PLUGIN_WANT_FULL_STATE
+    void updateStateValues()
+    {
+        for (uint32_t i=0, count=fStateValues.getCount(); i < count; ++i)
         {
-            const String& dkey(it->first);
+            if (fPlugin.isStateBinary(i))
+                continue;
+
+            const String value(fPlugin.getState(fPlugin.getStateKey(i)));
+            fStateValues.set(i, value.buffer(), static_cast<uint32_t>(value.length()));
+        }
+    }
+# endif
+
+    // -------------------------------------------------------------------
+    // state chunk
 
-            if (dkey == key)
+    // Writes parameters and states into fStateChunk, which is only reallocated when it needs to grow.
+    size_t writeStateChunk()
+    {
+# if DISTRHO_PLUGIN_WANT_FULL_STATE
+        // Update current state
+        updateStateValues();
+# endif
+
+        const uint32_t paramCount = fPlugin.getParameterCount();
+        const uint32_t stateCount = fPlugin.getStateCount();
+
+        size_t chunkSize = kVstChunkHeaderSize + paramCount * (4 + sizeof(float));
+
+        for (uint32_t i=0; i < stateCount; ++i)
+        {
+            chunkSize += 4 + fPlugin.getStateKey(i).length() + 1 + 4 + 8;
+
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+            if (fPlugin.isStateBinary(i))
+            {
+                fPlugin.getBinaryState(fPlugin.getStateKey(i), fChunkBinaryData[i], fChunkBinarySizes[i]);
+                chunkSize += fChunkBinarySizes[i];
+                continue;
+            }
+# endif
+
+            chunkSize += fStateValues.getLength(i) + 1;
+        }
+
+        if (chunkSize > fStateChunkSize)
+        {
+            delete[] fStateChunk;
+
+            fStateChunkSize = chunkSize > fStateChunkSize * 2 ? chunkSize : fStateChunkSize * 2;
+            fStateChunk     = new char[fStateChunkSize];
+        }
+
+        VstChunkWriter writer(fStateChunk);
+        writer.writeData(kVstChunkMagic, 4);
+        writer.writeUInt32(kVstChunkVersion);
+        writer.writeUInt32(paramCount);
+        writer.writeUInt32(stateCount);
+
+        for (uint32_t i=0; i < paramCount; ++i)
+        {
+            writer.writeUInt32(fPlugin.getParameterSymbolHash(i));
+            writer.writeFloat(fPlugin.getParameterValue(i));
+        }
+
+        for (uint32_t i=0; i < stateCount; ++i)
+        {
+            const String& key(fPlugin.getStateKey(i));
+
+            writer.writeUInt32(static_cast<uint32_t>(key.length() + 1));
+            writer.writeData(key.buffer(), key.length() + 1);
+
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+            if (fPlugin.isStateBinary(i))
             {
-                it->second = newValue;
-                return;
+                writer.writeUInt32(kVstChunkStateIsBinary);
+                writer.writeUInt64(fChunkBinarySizes[i]);
+                writer.writeData(fChunkBinaryData[i], fChunkBinarySizes[i]);
+                continue;
             }
+# endif
+
+            writer.writeUInt32(0x0);
+            writer.writeUInt64(fStateValues.getLength(i) + 1);
+            writer.writeData(fStateValues.get(i), fStateValues.getLength(i) + 1);
         }
 
-        d_stderr("Failed to find plugin state with key \"%s\"", key);
+        DISTRHO_SAFE_ASSERT(writer.ptr == fStateChunk + chunkSize);
+
+        return chunkSize;
     }
+
+    // Single pass over a chunk from writeStateChunk(), values are used straight from host memory.
+    bool readStateChunk(const char* const chunk, const size_t chunkSize)
+    {
+        VstChunkReader reader(chunk, chunkSize);
+        uint32_t version, paramCount, stateCount;
+
+        reader.readData(4);
+        DISTRHO_SAFE_ASSERT_RETURN(reader.readUInt32(version), false);
+        DISTRHO_SAFE_ASSERT_RETURN(reader.readUInt32(paramCount), false);
+        DISTRHO_SAFE_ASSERT_RETURN(reader.readUInt32(stateCount), false);
+
+        if (version > kVstChunkVersion)
+        {
+            d_stderr2("State chunk version %u is newer than supported version %u", version, kVstChunkVersion);
+            return false;
+        }
+
+        DISTRHO_SAFE_ASSERT_RETURN(reader.remaining / (4 + sizeof(float)) >= paramCount, false);
+
+        const uint32_t count = fPlugin.getParameterCount();
+        uint32_t hash = 0;
+        float fvalue;
+
+        for (uint32_t i=0; i < paramCount; ++i)
+        {
+            reader.readUInt32(hash);
+            reader.readFloat(fvalue);
+
+            // same index unless the parameter list changed since the chunk was saved
+            uint32_t index = i;
+
+            if (index >= count || fPlugin.getParameterSymbolHash(index) != hash)
+            {
+                for (index=0; index < count; ++index)
+                {
+                    if (fPlugin.getParameterSymbolHash(index) == hash)
+                        break;
+                }
+
+                if (index == count)
+                    continue;
+            }
+
+            if (fPlugin.isParameterOutputOrTrigger(index))
+                continue;
+
+            fPlugin.setParameterValue(index, fvalue);
+# if DISTRHO_PLUGIN_HAS_UI
+            if (fVstUI != nullptr)
+                setParameterValueFromPlugin(index, fvalue);
+# endif
+        }
+
+        uint32_t keySize, flags;
+        uint64_t valueSize;
+
+        for (uint32_t i=0; i < stateCount; ++i)
+        {
+            DISTRHO_SAFE_ASSERT_RETURN(reader.readUInt32(keySize) && keySize > 1, false);
+
+            const char* const key = reader.readData(keySize);
+            DISTRHO_SAFE_ASSERT_RETURN(key != nullptr && key[keySize-1] == '\0', false);
+
+            DISTRHO_SAFE_ASSERT_RETURN(reader.readUInt32(flags), false);
+            DISTRHO_SAFE_ASSERT_RETURN(reader.readUInt64(valueSize), false);
+
+            const char* const value = reader.readData(valueSize);
+            DISTRHO_SAFE_ASSERT_RETURN(value != nullptr, false);
+
+            const int32_t index = fPlugin.getStateIndex(key);
+
+            if (flags & kVstChunkStateIsBinary)
+            {
+# if DISTRHO_PLUGIN_WANT_BINARY_STATE
+                if (index >= 0 && fPlugin.isStateBinary(static_cast<uint32_t>(index)))
+                    fPlugin.setBinaryState(key, value, static_cast<size_t>(valueSize));
+# endif
+                continue;
+            }
+
+            DISTRHO_SAFE_ASSERT_CONTINUE(valueSize != 0 && value[valueSize-1] == '\0');
+
+            if (index >= 0 && fPlugin.isStateBinary(static_cast<uint32_t>(index)))
+                continue;
+
+            setStateFromUI(key, value);
+
+# if DISTRHO_PLUGIN_HAS_UI
+            if (fVstUI != nullptr)
+                fVstUI->setStateFromPlugin(key, value);
+# endif
+        }
+
+        return true;
+    }
+
+    // Text chunk of null separated keys and values, states first and then parameters by symbol.
+    bool readLegacyStateChunk(const char* const chunk, const size_t chunkSize)
+    {
+        const char* key   = chunk;
+        const char* value = nullptr;
+        size_t size, bytesRead = 0;
+
+        while (bytesRead < chunkSize)
+        {
+            if (key[0] == '\0')
+                break;
+
+            size  = std::strlen(key)+1;
+            value = key + size;
+            bytesRead += size;
+
+            setStateFromUI(key, value);
+
+# if DISTRHO_PLUGIN_HAS_UI
+            if (fVstUI != nullptr)
+                fVstUI->setStateFromPlugin(key, value);
+# endif
+
+            // get next key
+            size = std::strlen(value)+1;
+            key  = value + size;
+            bytesRead += size;
+        }
+
+        const uint32_t paramCount = fPlugin.getParameterCount();
+
+        if (bytesRead+4 < chunkSize && paramCount != 0)
+        {
+            ++key;
+            float fvalue;
+
+            // temporarily set locale to "C" while converting floats
+            const ScopedSafeLocale ssl;
+
+            while (bytesRead < chunkSize)
+            {
+                if (key[0] == '\0')
+                    break;
+
+                size  = std::strlen(key)+1;
+                value = key + size;
+                bytesRead += size;
+
+                // find parameter with this symbol, and set its value
+                for (uint32_t i=0; i<paramCount; ++i)
+                {
+                    if (fPlugin.isParameterOutputOrTrigger(i))
+                        continue;
+                    if (fPlugin.getParameterSymbol(i) != key)
+                        continue;
+
+                    fvalue = std::atof(value);
+                    fPlugin.setParameterValue(i, fvalue);
+# if DISTRHO_PLUGIN_HAS_UI
+                    if (fVstUI != nullptr)
+                        setParameterValueFromPlugin(i, fvalue);
+# endif
+                    break;
+                }
+
+                // get next key
+                size = std::strlen(value)+1;
+                key  = value + size;
+                bytesRead += size;
+            }
+        }
+
+        return true;
+    }
+
 #endif
 };
 
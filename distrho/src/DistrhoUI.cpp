@@ -95,6 +95,11 @@ void UI::setParameterValue(uint32_t index, float value)
     pData->setParamCallback(index + pData->parameterOffset, value);
 }
 
+void UI::requestParameterMidiLearn(int32_t index)
+{
+    pData->midiLearnCallback(index >= 0 ? index + static_cast<int32_t>(pData->parameterOffset) : -1);
+}
+
 #if DISTRHO_PLUGIN_WANT_STATE
 void UI::setState(const char* key, const char* value)
 {
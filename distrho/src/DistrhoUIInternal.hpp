@@ -48,6 +48,7 @@ typedef void (*setParamFunc)  (void* ptr, uint32_t rindex, float value);
 typedef void (*setStateFunc)  (void* ptr, const char* key, const char* value);
 typedef void (*sendNoteFunc)  (void* ptr, uint8_t channel, uint8_t note, uint8_t velo);
 typedef void (*setSizeFunc)   (void* ptr, uint width, uint height);
+typedef void (*midiLearnFunc) (void* ptr, int32_t rindex);
 
 // -----------------------------------------------------------------------
 // UI private data
@@ -74,6 +75,7 @@ struct UI::PrivateData {
     setStateFunc  setStateCallbackFunc;
     sendNoteFunc  sendNoteCallbackFunc;
     setSizeFunc   setSizeCallbackFunc;
+    midiLearnFunc midiLearnCallbackFunc;
 
     PrivateData(const bool resizable) noexcept
         : sampleRate(d_lastUiSampleRate),
@@ -91,7 +93,8 @@ struct UI::PrivateData {
           setParamCallbackFunc(nullptr),
           setStateCallbackFunc(nullptr),
           sendNoteCallbackFunc(nullptr),
-          setSizeCallbackFunc(nullptr)
+          setSizeCallbackFunc(nullptr),
+          midiLearnCallbackFunc(nullptr)
     {
         DISTRHO_SAFE_ASSERT(d_isNotZero(sampleRate));
 
@@ -141,6 +144,12 @@ struct UI::PrivateData {
         if (setSizeCallbackFunc != nullptr)
             setSizeCallbackFunc(callbacksPtr, width, height);
     }
+
+    void midiLearnCallback(const int32_t rindex)
+    {
+        if (midiLearnCallbackFunc != nullptr)
+            midiLearnCallbackFunc(callbacksPtr, rindex);
+    }
 };
 
 // -----------------------------------------------------------------------
@@ -482,6 +491,14 @@ public:
             fUI->sampleRateChanged(sampleRate);
     }
 
+    // only wrappers that implement MIDI learn set this, UI::requestParameterMidiLearn() does nothing otherwise
+    void setMidiLearnCallback(const midiLearnFunc midiLearnCall)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr,);
+
+        fData->midiLearnCallbackFunc = midiLearnCall;
+    }
+
 private:
 #ifdef HAVE_DGL
     // -------------------------------------------------------------------
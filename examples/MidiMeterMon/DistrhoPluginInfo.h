@@ -27,7 +27,10 @@
 #define DISTRHO_PLUGIN_NUM_OUTPUTS      2
 #define DISTRHO_PLUGIN_WANT_MIDI_INPUT  1
 #define DISTRHO_PLUGIN_WANT_MIDI_OUTPUT 1
+#define DISTRHO_PLUGIN_MIDI_THRU        1
 #define DISTRHO_PLUGIN_WANT_STATE       0
+#define DISTRHO_PLUGIN_WANT_TIMEPOS     1
+#define DISTRHO_PLUGIN_WANT_DIRECT_ACCESS 1
 #define DISTRHO_UI_USE_NANOVG           1
 
 #endif // DISTRHO_PLUGIN_MIDIMETERMON_H_INCLUDED
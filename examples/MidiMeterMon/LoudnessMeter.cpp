@@ -0,0 +1,352 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "LoudnessMeter.hpp"
+
+#include <cmath>
+#include <cstring>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+constexpr float LoudnessMeter::kLoudnessFloor;
+
+static const float kHistogramLowest = -70.0f;
+static const float kHistogramStep   = 0.1f;
+
+static inline
+float energyToLoudness(const double energy) noexcept
+{
+    if (energy <= 0.0)
+        return LoudnessMeter::kLoudnessFloor;
+
+    const float loudness = -0.691f + 10.0f * static_cast<float>(std::log10(energy));
+    return loudness > LoudnessMeter::kLoudnessFloor ? loudness : LoudnessMeter::kLoudnessFloor;
+}
+
+static inline
+float histogramBinLoudness(const uint32_t bin) noexcept
+{
+    return kHistogramLowest + (static_cast<float>(bin) + 0.5f) * kHistogramStep;
+}
+
+static inline
+uint32_t loudnessToHistogramBin(const float loudness, const uint32_t binCount) noexcept
+{
+    if (loudness <= kHistogramLowest)
+        return 0;
+
+    const uint32_t bin = static_cast<uint32_t>((loudness - kHistogramLowest) / kHistogramStep);
+    return bin < binCount ? bin : binCount - 1;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+void LoudnessMeter::Histogram::clear() noexcept
+{
+    std::memset(count, 0, sizeof(count));
+    std::memset(energy, 0, sizeof(energy));
+    total = 0;
+}
+
+void LoudnessMeter::Histogram::add(const float loudness, const double blockEnergy) noexcept
+{
+    const uint32_t bin = loudnessToHistogramBin(loudness, kHistogramBins);
+
+    ++count[bin];
+    energy[bin] += blockEnergy;
+    ++total;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+LoudnessMeter::LoudnessMeter() noexcept
+    : fShelf(),
+      fHighPass(),
+      fBlockSize(4800),
+      fBlockFrames(0),
+      fBlockEnergy(0.0),
+      fBlockPos(0),
+      fBlockCount(0),
+      fMomentarySum(0.0),
+      fShortTermSum(0.0),
+      fMomentary(kLoudnessFloor),
+      fShortTerm(kLoudnessFloor),
+      fIntegrated(kLoudnessFloor),
+      fRange(0.0f)
+{
+    setSampleRate(48000.0);
+}
+
+void LoudnessMeter::setSampleRate(const double sampleRate) noexcept
+{
+    DISTRHO_SAFE_ASSERT_RETURN(sampleRate > 0.0,);
+
+    // BS.1770 pre-filter (high shelf), derived for any sample rate
+    {
+        const double f0 = 1681.974450955533;
+        const double G  = 3.999843853973347;
+        const double Q  = 0.7071752369554196;
+
+        const double K  = std::tan(M_PI * f0 / sampleRate);
+        const double Vh = std::pow(10.0, G / 20.0);
+        const double Vb = std::pow(Vh, 0.4996667741545416);
+        const double a0 = 1.0 + K / Q + K * K;
+
+        fShelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+        fShelf.b1 = 2.0 * (K * K - Vh) / a0;
+        fShelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+        fShelf.a1 = 2.0 * (K * K - 1.0) / a0;
+        fShelf.a2 = (1.0 - K / Q + K * K) / a0;
+    }
+
+    // RLB weighting (high pass)
+    {
+        const double f0 = 38.13547087602444;
+        const double Q  = 0.5003270373238773;
+
+        const double K  = std::tan(M_PI * f0 / sampleRate);
+        const double a0 = 1.0 + K / Q + K * K;
+
+        fHighPass.b0 = 1.0;
+        fHighPass.b1 = -2.0;
+        fHighPass.b2 = 1.0;
+        fHighPass.a1 = 2.0 * (K * K - 1.0) / a0;
+        fHighPass.a2 = (1.0 - K / Q + K * K) / a0;
+    }
+
+    fBlockSize = static_cast<uint32_t>(sampleRate / 10.0 + 0.5);
+
+    if (fBlockSize == 0)
+        fBlockSize = 1;
+
+    reset();
+}
+
+void LoudnessMeter::reset() noexcept
+{
+    std::memset(fShelfState, 0, sizeof(fShelfState));
+    std::memset(fHighPassState, 0, sizeof(fHighPassState));
+    std::memset(fBlocks, 0, sizeof(fBlocks));
+
+    fBlockFrames  = 0;
+    fBlockEnergy  = 0.0;
+    fBlockPos     = 0;
+    fBlockCount   = 0;
+    fMomentarySum = 0.0;
+    fShortTermSum = 0.0;
+
+    fIntegratedHistogram.clear();
+    fRangeHistogram.clear();
+
+    fMomentary  = kLoudnessFloor;
+    fShortTerm  = kLoudnessFloor;
+    fIntegrated = kLoudnessFloor;
+    fRange      = 0.0f;
+}
+
+void LoudnessMeter::process(const float* const* const inputs, uint32_t channelCount, const uint32_t frames) noexcept
+{
+    if (channelCount > LOUDNESS_METER_MAX_CHANNELS)
+        channelCount = LOUDNESS_METER_MAX_CHANNELS;
+
+    const Biquad s(fShelf);
+    const Biquad h(fHighPass);
+
+    for (uint32_t offset = 0; offset < frames;)
+    {
+        // never run past the end of the current 100 ms block
+        uint32_t todo = fBlockSize - fBlockFrames;
+
+        if (todo > frames - offset)
+            todo = frames - offset;
+
+        double energy = 0.0;
+
+        for (uint32_t c = 0; c < channelCount; ++c)
+        {
+            const float* const in(inputs[c] + offset);
+
+            double s1 = fShelfState[c][0], s2 = fShelfState[c][1];
+            double h1 = fHighPassState[c][0], h2 = fHighPassState[c][1];
+
+            for (uint32_t i = 0; i < todo; ++i)
+            {
+                const double x = in[i];
+
+                const double y1 = s.b0 * x + s1;
+                s1 = s.b1 * x - s.a1 * y1 + s2;
+                s2 = s.b2 * x - s.a2 * y1;
+
+                const double y2 = h.b0 * y1 + h1;
+                h1 = h.b1 * y1 - h.a1 * y2 + h2;
+                h2 = h.b2 * y1 - h.a2 * y2;
+
+                energy += y2 * y2;
+            }
+
+            fShelfState[c][0] = s1;
+            fShelfState[c][1] = s2;
+            fHighPassState[c][0] = h1;
+            fHighPassState[c][1] = h2;
+        }
+
+        fBlockEnergy += energy;
+        fBlockFrames += todo;
+        offset += todo;
+
+        if (fBlockFrames == fBlockSize)
+            finishBlock();
+    }
+}
+
+void LoudnessMeter::finishBlock() noexcept
+{
+    const double blockEnergy = fBlockEnergy / fBlockSize;
+
+    fBlockEnergy = 0.0;
+    fBlockFrames = 0;
+
+    // slide both windows by one block
+    const uint32_t momentaryOut = (fBlockPos + kShortTermBlocks - kMomentaryBlocks) % kShortTermBlocks;
+
+    fMomentarySum += blockEnergy - fBlocks[momentaryOut];
+    fShortTermSum += blockEnergy - fBlocks[fBlockPos];
+    fBlocks[fBlockPos] = blockEnergy;
+
+    if (++fBlockPos == kShortTermBlocks)
+    {
+        fBlockPos = 0;
+
+        // recompute the sums once per ring cycle, so rounding errors cannot pile up
+        fMomentarySum = fShortTermSum = 0.0;
+
+        for (uint32_t i = 0; i < kShortTermBlocks; ++i)
+            fShortTermSum += fBlocks[i];
+        for (uint32_t i = kShortTermBlocks - kMomentaryBlocks; i < kShortTermBlocks; ++i)
+            fMomentarySum += fBlocks[i];
+    }
+
+    if (fBlockCount < kShortTermBlocks)
+        ++fBlockCount;
+
+    // momentary, also a 75% overlapping gating block for integrated loudness
+    if (fBlockCount >= kMomentaryBlocks)
+    {
+        const double energy = fMomentarySum / kMomentaryBlocks;
+        fMomentary = energyToLoudness(energy);
+
+        if (fMomentary > kLoudnessFloor)
+        {
+            fIntegratedHistogram.add(fMomentary, energy);
+            updateIntegrated();
+        }
+    }
+
+    // short-term, sampled every block for the loudness range
+    if (fBlockCount >= kShortTermBlocks)
+    {
+        const double energy = fShortTermSum / kShortTermBlocks;
+        fShortTerm = energyToLoudness(energy);
+
+        if (fShortTerm > kLoudnessFloor)
+        {
+            fRangeHistogram.add(fShortTerm, energy);
+            updateRange();
+        }
+    }
+}
+
+void LoudnessMeter::updateIntegrated() noexcept
+{
+    const Histogram& hist(fIntegratedHistogram);
+
+    // relative gate, 10 LU below the loudness of all blocks above the absolute gate
+    double energy = 0.0;
+
+    for (uint32_t i = 0; i < kHistogramBins; ++i)
+        energy += hist.energy[i];
+
+    const float relativeGate = energyToLoudness(energy / hist.total) - 10.0f;
+
+    uint32_t count = 0;
+    energy = 0.0;
+
+    for (uint32_t i = loudnessToHistogramBin(relativeGate, kHistogramBins); i < kHistogramBins; ++i)
+    {
+        count  += hist.count[i];
+        energy += hist.energy[i];
+    }
+
+    fIntegrated = count != 0 ? energyToLoudness(energy / count) : kLoudnessFloor;
+}
+
+void LoudnessMeter::updateRange() noexcept
+{
+    const Histogram& hist(fRangeHistogram);
+
+    // relative gate, 20 LU below the loudness of all short-term values above the absolute gate
+    double energy = 0.0;
+
+    for (uint32_t i = 0; i < kHistogramBins; ++i)
+        energy += hist.energy[i];
+
+    const float relativeGate = energyToLoudness(energy / hist.total) - 20.0f;
+    const uint32_t firstBin  = loudnessToHistogramBin(relativeGate, kHistogramBins);
+
+    uint32_t count = 0;
+
+    for (uint32_t i = firstBin; i < kHistogramBins; ++i)
+        count += hist.count[i];
+
+    if (count == 0)
+    {
+        fRange = 0.0f;
+        return;
+    }
+
+    // 10th and 95th percentiles of the gated values
+    const uint32_t lowIndex  = static_cast<uint32_t>((count - 1) * 0.10 + 0.5);
+    const uint32_t highIndex = static_cast<uint32_t>((count - 1) * 0.95 + 0.5);
+
+    float low = 0.0f, high = 0.0f;
+    uint32_t seen = 0;
+    bool lowFound = false;
+
+    for (uint32_t i = firstBin; i < kHistogramBins; ++i)
+    {
+        seen += hist.count[i];
+
+        if (! lowFound && seen > lowIndex)
+        {
+            low = histogramBinLoudness(i);
+            lowFound = true;
+        }
+
+        if (seen > highIndex)
+        {
+            high = histogramBinLoudness(i);
+            break;
+        }
+    }
+
+    fRange = high - low;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -0,0 +1,159 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef LOUDNESS_METER_HPP_INCLUDED
+#define LOUDNESS_METER_HPP_INCLUDED
+
+#include "DistrhoUtils.hpp"
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+/**
+   Maximum number of channels a LoudnessMeter can measure.
+ */
+#ifndef LOUDNESS_METER_MAX_CHANNELS
+# define LOUDNESS_METER_MAX_CHANNELS 2
+#endif
+
+/**
+   EBU R128 / ITU-R BS.1770 loudness meter.
+
+   Audio is K-weighted and squared into 100 ms blocks.@n
+   The momentary (400 ms) and short-term (3 s) windows are running sums over a ring of those blocks.@n
+   Integrated loudness and loudness range use fixed 0.1 LU histograms,
+   so memory use does not grow with the measurement time.
+
+   All storage is part of the object, process() never allocates.
+   All channels are weighted 1.0, which is correct for mono and stereo.
+ */
+class LoudnessMeter
+{
+public:
+   /**
+      Value reported when there is nothing to measure (silence, or not enough audio yet).
+    */
+    static constexpr float kLoudnessFloor = -70.0f;
+
+    LoudnessMeter() noexcept;
+
+   /**
+      Set the sample rate, this recomputes the filters and resets the measurement.
+    */
+    void setSampleRate(double sampleRate) noexcept;
+
+   /**
+      Reset the measurement, keeping the sample rate.
+    */
+    void reset() noexcept;
+
+   /**
+      Measure @a frames of audio from @a channelCount channels.
+    */
+    void process(const float* const* inputs, uint32_t channelCount, uint32_t frames) noexcept;
+
+   /**
+      Loudness of the last 400 ms, in LUFS.
+    */
+    float getMomentary() const noexcept
+    {
+        return fMomentary;
+    }
+
+   /**
+      Loudness of the last 3 s, in LUFS.
+    */
+    float getShortTerm() const noexcept
+    {
+        return fShortTerm;
+    }
+
+   /**
+      Gated loudness since the last reset, in LUFS.
+    */
+    float getIntegrated() const noexcept
+    {
+        return fIntegrated;
+    }
+
+   /**
+      Loudness range since the last reset, in LU.
+    */
+    float getRange() const noexcept
+    {
+        return fRange;
+    }
+
+private:
+    static const uint32_t kMomentaryBlocks = 4;
+    static const uint32_t kShortTermBlocks = 30;
+    static const uint32_t kHistogramBins   = 1000;
+
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+    };
+
+    struct Histogram {
+        uint32_t count[kHistogramBins];
+        double   energy[kHistogramBins];
+        uint32_t total;
+
+        void clear() noexcept;
+        void add(float loudness, double energy) noexcept;
+    };
+
+    void finishBlock() noexcept;
+    void updateIntegrated() noexcept;
+    void updateRange() noexcept;
+
+    // filters, shared by all channels
+    Biquad fShelf;
+    Biquad fHighPass;
+
+    // filter state per channel, transposed direct form II
+    double fShelfState[LOUDNESS_METER_MAX_CHANNELS][2];
+    double fHighPassState[LOUDNESS_METER_MAX_CHANNELS][2];
+
+    // current 100 ms block
+    uint32_t fBlockSize;
+    uint32_t fBlockFrames;
+    double   fBlockEnergy;
+
+    // last 3 s of block energies
+    double   fBlocks[kShortTermBlocks];
+    uint32_t fBlockPos;
+    uint32_t fBlockCount;
+    double   fMomentarySum;
+    double   fShortTermSum;
+
+    // gating blocks for integrated loudness, short-term values for the range
+    Histogram fIntegratedHistogram;
+    Histogram fRangeHistogram;
+
+    float fMomentary;
+    float fShortTerm;
+    float fIntegrated;
+    float fRange;
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(LoudnessMeter)
+};
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // LOUDNESS_METER_HPP_INCLUDED
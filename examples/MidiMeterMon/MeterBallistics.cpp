@@ -0,0 +1,201 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "MeterBallistics.hpp"
+
+#include <cmath>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+constexpr float MeterBallistics::kDefaultHoldTime;
+constexpr float MeterBallistics::kDefaultReleaseTime;
+constexpr float MeterBallistics::kDefaultPPMAttackTime;
+constexpr float MeterBallistics::kDefaultVURiseTime;
+
+/**
+   The release time is for a fall of this much.
+ */
+static const double kReleaseDecibels = 20.0;
+
+/**
+   Levels below this are treated as silence, avoids denormals on long releases.
+ */
+static const float kSilence = 1e-6f;
+
+// -----------------------------------------------------------------------------------------------------------
+
+MeterBallistics::MeterBallistics() noexcept
+    : fSampleRate(0.0),
+      fMode(kModeDigitalPeak),
+      fHoldFrames(0),
+      fReleaseTime(kDefaultReleaseTime),
+      fPPMAttackTime(kDefaultPPMAttackTime),
+      fVURiseTime(kDefaultVURiseTime)
+{
+    setSampleRate(48000.0);
+    setHoldTime(kDefaultHoldTime);
+}
+
+void MeterBallistics::setSampleRate(const double sampleRate) noexcept
+{
+    DISTRHO_SAFE_ASSERT_RETURN(sampleRate > 0.0,);
+
+    const float holdMilliseconds = fSampleRate > 0.0 ? fHoldFrames * 1000.0 / fSampleRate : kDefaultHoldTime;
+
+    fSampleRate = sampleRate;
+
+    updateCoefficients();
+    setHoldTime(holdMilliseconds);
+}
+
+void MeterBallistics::setMode(const uint32_t mode) noexcept
+{
+    DISTRHO_SAFE_ASSERT_RETURN(mode < kModeCount,);
+
+    fMode = mode;
+}
+
+void MeterBallistics::setHoldTime(const float milliseconds) noexcept
+{
+    fHoldFrames = milliseconds > 0.0f ? static_cast<int32_t>(milliseconds * fSampleRate / 1000.0 + 0.5) : 0;
+}
+
+void MeterBallistics::setReleaseTime(const float milliseconds) noexcept
+{
+    DISTRHO_SAFE_ASSERT_RETURN(milliseconds > 0.0f,);
+
+    fReleaseTime = milliseconds;
+    updateCoefficients();
+}
+
+void MeterBallistics::setPPMAttackTime(const float milliseconds) noexcept
+{
+    DISTRHO_SAFE_ASSERT_RETURN(milliseconds > 0.0f,);
+
+    fPPMAttackTime = milliseconds;
+    updateCoefficients();
+}
+
+void MeterBallistics::setVURiseTime(const float milliseconds) noexcept
+{
+    DISTRHO_SAFE_ASSERT_RETURN(milliseconds > 0.0f,);
+
+    fVURiseTime = milliseconds;
+    updateCoefficients();
+}
+
+void MeterBallistics::updateCoefficients() noexcept
+{
+    const double releaseFrames   = fReleaseTime   * fSampleRate / 1000.0;
+    const double attackPPMFrames = fPPMAttackTime * fSampleRate / 1000.0;
+    const double riseVUFrames    = fVURiseTime    * fSampleRate / 1000.0;
+
+    const double releasePerFrame   = std::pow(10.0, -kReleaseDecibels / 20.0 / releaseFrames);
+    const double attackPPMPerFrame = std::exp(-1.0 / attackPPMFrames);
+    const double attackVUPerFrame  = std::exp(std::log(0.01) / riseVUFrames);
+
+    for (uint32_t i = 0; i < kSubBlockSize; ++i)
+    {
+        const double frames = i + 1;
+
+        fRelease[i]   = static_cast<float>(std::pow(releasePerFrame, frames));
+        fAttackPPM[i] = static_cast<float>(1.0 - std::pow(attackPPMPerFrame, frames));
+        fAttackVU[i]  = static_cast<float>(1.0 - std::pow(attackVUPerFrame, frames));
+    }
+}
+
+/**
+   The loops below have no branches on channel data, only selects, so they vectorize across channels.
+ */
+void MeterBallistics::processSubBlock(float* const level, float* const hold, int32_t* const holdCounter,
+                                      const float* const peak, const float* const mean,
+                                      const uint32_t channels, const uint32_t frames) const noexcept
+{
+    DISTRHO_SAFE_ASSERT_RETURN(frames != 0 && frames <= kSubBlockSize,);
+
+    const float release = fRelease[frames - 1];
+    const int32_t elapsed = static_cast<int32_t>(frames);
+
+    switch (fMode)
+    {
+    case kModeDigitalPeak:
+        for (uint32_t c = 0; c < channels; ++c)
+            level[c] = std::fmax(peak[c], level[c] * release);
+        break;
+
+    case kModePPM: {
+        const float attack = fAttackPPM[frames - 1];
+
+        for (uint32_t c = 0; c < channels; ++c)
+            level[c] = peak[c] > level[c] ? level[c] + (peak[c] - level[c]) * attack : level[c] * release;
+        break;
+    }
+
+    case kModeVU: {
+        // symmetric integration of the rectified signal, like the needle
+        const float attack = fAttackVU[frames - 1];
+
+        for (uint32_t c = 0; c < channels; ++c)
+            level[c] += (mean[c] - level[c]) * attack;
+        break;
+    }
+    }
+
+    const int32_t holdFrames = fHoldFrames;
+
+    for (uint32_t c = 0; c < channels; ++c)
+    {
+        const float   value   = level[c] < kSilence ? 0.0f : level[c];
+        const float   held    = hold[c];
+        const int32_t counter = holdCounter[c];
+
+        const bool    rising   = value >= held;
+        const bool    holding  = counter > elapsed;
+        const float   released = holding ? held : std::fmax(value, held * release);
+        const int32_t remaining = holding ? counter - elapsed : 0;
+
+        level[c] = value;
+        hold[c] = rising ? value : released;
+        holdCounter[c] = rising ? holdFrames : remaining;
+    }
+}
+
+void MeterBallistics::applyPeaks(float* const level, float* const hold, int32_t* const holdCounter,
+                                 const float* const peak, const uint32_t channels) const noexcept
+{
+    if (fMode != kModeDigitalPeak)
+        return;
+
+    const int32_t holdFrames = fHoldFrames;
+
+    for (uint32_t c = 0; c < channels; ++c)
+    {
+        const float   value   = std::fmax(peak[c], level[c]);
+        const float   held    = hold[c];
+        const int32_t counter = holdCounter[c];
+        const bool    rising  = value >= held;
+
+        level[c] = value;
+        hold[c] = rising ? value : held;
+        holdCounter[c] = rising ? holdFrames : counter;
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
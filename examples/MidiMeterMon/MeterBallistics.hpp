@@ -0,0 +1,150 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef METER_BALLISTICS_HPP_INCLUDED
+#define METER_BALLISTICS_HPP_INCLUDED
+
+#include "DistrhoUtils.hpp"
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+/**
+   Meter ballistics, evaluated on the audio thread.
+
+   This class holds the mode and the coefficients, which are the same for every channel.
+   The per-channel state (level, hold and hold counter) is owned by the caller as one array per
+   member, so a single call updates all channels of a bus and the loops vectorize across channels.
+
+   Audio is processed in sub-blocks of kSubBlockSize frames, the attack and release of each
+   sub-block use coefficients precomputed for its exact length, so the result does not depend
+   on the host block size or on how often the UI reads it.
+
+   Modes, with the default times:
+    - Digital peak: instant attack, release of 20 dB in 1.7 s.
+    - PPM (IEC 60268-10 type I): a 10 ms burst reads about -1 dB, release of 20 dB in 1.7 s.
+    - VU: rectified average reaching 99% in 300 ms, rising and falling at the same rate.
+
+   The hold value follows the highest level, stays there for the hold time then falls at the release rate.
+ */
+class MeterBallistics
+{
+public:
+    enum Mode {
+        kModeDigitalPeak = 0,
+        kModePPM,
+        kModeVU,
+        kModeCount
+    };
+
+    static const uint32_t kSubBlockSize = 16;
+
+   /**
+      Default hold time, in milliseconds.
+    */
+    static constexpr float kDefaultHoldTime = 1500.0f;
+
+   /**
+      Default time for the release of all modes to fall 20 dB, in milliseconds.
+    */
+    static constexpr float kDefaultReleaseTime = 1700.0f;
+
+   /**
+      Default PPM attack time constant, in milliseconds.
+    */
+    static constexpr float kDefaultPPMAttackTime = 4.0f;
+
+   /**
+      Default VU time to reach 99% of a step, in milliseconds.
+    */
+    static constexpr float kDefaultVURiseTime = 300.0f;
+
+    MeterBallistics() noexcept;
+
+   /**
+      Set the sample rate and recompute the coefficients.
+      The caller should reset its channel state afterwards.
+    */
+    void setSampleRate(double sampleRate) noexcept;
+
+   /**
+      Change the ballistics mode, the current levels are kept.
+    */
+    void setMode(uint32_t mode) noexcept;
+
+   /**
+      Change the hold time, in milliseconds.
+    */
+    void setHoldTime(float milliseconds) noexcept;
+
+   /**
+      Change the release time (20 dB fall) of all modes, in milliseconds.
+    */
+    void setReleaseTime(float milliseconds) noexcept;
+
+   /**
+      Change the PPM attack time constant, in milliseconds.
+    */
+    void setPPMAttackTime(float milliseconds) noexcept;
+
+   /**
+      Change the VU rise time (to 99%), in milliseconds.
+    */
+    void setVURiseTime(float milliseconds) noexcept;
+
+    uint32_t getMode() const noexcept
+    {
+        return fMode;
+    }
+
+   /**
+      Run one sub-block of @a frames samples (1 to kSubBlockSize) for @a channels channels.
+      @a peak and @a mean are the absolute peak and the rectified average of each channel over the sub-block.
+    */
+    void processSubBlock(float* level, float* hold, int32_t* holdCounter,
+                         const float* peak, const float* mean, uint32_t channels, uint32_t frames) const noexcept;
+
+   /**
+      Feed externally measured peaks (for example true peaks) with instant attack.
+      Only used in digital peak mode, the other modes are defined on the samples themselves.
+    */
+    void applyPeaks(float* level, float* hold, int32_t* holdCounter,
+                    const float* peak, uint32_t channels) const noexcept;
+
+private:
+    void updateCoefficients() noexcept;
+
+    // coefficients for sub-blocks of 1 to kSubBlockSize frames, index is frames - 1
+    float fRelease[kSubBlockSize];
+    float fAttackPPM[kSubBlockSize];
+    float fAttackVU[kSubBlockSize];
+
+    double   fSampleRate;
+    uint32_t fMode;
+    int32_t  fHoldFrames;
+    float    fReleaseTime;
+    float    fPPMAttackTime;
+    float    fVURiseTime;
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(MeterBallistics)
+};
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // METER_BALLISTICS_HPP_INCLUDED
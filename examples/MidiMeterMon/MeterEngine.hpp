@@ -0,0 +1,263 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef METER_ENGINE_HPP_INCLUDED
+#define METER_ENGINE_HPP_INCLUDED
+
+#include "MeterBallistics.hpp"
+#include "MeterKernel.hpp"
+#include "TruePeakMeter.hpp"
+
+#include <cmath>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+/**
+   Meters for a bus of @a kChannels channels.
+
+   Per-channel state is stored as one array per value (structure of arrays) instead of one object per channel.
+   Samples are read once, per channel, by the vectorized MeterKernel, which also gives the peak and
+   average of each sub-block. Ballistics, hold and peak updates then run once per sub-block over all
+   channels at once, so they vectorize across channels.
+
+   All storage is part of the object, process() never allocates.
+ */
+template <uint32_t kChannels>
+class MeterEngine
+{
+public:
+    static_assert(kChannels > 0, "A meter engine needs at least one channel");
+
+    MeterEngine() noexcept
+        : fBallistics(),
+          fTruePeakMeters(),
+          fTruePeakEnabled(false)
+    {
+        reset();
+    }
+
+   /**
+      Set the sample rate, recomputes the ballistics and resets the meters.
+    */
+    void setSampleRate(const double sampleRate) noexcept
+    {
+        fBallistics.setSampleRate(sampleRate);
+        reset();
+    }
+
+   /**
+      Change the ballistics mode, see MeterBallistics::Mode.
+    */
+    void setMode(const uint32_t mode) noexcept
+    {
+        fBallistics.setMode(mode);
+    }
+
+   /**
+      Change the peak hold time, in milliseconds.
+    */
+    void setHoldTime(const float milliseconds) noexcept
+    {
+        fBallistics.setHoldTime(milliseconds);
+    }
+
+   /**
+      Change the ballistics times, in milliseconds, see MeterBallistics.
+    */
+    void setReleaseTime(const float milliseconds) noexcept
+    {
+        fBallistics.setReleaseTime(milliseconds);
+    }
+
+    void setPPMAttackTime(const float milliseconds) noexcept
+    {
+        fBallistics.setPPMAttackTime(milliseconds);
+    }
+
+    void setVURiseTime(const float milliseconds) noexcept
+    {
+        fBallistics.setVURiseTime(milliseconds);
+    }
+
+   /**
+      Enable or disable true-peak detection.
+      The filter history is cleared when it gets enabled, so it does not start from stale audio.
+    */
+    void setTruePeakEnabled(const bool enabled) noexcept
+    {
+        if (enabled && ! fTruePeakEnabled)
+        {
+            for (uint32_t c = 0; c < kChannels; ++c)
+                fTruePeakMeters[c].reset();
+        }
+
+        fTruePeakEnabled = enabled;
+    }
+
+   /**
+      Reset levels, holds and clip counters.
+    */
+    void reset() noexcept
+    {
+        for (uint32_t c = 0; c < kChannels; ++c)
+        {
+            fLevel[c] = 0.0f;
+            fHold[c] = 0.0f;
+            fHoldCounter[c] = 0;
+            fPeak[c] = 0.0f;
+            fTruePeak[c] = 0.0f;
+            fRms[c] = 0.0f;
+            fClipCount[c] = 0;
+            fFirstClipFrame[c] = -1;
+        }
+    }
+
+   /**
+      Measure @a frames of audio, copying each input to its output in the same pass.
+      @a outputs may be null, see meterProcessBlock() for the rules of each buffer.
+    */
+    void process(const float* const* const inputs, float* const* const outputs, const uint32_t frames) noexcept
+    {
+        if (frames == 0)
+            return;
+
+        MeterBlockStats stats;
+        float sumOfSquares[kChannels];
+
+        // sub-block values straight from the kernel, per channel
+        float subPeaks[kChannels][kChunkSubBlocks];
+        float subMeans[kChannels][kChunkSubBlocks];
+
+        // the same values across channels, as MeterBallistics takes them
+        float subPeak[kChannels];
+        float subMean[kChannels];
+
+        for (uint32_t c = 0; c < kChannels; ++c)
+        {
+            fPeak[c] = 0.0f;
+            fFirstClipFrame[c] = -1;
+            sumOfSquares[c] = 0.0f;
+        }
+
+        for (uint32_t offset = 0; offset < frames; offset += kChunkSize)
+        {
+            const uint32_t todo = frames - offset < kChunkSize ? frames - offset : kChunkSize;
+
+            for (uint32_t c = 0; c < kChannels; ++c)
+            {
+                meterProcessBlock(inputs[c] + offset, outputs != nullptr ? outputs[c] + offset : nullptr, todo, stats,
+                                  subPeaks[c], subMeans[c]);
+
+                fPeak[c] = std::fmax(fPeak[c], stats.peak);
+                sumOfSquares[c] += stats.sumOfSquares;
+                fClipCount[c] += stats.clipCount;
+
+                if (fFirstClipFrame[c] < 0 && stats.firstClipFrame >= 0)
+                    fFirstClipFrame[c] = static_cast<int32_t>(offset) + stats.firstClipFrame;
+            }
+
+            for (uint32_t s = 0, subOffset = 0; subOffset < todo; ++s, subOffset += kMeterSubBlockSize)
+            {
+                for (uint32_t c = 0; c < kChannels; ++c)
+                {
+                    subPeak[c] = subPeaks[c][s];
+                    subMean[c] = subMeans[c][s];
+                }
+
+                const uint32_t subFrames = todo - subOffset < kMeterSubBlockSize ? todo - subOffset
+                                                                                 : kMeterSubBlockSize;
+
+                fBallistics.processSubBlock(fLevel, fHold, fHoldCounter, subPeak, subMean, kChannels, subFrames);
+            }
+        }
+
+        for (uint32_t c = 0; c < kChannels; ++c)
+            fRms[c] = std::sqrt(sumOfSquares[c] / frames);
+
+        if (! fTruePeakEnabled)
+            return;
+
+        for (uint32_t c = 0; c < kChannels; ++c)
+        {
+            fTruePeak[c] = fTruePeakMeters[c].process(inputs[c], frames);
+            fPeak[c] = std::fmax(fPeak[c], fTruePeak[c]);
+        }
+
+        fBallistics.applyPeaks(fLevel, fHold, fHoldCounter, fPeak, kChannels);
+    }
+
+   /**
+      Ballistic level and hold of each channel (linear).
+    */
+    const float* getLevels() const noexcept { return fLevel; }
+    const float* getHolds()  const noexcept { return fHold;  }
+
+   /**
+      Highest absolute value of each channel over the last block (linear),
+      including interpolated samples while true-peak detection is enabled.
+    */
+    const float* getPeaks() const noexcept { return fPeak; }
+
+   /**
+      Highest interpolated value of each channel over the last block (linear), only valid while enabled.
+    */
+    const float* getTruePeaks() const noexcept { return fTruePeak; }
+
+   /**
+      RMS of each channel over the last block (linear).
+    */
+    const float* getRms() const noexcept { return fRms; }
+
+   /**
+      Clipped samples counted since the last reset, per channel.
+    */
+    const uint64_t* getClipCounts() const noexcept { return fClipCount; }
+
+   /**
+      Frame of the first clipped sample of the last block per channel, or -1 if it did not clip.
+    */
+    const int32_t* getFirstClipFrames() const noexcept { return fFirstClipFrame; }
+
+private:
+    static_assert(MeterBallistics::kSubBlockSize == kMeterSubBlockSize, "Ballistics and kernel sub-blocks must match");
+
+    // audio is measured in chunks, so the sub-block values of any host block size fit on the stack
+    static const uint32_t kChunkSubBlocks = 64;
+    static const uint32_t kChunkSize = kChunkSubBlocks * kMeterSubBlockSize;
+
+    MeterBallistics fBallistics;
+    TruePeakMeter fTruePeakMeters[kChannels];
+    bool fTruePeakEnabled;
+
+    float    fLevel[kChannels];
+    float    fHold[kChannels];
+    int32_t  fHoldCounter[kChannels];
+    float    fPeak[kChannels];
+    float    fTruePeak[kChannels];
+    float    fRms[kChannels];
+    uint64_t fClipCount[kChannels];
+    int32_t  fFirstClipFrame[kChannels];
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(MeterEngine)
+};
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // METER_ENGINE_HPP_INCLUDED
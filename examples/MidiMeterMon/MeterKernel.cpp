@@ -0,0 +1,379 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "MeterKernel.hpp"
+
+#include <cmath>
+
+#if defined(__SSE2__)
+# define METER_KERNEL_HAVE_SSE2 1
+# include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && ! defined(__APPLE__)
+# define METER_KERNEL_HAVE_AVX2 1
+# include <immintrin.h>
+#endif
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+// Scalar version, also used for the tail of the vector versions
+
+// With kSub, @a i must be at the start of a sub-block
+template <bool kCopy, bool kSub>
+static inline
+void meterProcessScalar(const float* const input, float* const output, uint32_t i, const uint32_t frames,
+                        MeterBlockStats& stats, float* const subPeaks, float* const subMeans) noexcept
+{
+    float peak = stats.peak;
+    float sum  = stats.sumOfSquares;
+    float subPeak = 0.0f, subSum = 0.0f;
+
+    for (; i < frames; ++i)
+    {
+        const float x = input[i];
+        const float a = std::fabs(x);
+
+        if (kCopy)
+            output[i] = x;
+
+        peak = std::fmax(peak, a);
+        sum += x * x;
+
+        if (a >= 1.0f)
+        {
+            if (stats.firstClipFrame < 0)
+                stats.firstClipFrame = static_cast<int32_t>(i);
+            ++stats.clipCount;
+        }
+
+        if (kSub)
+        {
+            subPeak = std::fmax(subPeak, a);
+            subSum += a;
+
+            if ((i + 1) % kMeterSubBlockSize == 0 || i + 1 == frames)
+            {
+                const uint32_t s = i / kMeterSubBlockSize;
+
+                subPeaks[s] = subPeak;
+                subMeans[s] = subSum / static_cast<float>(i + 1 - s * kMeterSubBlockSize);
+                subPeak = subSum = 0.0f;
+            }
+        }
+    }
+
+    stats.peak = peak;
+    stats.sumOfSquares = sum;
+}
+
+static void meterProcessBlockScalar(const float* const input, float* const output, const uint32_t frames,
+                                    MeterBlockStats& stats, float* const subPeaks, float* const subMeans) noexcept
+{
+    const bool copy = output != nullptr && output != input;
+
+    if (subPeaks != nullptr)
+    {
+        if (copy)
+            meterProcessScalar<true, true>(input, output, 0, frames, stats, subPeaks, subMeans);
+        else
+            meterProcessScalar<false, true>(input, output, 0, frames, stats, subPeaks, subMeans);
+    }
+    else
+    {
+        if (copy)
+            meterProcessScalar<true, false>(input, output, 0, frames, stats, subPeaks, subMeans);
+        else
+            meterProcessScalar<false, false>(input, output, 0, frames, stats, subPeaks, subMeans);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------
+// SSE2 version, 8 frames at a time
+
+#ifdef METER_KERNEL_HAVE_SSE2
+static inline
+float horizontalMax(__m128 v) noexcept
+{
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+static inline
+float horizontalSum(__m128 v) noexcept
+{
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+template <bool kCopy, bool kSub>
+static inline
+void meterProcessSSE2(const float* const input, float* const output, const uint32_t frames,
+                      MeterBlockStats& stats, float* const subPeaks, float* const subMeans) noexcept
+{
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 one     = _mm_set1_ps(1.0f);
+
+    // a sub-block is two iterations, leave a partial one to the scalar tail
+    const uint32_t end = kSub ? frames - frames % kMeterSubBlockSize : frames;
+
+    __m128 peak = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    __m128 sum2 = _mm_setzero_ps();
+    __m128 subPeak = _mm_setzero_ps();
+    __m128 subSum  = _mm_setzero_ps();
+    uint32_t i  = 0;
+
+    for (; i + 8 <= end; i += 8)
+    {
+        const __m128 x1 = _mm_loadu_ps(input + i);
+        const __m128 x2 = _mm_loadu_ps(input + i + 4);
+
+        if (kCopy)
+        {
+            _mm_storeu_ps(output + i,     x1);
+            _mm_storeu_ps(output + i + 4, x2);
+        }
+
+        const __m128 a1 = _mm_and_ps(x1, absMask);
+        const __m128 a2 = _mm_and_ps(x2, absMask);
+
+        peak = _mm_max_ps(peak, _mm_max_ps(a1, a2));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(x1, x1));
+        sum2 = _mm_add_ps(sum2, _mm_mul_ps(x2, x2));
+
+        const uint32_t clipMask = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmpge_ps(a1, one)))
+                                | static_cast<uint32_t>(_mm_movemask_ps(_mm_cmpge_ps(a2, one))) << 4;
+
+        if (clipMask != 0)
+        {
+            if (stats.firstClipFrame < 0)
+                stats.firstClipFrame = static_cast<int32_t>(i + __builtin_ctz(clipMask));
+            stats.clipCount += static_cast<uint32_t>(__builtin_popcount(clipMask));
+        }
+
+        if (kSub)
+        {
+            subPeak = _mm_max_ps(subPeak, _mm_max_ps(a1, a2));
+            subSum  = _mm_add_ps(subSum, _mm_add_ps(a1, a2));
+
+            if ((i + 8) % kMeterSubBlockSize == 0)
+            {
+                subPeaks[i / kMeterSubBlockSize] = horizontalMax(subPeak);
+                subMeans[i / kMeterSubBlockSize] = horizontalSum(subSum) / kMeterSubBlockSize;
+                subPeak = subSum = _mm_setzero_ps();
+            }
+        }
+    }
+
+    stats.peak = std::fmax(stats.peak, horizontalMax(peak));
+    stats.sumOfSquares += horizontalSum(_mm_add_ps(sum1, sum2));
+
+    meterProcessScalar<kCopy, kSub>(input, output, i, frames, stats, subPeaks, subMeans);
+}
+
+static void meterProcessBlockSSE2(const float* const input, float* const output, const uint32_t frames,
+                                  MeterBlockStats& stats, float* const subPeaks, float* const subMeans) noexcept
+{
+    const bool copy = output != nullptr && output != input;
+
+    if (subPeaks != nullptr)
+    {
+        if (copy)
+            meterProcessSSE2<true, true>(input, output, frames, stats, subPeaks, subMeans);
+        else
+            meterProcessSSE2<false, true>(input, output, frames, stats, subPeaks, subMeans);
+    }
+    else
+    {
+        if (copy)
+            meterProcessSSE2<true, false>(input, output, frames, stats, subPeaks, subMeans);
+        else
+            meterProcessSSE2<false, false>(input, output, frames, stats, subPeaks, subMeans);
+    }
+}
+#endif
+
+// -----------------------------------------------------------------------------------------------------------
+// AVX2 version, 16 frames (one sub-block) at a time, only used if the CPU supports it
+
+#ifdef METER_KERNEL_HAVE_AVX2
+__attribute__((target("avx2")))
+static inline
+float horizontalMax256(const __m256 v) noexcept
+{
+    __m128 h = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    h = _mm_max_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_max_ss(h, _mm_shuffle_ps(h, h, 1));
+    return _mm_cvtss_f32(h);
+}
+
+__attribute__((target("avx2")))
+static inline
+float horizontalSum256(const __m256 v) noexcept
+{
+    __m128 h = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_add_ss(h, _mm_shuffle_ps(h, h, 1));
+    return _mm_cvtss_f32(h);
+}
+
+template <bool kCopy, bool kSub>
+__attribute__((target("avx2")))
+static inline
+void meterProcessAVX2(const float* const input, float* const output, const uint32_t frames,
+                      MeterBlockStats& stats, float* const subPeaks, float* const subMeans) noexcept
+{
+    static_assert(kMeterSubBlockSize == 16, "AVX2 loop works on exactly one sub-block per iteration");
+
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 one     = _mm256_set1_ps(1.0f);
+
+    __m256 peak = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    __m256 sum2 = _mm256_setzero_ps();
+    uint32_t i  = 0;
+
+    for (; i + 16 <= frames; i += 16)
+    {
+        const __m256 x1 = _mm256_loadu_ps(input + i);
+        const __m256 x2 = _mm256_loadu_ps(input + i + 8);
+
+        if (kCopy)
+        {
+            _mm256_storeu_ps(output + i,     x1);
+            _mm256_storeu_ps(output + i + 8, x2);
+        }
+
+        const __m256 a1 = _mm256_and_ps(x1, absMask);
+        const __m256 a2 = _mm256_and_ps(x2, absMask);
+        const __m256 a  = _mm256_max_ps(a1, a2);
+
+        peak = _mm256_max_ps(peak, a);
+        sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(x1, x1));
+        sum2 = _mm256_add_ps(sum2, _mm256_mul_ps(x2, x2));
+
+        const uint32_t clipMask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(a1, one, _CMP_GE_OQ)))
+                                | static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(a2, one, _CMP_GE_OQ))) << 8;
+
+        if (clipMask != 0)
+        {
+            if (stats.firstClipFrame < 0)
+                stats.firstClipFrame = static_cast<int32_t>(i + __builtin_ctz(clipMask));
+            stats.clipCount += static_cast<uint32_t>(__builtin_popcount(clipMask));
+        }
+
+        if (kSub)
+        {
+            subPeaks[i / kMeterSubBlockSize] = horizontalMax256(a);
+            subMeans[i / kMeterSubBlockSize] = horizontalSum256(_mm256_add_ps(a1, a2)) / kMeterSubBlockSize;
+        }
+    }
+
+    stats.peak = std::fmax(stats.peak, horizontalMax256(peak));
+
+    float lanes[8];
+    _mm256_storeu_ps(lanes, _mm256_add_ps(sum1, sum2));
+    stats.sumOfSquares += ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3]))
+                        + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+
+    meterProcessScalar<kCopy, kSub>(input, output, i, frames, stats, subPeaks, subMeans);
+}
+
+__attribute__((target("avx2")))
+static void meterProcessBlockAVX2(const float* const input, float* const output, const uint32_t frames,
+                                  MeterBlockStats& stats, float* const subPeaks, float* const subMeans) noexcept
+{
+    const bool copy = output != nullptr && output != input;
+
+    if (subPeaks != nullptr)
+    {
+        if (copy)
+            meterProcessAVX2<true, true>(input, output, frames, stats, subPeaks, subMeans);
+        else
+            meterProcessAVX2<false, true>(input, output, frames, stats, subPeaks, subMeans);
+    }
+    else
+    {
+        if (copy)
+            meterProcessAVX2<true, false>(input, output, frames, stats, subPeaks, subMeans);
+        else
+            meterProcessAVX2<false, false>(input, output, frames, stats, subPeaks, subMeans);
+    }
+}
+#endif
+
+// -----------------------------------------------------------------------------------------------------------
+// Runtime selection
+
+typedef void (*MeterKernelFunc)(const float*, float*, uint32_t, MeterBlockStats&, float*, float*);
+
+struct MeterKernel {
+    MeterKernelFunc func;
+    const char* name;
+
+    MeterKernel() noexcept
+        : func(meterProcessBlockScalar),
+          name("scalar")
+    {
+#ifdef METER_KERNEL_HAVE_SSE2
+        func = meterProcessBlockSSE2;
+        name = "sse2";
+#endif
+#ifdef METER_KERNEL_HAVE_AVX2
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx2"))
+        {
+            func = meterProcessBlockAVX2;
+            name = "avx2";
+        }
+#endif
+    }
+};
+
+static const MeterKernel sMeterKernel;
+
+void meterProcessBlock(const float* const input, float* const output, const uint32_t frames,
+                       MeterBlockStats& stats) noexcept
+{
+    meterProcessBlock(input, output, frames, stats, nullptr, nullptr);
+}
+
+void meterProcessBlock(const float* const input, float* const output, const uint32_t frames,
+                       MeterBlockStats& stats, float* const subPeaks, float* const subMeans) noexcept
+{
+    DISTRHO_SAFE_ASSERT_RETURN((subPeaks == nullptr) == (subMeans == nullptr),);
+
+    stats.peak = 0.0f;
+    stats.sumOfSquares = 0.0f;
+    stats.clipCount = 0;
+    stats.firstClipFrame = -1;
+
+    sMeterKernel.func(input, output, frames, stats, subPeaks, subMeans);
+}
+
+const char* getMeterKernelName() noexcept
+{
+    return sMeterKernel.name;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
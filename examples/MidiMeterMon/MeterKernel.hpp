@@ -0,0 +1,84 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef METER_KERNEL_HPP_INCLUDED
+#define METER_KERNEL_HPP_INCLUDED
+
+#include "DistrhoUtils.hpp"
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+/**
+   Number of frames in a meter sub-block, see meterProcessBlock().
+ */
+static const uint32_t kMeterSubBlockSize = 16;
+
+/**
+   Statistics of one channel over one block of audio.
+ */
+struct MeterBlockStats {
+   /**
+      Highest absolute sample value.
+    */
+    float peak;
+
+   /**
+      Sum of the squared samples, divide by the frame count and take the square root for RMS.
+    */
+    float sumOfSquares;
+
+   /**
+      Number of samples with an absolute value of 1.0 or more.
+    */
+    uint32_t clipCount;
+
+   /**
+      Frame of the first clipped sample, or -1 if the block did not clip.
+    */
+    int32_t firstClipFrame;
+};
+
+/**
+   Measure one channel of audio, copying it to @a output in the same pass.@n
+   @a output may be null or equal to @a input, in which case nothing is copied.
+   Partially overlapping buffers are not supported.
+
+   The implementation (scalar, SSE2 or AVX2) is chosen once at runtime from what the CPU supports.
+ */
+void meterProcessBlock(const float* input, float* output, uint32_t frames, MeterBlockStats& stats) noexcept;
+
+/**
+   Same as above, also writing the absolute peak and the rectified average of every kMeterSubBlockSize frames
+   to @a subPeaks and @a subMeans, which need room for (frames + kMeterSubBlockSize - 1) / kMeterSubBlockSize values.
+   The last sub-block may be shorter, its average is over the frames it has.
+
+   This feeds the meter ballistics without a second pass over the audio.
+ */
+void meterProcessBlock(const float* input, float* output, uint32_t frames, MeterBlockStats& stats,
+                       float* subPeaks, float* subMeans) noexcept;
+
+/**
+   Get the name of the implementation used by meterProcessBlock(), for logging.
+ */
+const char* getMeterKernelName() noexcept;
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // METER_KERNEL_HPP_INCLUDED
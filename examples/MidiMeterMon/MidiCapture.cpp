@@ -0,0 +1,411 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "MidiCapture.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+/**
+   The writer polls the ring this often while it is empty, in milliseconds.
+ */
+static const uint kPollInterval = 5;
+
+/**
+   Encoded events are written to the file in batches of up to this many bytes.@n
+   A smaller batch is written once the ring is empty and it is at least kFlushSize bytes or kFlushPolls polls old.
+ */
+static const uint32_t kBufferSize = 64 * 1024;
+static const uint32_t kFlushSize  = 16 * 1024;
+static const uint32_t kFlushPolls = 50;
+
+/**
+   Largest delta time a variable-length quantity can hold, longer gaps are split with empty text events.
+ */
+static const uint32_t kMaxDelta = 0x0FFFFFFF;
+
+static void writeBigEndian(uint8_t* const data, const uint32_t value, const uint32_t size) noexcept
+{
+    for (uint32_t i = 0; i < size; ++i)
+        data[i] = static_cast<uint8_t>(value >> (8 * (size - 1 - i)));
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+MidiCaptureWriter::MidiCaptureWriter(MidiCaptureStatus& status)
+    : Thread("MidiCaptureWriter"),
+      fStatus(status),
+      fRing(MIDIMETERMON_CAPTURE_RING_SIZE),
+      fOversizedEvents(0),
+      fDirectory(),
+      fRecord(new uint8_t[sizeof(RecordHeader) + kMaxEventSize]),
+      fBuffer(new uint8_t[kBufferSize]),
+      fBufferUsed(0),
+      fFile(nullptr),
+      fTrackLengthOffset(0),
+      fFileSize(0),
+      fFileStart(0),
+      fLastTime(0),
+      fSampleRate(0.0),
+      fCapturing(false),
+      fFileSequence(0),
+      fIdlePolls(0),
+      fDroppedEvents(0)
+{
+    const char* const directory = std::getenv("MIDIMETERMON_CAPTURE_DIR");
+
+    setDirectory(directory != nullptr && directory[0] != '\0' ? directory : ".");
+}
+
+MidiCaptureWriter::~MidiCaptureWriter()
+{
+    stopThread(-1);
+    closeFile();
+
+    delete[] fRecord;
+    delete[] fBuffer;
+}
+
+void MidiCaptureWriter::setDirectory(const char* const directory)
+{
+    DISTRHO_SAFE_ASSERT_RETURN(directory != nullptr,);
+    DISTRHO_SAFE_ASSERT_RETURN(! isThreadRunning(),);
+
+    fDirectory = directory;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+// audio thread side
+
+bool MidiCaptureWriter::start(const uint64_t time, const double sampleRate) noexcept
+{
+    const RecordHeader header = { time, kRecordStart };
+
+    return fRing.push(&header, sizeof(header), &sampleRate, sizeof(sampleRate));
+}
+
+bool MidiCaptureWriter::write(const uint64_t time, const MidiEvent& midiEvent) noexcept
+{
+    // the writer cannot pop it, do not let it take ring space from the events that fit
+    if (midiEvent.size > kMaxEventSize)
+    {
+        fOversizedEvents.store(fOversizedEvents.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const uint8_t* const data = midiEvent.size > MidiEvent::kDataSize ? midiEvent.dataExt : midiEvent.data;
+    DISTRHO_SAFE_ASSERT_RETURN(data != nullptr, false);
+
+    const RecordHeader header = { time, kRecordEvent };
+
+    return fRing.push(&header, sizeof(header), data, midiEvent.size);
+}
+
+bool MidiCaptureWriter::stop(const uint64_t time) noexcept
+{
+    const RecordHeader header = { time, kRecordStop };
+
+    return fRing.push(&header, sizeof(header), nullptr, 0);
+}
+
+// -----------------------------------------------------------------------------------------------------------
+// writer thread side
+
+void MidiCaptureWriter::run()
+{
+    while (! shouldThreadExit())
+    {
+        if (drain())
+            continue;
+
+        if (fBufferUsed != 0 && (fBufferUsed >= kFlushSize || ++fIdlePolls >= kFlushPolls))
+            flush();
+
+        d_msleep(kPollInterval);
+    }
+
+    // the host stopped us, keep everything already queued
+    while (drain()) {}
+
+    closeFile();
+    fCapturing = false;
+}
+
+bool MidiCaptureWriter::drain()
+{
+    const uint32_t recordBufferSize = sizeof(RecordHeader) + kMaxEventSize;
+    bool drained = false;
+
+    for (uint32_t size; (size = fRing.pop(fRecord, recordBufferSize)) != 0;)
+    {
+        drained = true;
+
+        if (size > recordBufferSize)
+        {
+            ++fDroppedEvents;
+            continue;
+        }
+
+        RecordHeader header;
+        std::memcpy(&header, fRecord, sizeof(header));
+
+        processRecord(header, fRecord + sizeof(header), size - static_cast<uint32_t>(sizeof(header)));
+
+        if (fBufferUsed >= kBufferSize / 2)
+            flush();
+    }
+
+    fStatus.eventsDropped.store(fRing.getDroppedCount() + fOversizedEvents.load(std::memory_order_relaxed)
+                                + fDroppedEvents, std::memory_order_relaxed);
+    return drained;
+}
+
+void MidiCaptureWriter::processRecord(const RecordHeader& header, const uint8_t* const data, const uint32_t size)
+{
+    switch (header.type)
+    {
+    case kRecordStart:
+        closeFile();
+        DISTRHO_SAFE_ASSERT_BREAK(size == sizeof(double));
+
+        std::memcpy(&fSampleRate, data, sizeof(double));
+        fCapturing = fSampleRate > 0.0;
+
+        if (fCapturing)
+            openFile(header.time);
+        break;
+
+    case kRecordEvent:
+        if (fFile != nullptr
+            && (fFileSize >= MIDIMETERMON_CAPTURE_MAX_FILE_SIZE
+                || header.time - fFileStart >= static_cast<uint64_t>(MIDIMETERMON_CAPTURE_MAX_FILE_TIME * fSampleRate)))
+        {
+            closeFile();
+            openFile(header.time);
+        }
+
+        if (fFile == nullptr)
+        {
+            ++fDroppedEvents;
+            break;
+        }
+
+        writeEvent(header.time, data, size);
+        break;
+
+    case kRecordStop:
+        closeFile();
+        fCapturing = false;
+        break;
+    }
+}
+
+bool MidiCaptureWriter::openFile(const uint64_t time)
+{
+    DISTRHO_SAFE_ASSERT_RETURN(fFile == nullptr, false);
+
+    char timestamp[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(timestamp, sizeof(timestamp), "%Y%m%d-%H%M%S", std::localtime(&now));
+
+    char filename[64];
+    std::snprintf(filename, sizeof(filename), "/midimetermon-%s-%03u.mid", timestamp, ++fFileSequence);
+
+    const String path(fDirectory + filename);
+
+    fFile = std::fopen(path, "wb");
+
+    if (fFile == nullptr)
+    {
+        d_stderr2("MidiMeterMon: cannot open capture file '%s'", path.buffer());
+        fStatus.errors.store(fStatus.errors.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // batches are written directly, the file does not need its own buffer
+    std::setvbuf(fFile, nullptr, _IONBF, 0);
+
+    // one tick per frame: ticks per quarter note must fit 15 bits, the tempo makes up for the rest
+    const uint32_t sampleRate = static_cast<uint32_t>(fSampleRate + 0.5);
+    uint32_t division = sampleRate;
+
+    while (division > 0x7FFF && division % 2 == 0)
+        division /= 2;
+    if (division > 0x7FFF)
+        division = 0x7FFF;
+
+    const uint32_t tempo = static_cast<uint32_t>(std::llround(division * 1000000.0 / fSampleRate));
+
+    fBufferUsed = 0;
+    fFileSize   = 0;
+    fFileStart  = time;
+    fLastTime   = time;
+    fIdlePolls  = 0;
+
+    // header, format 1 with 2 tracks
+    uint8_t header[14] = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 1, 0, 2 };
+    writeBigEndian(header + 12, division, 2);
+    writeBytes(header, sizeof(header));
+
+    // track 0, tempo and name
+    static const char kTrackName[] = "MidiMeterMon capture";
+    static const uint32_t kTrackNameSize = sizeof(kTrackName) - 1;
+
+    uint8_t conductor[8 + 7 + 4 + kTrackNameSize + 4] = { 'M', 'T', 'r', 'k' };
+    writeBigEndian(conductor + 4, sizeof(conductor) - 8, 4);
+
+    uint8_t* event = conductor + 8;
+    event[0] = 0x00; event[1] = 0xFF; event[2] = 0x51; event[3] = 0x03;
+    writeBigEndian(event + 4, tempo, 3);
+    event += 7;
+    event[0] = 0x00; event[1] = 0xFF; event[2] = 0x03; event[3] = kTrackNameSize;
+    std::memcpy(event + 4, kTrackName, kTrackNameSize);
+    event += 4 + kTrackNameSize;
+    event[0] = 0x00; event[1] = 0xFF; event[2] = 0x2F; event[3] = 0x00;
+    writeBytes(conductor, sizeof(conductor));
+
+    // track 1, the length is written when the file is closed
+    static const uint8_t kTrackHeader[8] = { 'M', 'T', 'r', 'k', 0, 0, 0, 0 };
+    fTrackLengthOffset = static_cast<long>(fFileSize + 4);
+    writeBytes(kTrackHeader, sizeof(kTrackHeader));
+
+    fStatus.files.store(fStatus.files.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    fStatus.recording.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void MidiCaptureWriter::closeFile()
+{
+    if (fFile == nullptr)
+        return;
+
+    static const uint8_t kEndOfTrack[4] = { 0x00, 0xFF, 0x2F, 0x00 };
+    writeBytes(kEndOfTrack, sizeof(kEndOfTrack));
+    flush();
+
+    uint8_t length[4];
+    writeBigEndian(length, static_cast<uint32_t>(fFileSize - fTrackLengthOffset - 4), 4);
+
+    if (std::fseek(fFile, fTrackLengthOffset, SEEK_SET) != 0 || std::fwrite(length, 1, 4, fFile) != 4)
+        fStatus.errors.store(fStatus.errors.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    std::fclose(fFile);
+    fFile = nullptr;
+
+    fStatus.recording.store(false, std::memory_order_relaxed);
+}
+
+void MidiCaptureWriter::writeEvent(const uint64_t time, const uint8_t* const data, const uint32_t size)
+{
+    if (size == 0)
+        return;
+
+    const uint8_t status = data[0];
+
+    writeDelta(time);
+
+    if (status >= 0x80 && status < 0xF0)
+    {
+        writeBytes(data, size);
+    }
+    else if (status == 0xF0)
+    {
+        writeBytes(data, 1);
+        writeVariableLength(size - 1);
+        writeBytes(data + 1, size - 1);
+    }
+    else
+    {
+        // system common and real-time messages (and stray data bytes) have no SMF form, write them escaped
+        static const uint8_t kEscape = 0xF7;
+        writeBytes(&kEscape, 1);
+        writeVariableLength(size);
+        writeBytes(data, size);
+    }
+
+    fStatus.eventsWritten.store(fStatus.eventsWritten.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void MidiCaptureWriter::writeDelta(const uint64_t time)
+{
+    uint64_t delta = time > fLastTime ? time - fLastTime : 0;
+    fLastTime = time > fLastTime ? time : fLastTime;
+
+    static const uint8_t kEmptyText[3] = { 0xFF, 0x01, 0x00 };
+
+    for (; delta > kMaxDelta; delta -= kMaxDelta)
+    {
+        writeVariableLength(kMaxDelta);
+        writeBytes(kEmptyText, sizeof(kEmptyText));
+    }
+
+    writeVariableLength(static_cast<uint32_t>(delta));
+}
+
+void MidiCaptureWriter::writeVariableLength(const uint32_t value)
+{
+    uint8_t data[5];
+    uint32_t size = 0;
+
+    for (uint32_t shift = 28; shift != 0; shift -= 7)
+    {
+        if (value >> shift || size != 0)
+            data[size++] = static_cast<uint8_t>(((value >> shift) & 0x7F) | 0x80);
+    }
+
+    data[size++] = static_cast<uint8_t>(value & 0x7F);
+    writeBytes(data, size);
+}
+
+void MidiCaptureWriter::writeBytes(const void* const data, const uint32_t size)
+{
+    if (fBufferUsed + size > kBufferSize)
+        flush();
+
+    fFileSize += size;
+
+    if (size > kBufferSize)
+    {
+        if (std::fwrite(data, 1, size, fFile) != size)
+            fStatus.errors.store(fStatus.errors.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    std::memcpy(fBuffer + fBufferUsed, data, size);
+    fBufferUsed += size;
+}
+
+void MidiCaptureWriter::flush()
+{
+    fIdlePolls = 0;
+
+    if (fBufferUsed == 0 || fFile == nullptr)
+        return;
+
+    if (std::fwrite(fBuffer, 1, fBufferUsed, fFile) != fBufferUsed)
+        fStatus.errors.store(fStatus.errors.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    fBufferUsed = 0;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
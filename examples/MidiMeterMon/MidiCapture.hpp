@@ -0,0 +1,172 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef MIDI_CAPTURE_HPP_INCLUDED
+#define MIDI_CAPTURE_HPP_INCLUDED
+
+#include "DistrhoPlugin.hpp"
+#include "SpscRecordRing.hpp"
+#include "extra/String.hpp"
+#include "extra/Thread.hpp"
+
+#include <cstdio>
+
+/**
+ * Size in bytes of the ring between the audio thread and the capture writer.
+ * The writer drains it every few milliseconds, events that do not fit are dropped and counted.
+ */
+#ifndef MIDIMETERMON_CAPTURE_RING_SIZE
+# define MIDIMETERMON_CAPTURE_RING_SIZE (1024 * 1024)
+#endif
+
+/**
+ * Capture files are closed and a new one started past this size (in bytes) or this duration (in seconds).
+ */
+#ifndef MIDIMETERMON_CAPTURE_MAX_FILE_SIZE
+# define MIDIMETERMON_CAPTURE_MAX_FILE_SIZE (64 * 1024 * 1024)
+#endif
+
+#ifndef MIDIMETERMON_CAPTURE_MAX_FILE_TIME
+# define MIDIMETERMON_CAPTURE_MAX_FILE_TIME 3600
+#endif
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+/**
+   Capture progress, written by the capture writer thread and read by anyone.
+ */
+struct MidiCaptureStatus {
+    std::atomic<bool>     recording;
+    std::atomic<uint32_t> files;
+    std::atomic<uint32_t> errors;
+    std::atomic<uint64_t> eventsWritten;
+    std::atomic<uint64_t> eventsDropped;
+
+    MidiCaptureStatus() noexcept
+        : recording(false),
+          files(0),
+          errors(0),
+          eventsWritten(0),
+          eventsDropped(0) {}
+};
+
+/**
+   Streams MIDI events to Standard MIDI Files (format 1) from a background thread.
+
+   The audio thread only calls start(), write() and stop(), which push records into a preallocated
+   SpscRecordRing and never block. The writer thread polls the ring, encodes the events and writes
+   them in large batches. Files go to the directory named by the MIDIMETERMON_CAPTURE_DIR environment
+   variable (the current directory if unset), and are rotated by size and duration.
+
+   Files use one tick per audio frame, so event times are kept exactly.
+   Track 0 holds the tempo that makes this possible, track 1 the events.
+ */
+class MidiCaptureWriter : public Thread
+{
+public:
+   /**
+      Largest event that can be captured, in bytes. Larger SysEx messages are dropped and counted.
+    */
+    static const uint32_t kMaxEventSize = 65536;
+
+    explicit MidiCaptureWriter(MidiCaptureStatus& status);
+    ~MidiCaptureWriter() override;
+
+   /**
+      Set the directory files are written to, instead of MIDIMETERMON_CAPTURE_DIR.
+      Only call while the writer thread is stopped.
+    */
+    void setDirectory(const char* directory);
+
+   /**
+      Start a new capture file at absolute frame @a time, audio thread side.
+      Returns false if the ring is full, the caller should try again later.
+    */
+    bool start(uint64_t time, double sampleRate) noexcept;
+
+   /**
+      Queue one event at absolute frame @a time, audio thread side.
+      SysEx data is copied from MidiEvent::dataExt. Returns false if the event was dropped.
+    */
+    bool write(uint64_t time, const MidiEvent& midiEvent) noexcept;
+
+   /**
+      Close the current capture file at absolute frame @a time, audio thread side.
+      Returns false if the ring is full, the caller should try again later.
+    */
+    bool stop(uint64_t time) noexcept;
+
+protected:
+    void run() override;
+
+private:
+    enum RecordType {
+        kRecordStart = 0,
+        kRecordEvent,
+        kRecordStop
+    };
+
+    struct RecordHeader {
+        uint64_t time;
+        uint32_t type;
+    };
+
+    bool drain();
+    void processRecord(const RecordHeader& header, const uint8_t* data, uint32_t size);
+
+    bool openFile(uint64_t time);
+    void closeFile();
+    void writeEvent(uint64_t time, const uint8_t* data, uint32_t size);
+    void writeDelta(uint64_t time);
+    void writeVariableLength(uint32_t value);
+    void writeBytes(const void* data, uint32_t size);
+    void flush();
+
+    MidiCaptureStatus& fStatus;
+    SpscRecordRing fRing;
+
+    // events larger than kMaxEventSize, audio thread only writes it
+    std::atomic<uint64_t> fOversizedEvents;
+
+    // writer thread only
+    String fDirectory;
+    uint8_t* const fRecord;
+    uint8_t* const fBuffer;
+    uint32_t fBufferUsed;
+
+    std::FILE* fFile;
+    long     fTrackLengthOffset;
+    uint64_t fFileSize;
+    uint64_t fFileStart;
+    uint64_t fLastTime;
+    double   fSampleRate;
+    bool     fCapturing;
+    uint32_t fFileSequence;
+    uint32_t fIdlePolls;
+
+    // events dropped by the writer itself: no file to write to, or a record it could not pop
+    uint64_t fDroppedEvents;
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(MidiCaptureWriter)
+};
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // MIDI_CAPTURE_HPP_INCLUDED
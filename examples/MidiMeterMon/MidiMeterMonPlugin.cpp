@@ -1,332 +1,631 @@
-/*
- * DISTRHO Plugin Framework (DPF)
- * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
- *
- * Permission to use, copy, modify, and/or distribute this software for any purpose with
- * or without fee is hereby granted, provided that the above copyright notice and this
- * permission notice appear in all copies.
- *
- * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
- * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
- * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
- * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
- * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
- * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
- */
-
-#include <iostream>
-#include <limits>
-#include "DistrhoPlugin.hpp"
-#include "MidiMeterMonUI.hpp"
-
-START_NAMESPACE_DISTRHO
-
-// -----------------------------------------------------------------------------------------------------------
-
-/**
-  Plugin to display midi events.
- */
-class MidiMeterMonitorPlugin : public Plugin
-{
-public:
-    MidiMeterMonitorPlugin()
-        : Plugin(cParameterCount, 0, 0),
-          fNeedsReset(true),
-          fParameters { }
-          {
-
-          }
-
-protected:
-   /* --------------------------------------------------------------------------------------------------------
-    * Information */
-
-   /**
-      Get the plugin label.
-    */
-    const char* getLabel() const override
-    {
-        return "MidiMeterMon";
-    }
-
-   /**
-      Get an extensive comment/description about the plugin.
-    */
-    const char* getDescription() const override
-    {
-        return "Plugin to display midi events.";
-    }
-
-   /**
-      Get the plugin author/maker.
-    */
-    const char* getMaker() const override
-    {
-        return "DISTRHO";
-    }
-
-   /**
-      Get the plugin homepage.
-    */
-    const char* getHomePage() const override
-    {
-        return "https://davisc.cjdmidimon.com/place_holder";
-    }
-
-   /**
-      Get the plugin license name (a single line of text).
-      For commercial plugins this should return some short copyright information.
-    */
-    const char* getLicense() const override
-    {
-        return "ISC";
-    }
-
-   /**
-      Get the plugin version, in hexadecimal.
-    */
-    uint32_t getVersion() const override
-    {
-        return d_version(1, 0, 0);
-    }
-
-   /**
-      Get the plugin unique Id.
-      This value is used by LADSPA, DSSI and VST plugin formats.
-    */
-    int64_t getUniqueId() const override
-    {
-        return d_cconst('C', 'j', 'D', 'm');
-    }
-
-   /* --------------------------------------------------------------------------------------------------------
-    * Init and Internal data, unused in this plugin */
-
-    void  initParameter(uint32_t index, Parameter& parameter) override 
-    {
-       /**
-          All parameters in this plugin have the same ranges.
-        */
-
-
-       /**
-          Set parameter data.
-        */
-        switch (index)
-        {
-        case cParameterOutLeft:
-            parameter.hints  = kParameterIsAutomable|kParameterIsOutput;
-            parameter.name   = "out-left";
-            parameter.symbol = "out_left";
-            parameter.ranges.min = 0.0f;
-            parameter.ranges.max = 1.0f;
-            parameter.ranges.def = 0.0f;
-            break;
-        case cParameterOutRight:
-            parameter.hints  = kParameterIsAutomable|kParameterIsOutput;
-            parameter.name   = "out-right";
-            parameter.symbol = "out_right";
-            parameter.ranges.min = 0.0f;
-            parameter.ranges.max = 1.0f;
-            parameter.ranges.def = 0.0f;
-            break;
-        case cParameterMidiMessage1:
-            parameter.hints  = kParameterIsAutomable|kParameterIsOutput;
-            parameter.name   = "midi-msg1";
-            parameter.symbol = "midi_msg1";
-            parameter.ranges.min = std::numeric_limits<float>::lowest();
-            parameter.ranges.max = std::numeric_limits<float>::max();
-            parameter.ranges.def = 0.0f;
-            break;
-        case cParameterMidiMessage2:
-            parameter.hints  = kParameterIsAutomable|kParameterIsOutput;
-            parameter.name   = "midi-msg2";
-            parameter.symbol = "midi_msg2";
-            parameter.ranges.min = std::numeric_limits<float>::lowest();
-            parameter.ranges.max = std::numeric_limits<float>::max();
-            parameter.ranges.def = 0.0f;
-            break;
-        case cParameterMidiMessage3:
-            parameter.hints  = kParameterIsAutomable|kParameterIsOutput;
-            parameter.name   = "midi-msg3";
-            parameter.symbol = "midi_msg3";
-            parameter.ranges.min = std::numeric_limits<float>::lowest();
-            parameter.ranges.max = std::numeric_limits<float>::max();
-            parameter.ranges.def = 0.0f;
-            break;
-        case cParameterMidiMessage4:
-            parameter.hints  = kParameterIsAutomable|kParameterIsOutput;
-            parameter.name   = "midi-msg4";
-            parameter.symbol = "midi_msg4";
-            parameter.ranges.min = std::numeric_limits<float>::lowest();
-            parameter.ranges.max = std::numeric_limits<float>::max();
-            parameter.ranges.def = 0.0f;
-            break;
-        }
-    }
-
-    float getParameterValue(uint32_t index) const   override 
-    { 
-        switch (index) 
-        {
-        case cParameterOutLeft:      return fParameters[cParameterOutLeft];
-        case cParameterOutRight:     return fParameters[cParameterOutRight];
-        case cParameterMidiMessage1: return fParameters[cParameterMidiMessage1];
-        case cParameterMidiMessage2: return fParameters[cParameterMidiMessage2];
-        case cParameterMidiMessage3: return fParameters[cParameterMidiMessage3];
-        case cParameterMidiMessage4: return fParameters[cParameterMidiMessage4];
-        }
-        return 0.0f;
-    }
-
-    /**
-     * This is only for input parameters
-     * Will not be used (I think)
-     */
-    void  setParameterValue(uint32_t, float)  override {}
-
-   /* --------------------------------------------------------------------------------------------------------
-    * Audio/MIDI Processing */
-
-   /**
-      Run/process function for plugins without MIDI input.
-    */
-    void run(const float** inputs, float** outputs, uint32_t frames)
-    {
-        float tmp;
-        float tmpLeft  = 0.0f;
-        float tmpRight = 0.0f;
-
-        for (uint32_t i=0; i<frames; ++i)
-        {
-            // left
-            tmp = std::abs(inputs[0][i]);
-
-            if (tmp > tmpLeft)
-                tmpLeft = tmp;
-
-            // right
-            tmp = std::abs(inputs[1][i]);
-
-            if (tmp > tmpRight)
-                tmpRight = tmp;
-        }
-
-        if (tmpLeft > 1.0f)
-            tmpLeft = 1.0f;
-        if (tmpRight > 1.0f)
-            tmpRight = 1.0f;
-
-        // if (fNeedsReset)
-        // {
-            fParameters[cParameterOutLeft]  = tmpLeft;
-            fParameters[cParameterOutRight] = tmpRight;
-            // fNeedsReset = false;
-        // }
-        // else
-        // {
-        //     if (tmpLeft > fParameters[cParameterOutLeft])
-        //         fParameters[cParameterOutLeft] = tmpLeft;
-        //     if (tmpRight > fParameters[cParameterOutRight])
-        //         fParameters[cParameterOutRight] = tmpRight;
-        // }
-
-        // copy inputs over outputs if needed
-        if (outputs[0] != inputs[0])
-            std::memcpy(outputs[0], inputs[0], sizeof(float)*frames);
-
-        if (outputs[1] != inputs[1])
-            std::memcpy(outputs[1], inputs[1], sizeof(float)*frames);
-    }
-
-    void run(const float** inputs, float** outputs, uint32_t frames,
-                     const MidiEvent* midiEvents, uint32_t midiEventCount) override 
-    {
-        //process the audio events to capture audio meter values
-        run(inputs, outputs, frames);
-        
-        //Exit if nothing to do
-        if (midiEventCount == 0) return;
-
-        //Variables used for type punning a midi message as a float 
-        uint8_t messageBytes[sizeof(float)] = {0};
-        float messagePacked = { };
-
-        //Convert midi messages to float parameters the UI can consume
-        for (uint32_t i = 0; i < midiEventCount; i++)
-        {
-            if (midiEvents[i].size <= midiEvents[i].kDataSize)
-            {
-                //Pack midi message bytes into a float using type punning
-                std::memset(&messageBytes,0,sizeof(float));
-                for (uint32_t data_ctr = 0; data_ctr < midiEvents[i].size; data_ctr++) {
-                    messageBytes[data_ctr] = midiEvents[i].data[data_ctr];
-                }
-                messagePacked = reinterpret_cast<float&>(messageBytes);
-
-                //Slide existing messages down
-                for (uint8_t pcount = MIDI_PARAMETER_OFFSET + MIDI_PARAMETER_COUNT - 1; pcount > MIDI_PARAMETER_OFFSET; pcount--) 
-                {
-                    fParameters[pcount] = fParameters[pcount - 1];
-                }
-                // Add new event at the top
-                fParameters[MIDI_PARAMETER_OFFSET] = messagePacked;
-
-                #if defined(VERBOSE_LOGGING)
-                auto bytesFromPun = reinterpret_cast<uint8_t*>(&messagePacked);
-                std::cout << "[0x" << std::hex << ((bytesFromPun[0] & 0xF0)>>4) << std::hex << (bytesFromPun[0] & 0x0F) << "]" 
-                         << " [" << std::dec << (uint32_t)bytesFromPun[0] << "]" ;     
-                std::cout << "[0x" << std::hex << ((bytesFromPun[1] & 0xF0)>>4) << std::hex << (bytesFromPun[1] & 0x0F) << "]"
-                         << " [" << std::dec << (uint32_t)bytesFromPun[1] << "]";     
-                if (midiEvents[i].size > 2) 
-                {
-                    std::cout << "[0x" << std::hex << ((bytesFromPun[2] & 0xF0)>>4) << std::hex << (bytesFromPun[2] & 0x0F) << "]"
-                            << " [" << std::dec << (uint32_t)bytesFromPun[2] << "]";     
-                }             
-                std::cout << std::endl;   
-                #endif             
-            }            
-            writeMidiEvent(midiEvents[i]);
-            
-        }
-        #if defined(VERBOSE_LOGGING)
-        std::cout << "fParameters: ";
-        for (uint8_t pcount = MIDI_PARAMETER_OFFSET; pcount < cParameterCount; pcount++)
-        {
-            std::cout << fParameters[pcount] << " "; 
-        }
-        std::cout << std::endl;
-        #endif             
-    }                     
-
-   // -------------------------------------------------------------------------------------------------------
-
-private:
-   /**
-      Boolean used to reset meter values.
-      The UI will send a "reset" message which sets this as true.
-    */
-    volatile bool fNeedsReset;
-
-    /**
-     * Parameters
-     */
-    volatile float fParameters[cParameterCount];
-
-   /**
-      Set our plugin class as non-copyable and add a leak detector just in case.
-    */
-    DISTRHO_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiMeterMonitorPlugin)
-};
-
-/* ------------------------------------------------------------------------------------------------------------
- * Plugin entry point, called by DPF to create a new plugin instance. */
-
-Plugin* createPlugin()
-{
-    return new MidiMeterMonitorPlugin();
-}
-
-// -----------------------------------------------------------------------------------------------------------
-
-END_NAMESPACE_DISTRHO
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "DistrhoPlugin.hpp"
+#include "LoudnessMeter.hpp"
+#include "MeterEngine.hpp"
+#include "MidiTiming.hpp"
+#include "MidiMeterMonUI.hpp"
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+/**
+  Clip counters saturate here, the largest integer a float parameter holds exactly.
+ */
+static const float kMaxClipCount = 16777216.0f;
+
+/**
+  Upper bound of the loudness outputs, in LUFS.
+ */
+static const float kMaxLoudness = 10.0f;
+
+/**
+  Range of the true-peak outputs, in dBTP.
+ */
+static const float kMinDecibels = -70.0f;
+static const float kMaxTruePeak = 12.0f;
+
+/**
+  MIDI statistics and timing are published to the UI at most this often, in seconds.
+ */
+static const double kStatisticsInterval = 0.01;
+
+/**
+  Name and symbol prefixes of the per-channel parameters, see ChannelParameters.
+ */
+static const char* const kChannelParameterNames[cChannelParameterCount] = {
+    "out", "rms", "clips", "true-peak", "hold"
+};
+
+static const char* const kChannelParameterSymbols[cChannelParameterCount] = {
+    "out", "rms", "clips", "true_peak", "hold"
+};
+
+// -----------------------------------------------------------------------------------------------------------
+
+/**
+  Plugin to display midi events.
+ */
+class MidiMeterMonitorPlugin : public Plugin
+{
+public:
+    MidiMeterMonitorPlugin()
+        : Plugin(cParameterCount, 0, 0),
+          fNeedsReset(true),
+          fParameters { },
+          fFrameCounter(0),
+          fStatistics(),
+          fStatisticsPublished(0),
+          fTiming(),
+          fMeters(),
+          fMeterMode(MeterBallistics::kModeDigitalPeak),
+          fHoldTime(MeterBallistics::kDefaultHoldTime),
+          fLoudness(),
+          fShared(),
+          fCapture(fShared.capture),
+          fCapturing(false)
+          {
+              fLoudness.setSampleRate(getSampleRate());
+              fMeters.setSampleRate(getSampleRate());
+              fTiming.setSampleRate(getSampleRate());
+
+              fParameters[cParameterMeterMode]          = MeterBallistics::kModeDigitalPeak;
+              fParameters[cParameterPeakHoldTime]       = MeterBallistics::kDefaultHoldTime;
+
+              fParameters[cParameterLoudnessMomentary]  = LoudnessMeter::kLoudnessFloor;
+              fParameters[cParameterLoudnessShortTerm]  = LoudnessMeter::kLoudnessFloor;
+              fParameters[cParameterLoudnessIntegrated] = LoudnessMeter::kLoudnessFloor;
+
+              for (uint32_t c = 0; c < DISTRHO_PLUGIN_NUM_INPUTS; ++c)
+                  fParameters[channelParameter(cChannelParameterTruePeak, c)] = kMinDecibels;
+          }
+
+protected:
+   /* --------------------------------------------------------------------------------------------------------
+    * Information */
+
+   /**
+      Get the plugin label.
+    */
+    const char* getLabel() const override
+    {
+        return DISTRHO_PLUGIN_NAME;
+    }
+
+   /**
+      Get an extensive comment/description about the plugin.
+    */
+    const char* getDescription() const override
+    {
+        return "Plugin to display midi events.";
+    }
+
+   /**
+      Get the plugin author/maker.
+    */
+    const char* getMaker() const override
+    {
+        return "DISTRHO";
+    }
+
+   /**
+      Get the plugin homepage.
+    */
+    const char* getHomePage() const override
+    {
+        return "https://davisc.cjdmidimon.com/place_holder";
+    }
+
+   /**
+      Get the plugin license name (a single line of text).
+      For commercial plugins this should return some short copyright information.
+    */
+    const char* getLicense() const override
+    {
+        return "ISC";
+    }
+
+   /**
+      Get the plugin version, in hexadecimal.
+    */
+    uint32_t getVersion() const override
+    {
+        return d_version(1, 0, 0);
+    }
+
+   /**
+      Get the plugin unique Id.
+      This value is used by LADSPA, DSSI and VST plugin formats.
+    */
+    int64_t getUniqueId() const override
+    {
+#if DISTRHO_PLUGIN_NUM_INPUTS == 2
+        return d_cconst('C', 'j', 'D', 'm');
+#else
+        return d_cconst('C', 'j', 'D', 'B');
+#endif
+    }
+
+   /* --------------------------------------------------------------------------------------------------------
+    * Init and Internal data, unused in this plugin */
+
+    void  initParameter(uint32_t index, Parameter& parameter) override 
+    {
+       /**
+          All parameters in this plugin have the same ranges.
+        */
+
+
+       /**
+          Set parameter data.
+        */
+        switch (index)
+        {
+        case cParameterLoudnessReset:
+            parameter.hints  = kParameterIsAutomable|kParameterIsTrigger;
+            parameter.name   = "loudness-reset";
+            parameter.symbol = "loudness_reset";
+            parameter.ranges.min = 0.0f;
+            parameter.ranges.max = 1.0f;
+            parameter.ranges.def = 0.0f;
+            break;
+        case cParameterPeakMode:
+            parameter.hints  = kParameterIsAutomable|kParameterIsInteger;
+            parameter.name   = "peak-mode";
+            parameter.symbol = "peak_mode";
+            parameter.ranges.min = cPeakModeSample;
+            parameter.ranges.max = cPeakModeTrue;
+            parameter.ranges.def = cPeakModeSample;
+            parameter.enumValues.count = 2;
+            parameter.enumValues.restrictedMode = true;
+            {
+                ParameterEnumerationValue* const values = new ParameterEnumerationValue[2];
+                parameter.enumValues.values = values;
+
+                values[0].label = "Sample peak";
+                values[0].value = cPeakModeSample;
+                values[1].label = "True peak";
+                values[1].value = cPeakModeTrue;
+            }
+            break;
+        case cParameterMeterMode:
+            parameter.hints  = kParameterIsAutomable|kParameterIsInteger;
+            parameter.name   = "meter-mode";
+            parameter.symbol = "meter_mode";
+            parameter.ranges.min = MeterBallistics::kModeDigitalPeak;
+            parameter.ranges.max = MeterBallistics::kModeVU;
+            parameter.ranges.def = MeterBallistics::kModeDigitalPeak;
+            parameter.enumValues.count = 3;
+            parameter.enumValues.restrictedMode = true;
+            {
+                ParameterEnumerationValue* const values = new ParameterEnumerationValue[3];
+                parameter.enumValues.values = values;
+
+                values[0].label = "Digital peak";
+                values[0].value = MeterBallistics::kModeDigitalPeak;
+                values[1].label = "PPM";
+                values[1].value = MeterBallistics::kModePPM;
+                values[2].label = "VU";
+                values[2].value = MeterBallistics::kModeVU;
+            }
+            break;
+        case cParameterPeakHoldTime:
+            parameter.hints  = kParameterIsAutomable;
+            parameter.name   = "peak-hold";
+            parameter.symbol = "peak_hold";
+            parameter.unit   = "ms";
+            parameter.ranges.min = 0.0f;
+            parameter.ranges.max = 10000.0f;
+            parameter.ranges.def = MeterBallistics::kDefaultHoldTime;
+            break;
+        case cParameterCapture:
+            parameter.hints  = kParameterIsAutomable|kParameterIsBoolean;
+            parameter.name   = "capture";
+            parameter.symbol = "capture";
+            parameter.ranges.min = 0.0f;
+            parameter.ranges.max = 1.0f;
+            parameter.ranges.def = 0.0f;
+            break;
+        case cParameterLoudnessMomentary:
+            parameter.hints  = kParameterIsAutomable|kParameterIsOutput;
+            parameter.name   = "loudness-momentary";
+            parameter.symbol = "loudness_momentary";
+            parameter.unit   = "LUFS";
+            parameter.ranges.min = LoudnessMeter::kLoudnessFloor;
+            parameter.ranges.max = kMaxLoudness;
+            parameter.ranges.def = LoudnessMeter::kLoudnessFloor;
+            break;
+        case cParameterLoudnessShortTerm:
+            parameter.hints  = kParameterIsAutomable|kParameterIsOutput;
+            parameter.name   = "loudness-short-term";
+            parameter.symbol = "loudness_short_term";
+            parameter.unit   = "LUFS";
+            parameter.ranges.min = LoudnessMeter::kLoudnessFloor;
+            parameter.ranges.max = kMaxLoudness;
+            parameter.ranges.def = LoudnessMeter::kLoudnessFloor;
+            break;
+        case cParameterLoudnessIntegrated:
+            parameter.hints  = kParameterIsAutomable|kParameterIsOutput;
+            parameter.name   = "loudness-integrated";
+            parameter.symbol = "loudness_integrated";
+            parameter.unit   = "LUFS";
+            parameter.ranges.min = LoudnessMeter::kLoudnessFloor;
+            parameter.ranges.max = kMaxLoudness;
+            parameter.ranges.def = LoudnessMeter::kLoudnessFloor;
+            break;
+        case cParameterLoudnessRange:
+            parameter.hints  = kParameterIsAutomable|kParameterIsOutput;
+            parameter.name   = "loudness-range";
+            parameter.symbol = "loudness_range";
+            parameter.unit   = "LU";
+            parameter.ranges.min = 0.0f;
+            parameter.ranges.max = kMaxLoudness - LoudnessMeter::kLoudnessFloor;
+            parameter.ranges.def = 0.0f;
+            break;
+        default:
+            initChannelParameter(index - cParameterChannelStart, parameter);
+            break;
+        }
+    }
+
+    float getParameterValue(uint32_t index) const override
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(index < cParameterCount, 0.0f);
+
+        return fParameters[index];
+    }
+
+   /**
+      Change a parameter value.
+      A loudness reset request and the meter settings are handled at the start of the next run.
+    */
+    void setParameterValue(uint32_t index, float value) override
+    {
+        switch (index)
+        {
+        case cParameterLoudnessReset:
+            if (value > 0.5f)
+                fNeedsReset = true;
+            break;
+        case cParameterPeakMode:
+        case cParameterMeterMode:
+        case cParameterPeakHoldTime:
+        case cParameterCapture:
+            fParameters[index] = value;
+            break;
+        }
+    }
+
+   /* --------------------------------------------------------------------------------------------------------
+    * Callbacks (optional) */
+
+   /**
+      Optional callback to inform the plugin about a sample rate change.
+    */
+    void sampleRateChanged(double newSampleRate) override
+    {
+        fLoudness.setSampleRate(newSampleRate);
+        fMeters.setSampleRate(newSampleRate);
+        fTiming.setSampleRate(newSampleRate);
+    }
+
+   /**
+      Start the capture writer thread, it stays idle until capture is enabled.
+    */
+    void activate() override
+    {
+        fCapture.startThread();
+    }
+
+   /**
+      Close the current capture file and stop the writer thread.
+      Everything queued before this point is still written.
+    */
+    void deactivate() override
+    {
+        if (fCapturing)
+            fCapture.stop(fFrameCounter);
+
+        fCapturing = false;
+        fCapture.stopThread(5000);
+    }
+
+   /* --------------------------------------------------------------------------------------------------------
+    * Audio/MIDI Processing */
+
+   /**
+      Run/process function for plugins without MIDI input.
+      Measures and copies each channel in a single pass, see MeterKernel.
+    */
+    void run(const float** inputs, float** outputs, uint32_t frames)
+    {
+        const bool truePeak = fParameters[cParameterPeakMode] > 0.5f;
+        const uint32_t meterMode = static_cast<uint32_t>(fParameters[cParameterMeterMode] + 0.5f);
+        const float holdTime = fParameters[cParameterPeakHoldTime];
+
+        if (meterMode != fMeterMode || d_isNotEqual(holdTime, fHoldTime))
+        {
+            fMeterMode = meterMode;
+            fHoldTime  = holdTime;
+
+            fMeters.setMode(meterMode);
+            fMeters.setHoldTime(holdTime);
+        }
+
+        fMeters.setTruePeakEnabled(truePeak);
+        fMeters.process(inputs, outputs, frames);
+
+        const float*    const levels(fMeters.getLevels());
+        const float*    const holds(fMeters.getHolds());
+        const float*    const peaks(fMeters.getPeaks());
+        const float*    const truePeaks(fMeters.getTruePeaks());
+        const float*    const rms(fMeters.getRms());
+        const uint64_t* const clipCounts(fMeters.getClipCounts());
+        const int32_t*  const firstClipFrames(fMeters.getFirstClipFrames());
+
+        volatile float* const outParameters(fParameters + channelParameter(cChannelParameterOut, 0));
+        volatile float* const holdParameters(fParameters + channelParameter(cChannelParameterHold, 0));
+        volatile float* const rmsParameters(fParameters + channelParameter(cChannelParameterRms, 0));
+        volatile float* const clipParameters(fParameters + channelParameter(cChannelParameterClip, 0));
+        volatile float* const truePeakParameters(fParameters + channelParameter(cChannelParameterTruePeak, 0));
+
+        for (uint32_t c = 0; c < DISTRHO_PLUGIN_NUM_INPUTS; ++c)
+        {
+            outParameters[c]  = std::min(levels[c], 1.0f);
+            holdParameters[c] = std::min(holds[c], 1.0f);
+
+            rmsParameters[c]  = std::min(rms[c], 1.0f);
+
+            clipParameters[c] = static_cast<float>(std::min<uint64_t>(clipCounts[c], kMaxClipCount));
+
+            if (truePeak)
+                truePeakParameters[c] = truePeaks[c] > 0.0f ? std::max(20.0f * std::log10(truePeaks[c]), kMinDecibels)
+                                                            : kMinDecibels;
+            else
+                truePeakParameters[c] = kMinDecibels;
+
+            fShared.updatePeak(c, peaks[c]);
+
+            if (firstClipFrames[c] >= 0)
+                fShared.lastClipTime[c].store(fFrameCounter + static_cast<uint32_t>(firstClipFrames[c]),
+                                              std::memory_order_relaxed);
+        }
+
+        if (fNeedsReset)
+        {
+            fLoudness.reset();
+            fNeedsReset = false;
+        }
+
+        fLoudness.process(inputs, DISTRHO_PLUGIN_NUM_INPUTS, frames);
+
+        fParameters[cParameterLoudnessMomentary]  = fLoudness.getMomentary();
+        fParameters[cParameterLoudnessShortTerm]  = fLoudness.getShortTerm();
+        fParameters[cParameterLoudnessIntegrated] = fLoudness.getIntegrated();
+        fParameters[cParameterLoudnessRange]      = fLoudness.getRange();
+    }
+
+    void run(const float** inputs, float** outputs, uint32_t frames,
+                     const MidiEvent* midiEvents, uint32_t midiEventCount) override 
+    {
+        //process the audio events to capture audio meter values
+        run(inputs, outputs, frames);
+
+        const uint64_t blockTime = fFrameCounter;
+        fFrameCounter += frames;
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+        const TimePosition& timePosition(getTimePosition());
+        const double hostTempo = timePosition.bbt.valid ? timePosition.bbt.beatsPerMinute : 0.0;
+#else
+        const double hostTempo = 0.0;
+#endif
+
+        const bool capture = fParameters[cParameterCapture] > 0.5f;
+
+        // on a full ring this is retried on the next block
+        if (capture != fCapturing && fCapture.isThreadRunning())
+        {
+            if (capture ? fCapture.start(blockTime, getSampleRate()) : fCapture.stop(blockTime))
+                fCapturing = capture;
+        }
+
+        fStatistics.process(midiEvents, midiEventCount, frames);
+        fTiming.process(midiEvents, midiEventCount, blockTime, hostTempo);
+
+        if (fFrameCounter - fStatisticsPublished >= static_cast<uint64_t>(getSampleRate() * kStatisticsInterval))
+        {
+            fShared.statistics.write(fStatistics);
+            fShared.timing.write(fTiming.getStatistics());
+            fStatisticsPublished = fFrameCounter;
+        }
+
+        //Queue every event for the UI
+        for (uint32_t i = 0; i < midiEventCount; i++)
+        {
+            const MidiEvent& midiEvent(midiEvents[i]);
+
+            MidiMeterMonEvent uiEvent;
+            uiEvent.time = blockTime + midiEvent.frame;
+            uiEvent.midi.frame = midiEvent.frame;
+            uiEvent.midi.size  = midiEvent.size;
+            std::memcpy(uiEvent.midi.data, midiEvent.data, MidiEvent::kDataSize);
+            uiEvent.midi.dataExt = nullptr;
+            uiEvent.dataExtSize = 0;
+
+            // dataExt belongs to the host, keep a copy for the UI
+            if (midiEvent.size > MidiEvent::kDataSize)
+                uiEvent.midi.dataExt = fShared.sysex.store(midiEvent.dataExt, midiEvent.size, uiEvent.dataExtSize);
+
+            if (! fShared.midiEvents.push(uiEvent) && uiEvent.dataExtSize != 0)
+                fShared.sysex.discard(uiEvent.dataExtSize);
+
+            #if defined(VERBOSE_LOGGING)
+            if (midiEvent.size <= MidiEvent::kDataSize)
+            {
+                std::cout << uiEvent.time << ":";
+                for (uint32_t data_ctr = 0; data_ctr < midiEvent.size; data_ctr++)
+                    std::cout << " [0x" << std::hex << (uint32_t)midiEvent.data[data_ctr] << "]" << std::dec;
+                std::cout << std::endl;
+            }
+            #endif
+
+            if (fCapturing)
+                fCapture.write(uiEvent.time, midiEvent);
+        }
+
+#if ! DISTRHO_PLUGIN_MIDI_THRU
+        // builds without MIDI thru forward the input themselves
+        writeMidiEvents(midiEvents, midiEventCount);
+#endif
+    }
+
+   /* --------------------------------------------------------------------------------------------------------
+    * Direct access */
+
+public:
+    MidiMeterMonShared& getShared() noexcept
+    {
+        return fShared;
+    }
+
+   // -------------------------------------------------------------------------------------------------------
+
+private:
+   /**
+      Set the data of a per-channel parameter, @a offset is relative to cParameterChannelStart.
+      Stereo builds name their channels left and right, larger ones number them from 1.
+    */
+    static void initChannelParameter(const uint32_t offset, Parameter& parameter)
+    {
+        const uint32_t kind    = offset / DISTRHO_PLUGIN_NUM_INPUTS;
+        const uint32_t channel = offset % DISTRHO_PLUGIN_NUM_INPUTS;
+        DISTRHO_SAFE_ASSERT_RETURN(kind < cChannelParameterCount,);
+
+#if DISTRHO_PLUGIN_NUM_INPUTS == 2
+        const String suffix(channel == 0 ? "left" : "right");
+#else
+        const String suffix(channel + 1);
+#endif
+
+        parameter.hints  = kParameterIsAutomable|kParameterIsOutput;
+        parameter.name   = kChannelParameterNames[kind] + String("-") + suffix;
+        parameter.symbol = kChannelParameterSymbols[kind] + String("_") + suffix;
+        parameter.ranges.min = 0.0f;
+        parameter.ranges.max = 1.0f;
+        parameter.ranges.def = 0.0f;
+
+        switch (kind)
+        {
+        case cChannelParameterClip:
+            parameter.hints |= kParameterIsInteger;
+            parameter.ranges.max = kMaxClipCount;
+            break;
+        case cChannelParameterTruePeak:
+            parameter.unit   = "dBTP";
+            parameter.ranges.min = kMinDecibels;
+            parameter.ranges.max = kMaxTruePeak;
+            parameter.ranges.def = kMinDecibels;
+            break;
+        }
+    }
+
+   /**
+      Boolean used to reset meter values.
+      The loudness-reset trigger (sent by the UI or the host) sets this as true.
+    */
+    volatile bool fNeedsReset;
+
+    /**
+     * Parameters
+     */
+    volatile float fParameters[cParameterCount];
+
+   /**
+      Frames processed so far, used to time stamp MIDI events.
+    */
+    uint64_t fFrameCounter;
+
+   /**
+      MIDI statistics, only touched by the audio thread, and the frame they were last published at.
+      Padded so the counters never share a cache line with the parameters written by other threads.
+    */
+    char fStatisticsPad1[64];
+    MidiStatistics fStatistics;
+    uint64_t fStatisticsPublished;
+    char fStatisticsPad2[64];
+
+   /**
+      MIDI timing histograms, published with the statistics.
+    */
+    MidiTimingAnalyzer fTiming;
+
+   /**
+      Peak, RMS, clip and ballistics meters of all input channels,
+      and the ballistics settings they were last given.
+    */
+    MeterEngine<DISTRHO_PLUGIN_NUM_INPUTS> fMeters;
+    uint32_t fMeterMode;
+    float fHoldTime;
+
+   /**
+      EBU R128 loudness measurement.
+    */
+    LoudnessMeter fLoudness;
+
+   /**
+      Data shared with the UI.
+    */
+    MidiMeterMonShared fShared;
+
+   /**
+      Streams events to disk while the capture parameter is on, and whether it was started.
+    */
+    MidiCaptureWriter fCapture;
+    bool fCapturing;
+
+   /**
+      Set our plugin class as non-copyable and add a leak detector just in case.
+    */
+    DISTRHO_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiMeterMonitorPlugin)
+};
+
+/* ------------------------------------------------------------------------------------------------------------
+ * Plugin entry point, called by DPF to create a new plugin instance. */
+
+Plugin* createPlugin()
+{
+    return new MidiMeterMonitorPlugin();
+}
+
+MidiMeterMonShared* getMidiMeterMonShared(void* const pluginInstancePointer) noexcept
+{
+    if (pluginInstancePointer == nullptr)
+        return nullptr;
+
+    Plugin* const plugin(static_cast<Plugin*>(pluginInstancePointer));
+    return &static_cast<MidiMeterMonitorPlugin*>(plugin)->getShared();
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -15,9 +15,12 @@
  */
 
 #include "DistrhoUI.hpp"
+#include "LoudnessMeter.hpp"
 #include "MidiMeterMonUI.hpp"
-#include "DistrhoPluginInfo.h"
-#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 
 START_NAMESPACE_DISTRHO
 
@@ -27,9 +30,17 @@ START_NAMESPACE_DISTRHO
 using DGL::Color;
 
 /**
-  Smooth meters a bit.
+  Size of one meter and of the text area, the window grows with the channel count.
  */
-static const float kSmoothMultiplier = 3.0f;
+#if DISTRHO_PLUGIN_NUM_INPUTS > 2
+static const uint kMeterWidth = 16;
+static const uint kUIHeight   = 260;
+#else
+static const uint kMeterWidth = 41;
+static const uint kUIHeight   = 200;
+#endif
+static const uint kTextWidth  = 418;
+static const uint kMetersWidth = kMeterWidth * DISTRHO_PLUGIN_NUM_INPUTS;
 
 // -----------------------------------------------------------------------------------------------------------
 
@@ -37,13 +48,38 @@ class MidiMeterMonUI : public UI
 {
 public:
     MidiMeterMonUI()
-        : UI(500, 200, true),
+        : UI(kMetersWidth + kTextWidth, kUIHeight, true),
           // default color is green
           fColor(93, 231, 61),
           fontId (createFontFromFile("sans", "../examples/MidiMeterMon/resources/fonts/DroidSansMono.ttf")),
           fParameterOutputs { },
+          fShared(getMidiMeterMonShared(getPluginInstancePointer())),
+          fMaxPeak { },
+          fHistory { },
+          fHistoryCount(0),
+          fHistoryNext(0),
+          fEventsShown(0),
+          fDroppedShown(0),
+          fStatistics(),
+          fRateStart(),
+          fDumpStart(),
+          fEventRate(0.0),
+          fTiming(),
+          fShowTiming(false),
+          fCaptureRecording(false),
+          fCaptureDropped(0),
+          fSysExTruncated(0),
+          fSysExLost(0),
           pDecodedMidiMsgs {" "}
     {
+        fParameterOutputs[cParameterLoudnessMomentary]  = LoudnessMeter::kLoudnessFloor;
+        fParameterOutputs[cParameterLoudnessShortTerm]  = LoudnessMeter::kLoudnessFloor;
+        fParameterOutputs[cParameterLoudnessIntegrated] = LoudnessMeter::kLoudnessFloor;
+
+        for (uint32_t c = 0; c < DISTRHO_PLUGIN_NUM_INPUTS; ++c)
+            fParameterOutputs[channelParameter(cChannelParameterTruePeak, c)] = LoudnessMeter::kLoudnessFloor;
+
+        midiHistoryToText();
     }
 
 protected:
@@ -56,81 +92,246 @@ protected:
     */
     void parameterChanged(uint32_t index, float value) override
     {
-        switch (index)
-        {
-        case cParameterOutLeft: // out-left
-            value = (fParameterOutputs[cParameterOutLeft] * kSmoothMultiplier + value) / (kSmoothMultiplier + 1.0f);
+        DISTRHO_SAFE_ASSERT_RETURN(index < cParameterCount,);
 
-            /**/ if (value < 0.001f) value = 0.0f;
-            else if (value > 0.999f) value = 1.0f;
+        if (fParameterOutputs[index] == value)
+            return;
 
-            if (fParameterOutputs[cParameterOutLeft] != value)
+        fParameterOutputs[index] = value;
+
+        // ballistics are computed on the DSP side, meter values are drawn as they are
+        if (index >= cParameterChannelStart)
+        {
+            switch ((index - cParameterChannelStart) / DISTRHO_PLUGIN_NUM_INPUTS)
             {
-                fParameterOutputs[cParameterOutLeft] = value;
+            case cChannelParameterOut:
+            case cChannelParameterRms:
+            case cChannelParameterHold:
                 repaint();
+                return;
             }
-            break;
+        }
 
-        case cParameterOutRight: // out-right
-            value = (fParameterOutputs[cParameterOutRight] * kSmoothMultiplier + value) / (kSmoothMultiplier + 1.0f);
+        midiHistoryToText();
+        repaint();
+    }
 
-            /**/ if (value < 0.001f) value = 0.0f;
-            else if (value > 0.999f) value = 1.0f;
+   /**
+      A state has changed on the plugin side.
+      This is called by the host to inform the UI about state changes.
+    */
+    void stateChanged(const char*, const char*)
+    {
+        // nothing here
+    }
 
-            if (fParameterOutputs[cParameterOutRight] != value)
-            {
-                fParameterOutputs[cParameterOutRight] = value;
-                repaint();
-            }
-            break;
-        
-        case cParameterMidiMessage1:
-            if (fParameterOutputs[cParameterMidiMessage1] != value) 
-            {
-                fParameterOutputs[cParameterMidiMessage1] = value;
-                midiParmsToText();
-                repaint();
-            }
-            break;
-        case cParameterMidiMessage2:
-            if (fParameterOutputs[cParameterMidiMessage2] != value) 
+   /* --------------------------------------------------------------------------------------------------------
+    * UI Callbacks */
+
+   /**
+      Idle callback, drains the MIDI events queued by the DSP.
+      At most one ring worth of events is read per call so a flooding input cannot stall the UI.
+    */
+    void uiIdle() override
+    {
+        if (fShared == nullptr)
+            return;
+
+        MidiEventRing& ring(fShared->midiEvents);
+        bool changed = false;
+
+        for (uint32_t i = 0, count = ring.getCapacity(); i < count; ++i)
+        {
+            MidiMeterMonEvent& event(fHistory[fHistoryNext]);
+
+            if (! ring.pop(event))
+                break;
+
+            // keep the start of SysEx messages for display, the arena space goes back to the DSP right away
+            if (event.midi.dataExt != nullptr)
             {
-                fParameterOutputs[cParameterMidiMessage2] = value;
-                midiParmsToText();
-                repaint();
+                const uint32_t size = event.dataExtSize < kSysExPreviewSize ? event.dataExtSize : kSysExPreviewSize;
+
+                std::memcpy(fHistorySysEx[fHistoryNext], event.midi.dataExt, size);
+                fShared->sysex.release(event.dataExtSize);
+
+                event.midi.dataExt = fHistorySysEx[fHistoryNext];
+                event.dataExtSize = size;
             }
-            break;
-        case cParameterMidiMessage3:
-            if (fParameterOutputs[cParameterMidiMessage3] != value) 
+
+            if (++fHistoryNext == MIDIMETERMON_HISTORY_DEPTH)
+                fHistoryNext = 0;
+            if (fHistoryCount < MIDIMETERMON_HISTORY_DEPTH)
+                ++fHistoryCount;
+
+            changed = true;
+        }
+
+        // take the peaks seen since the last idle, so short transients are never missed
+        for (uint32_t c = 0; c < DISTRHO_PLUGIN_NUM_INPUTS; ++c)
+        {
+            const float peak = fShared->consumePeak(c);
+
+            if (peak > fMaxPeak[c])
             {
-                fParameterOutputs[cParameterMidiMessage3] = value;
-                midiParmsToText();
-                repaint();
+                fMaxPeak[c] = peak;
+                changed = true;
             }
-            break;
-        case cParameterMidiMessage4:
-            if (fParameterOutputs[cParameterMidiMessage4] != value) 
-            {
-                fParameterOutputs[cParameterMidiMessage4] = value;
-                midiParmsToText();
+        }
+
+        // a failed read can leave a torn copy, keep the last good one then
+        MidiStatistics statistics;
+
+        if (fShared->statistics.read(statistics))
+        {
+            fStatistics = statistics;
+
+            if (updateEventRate())
+                changed = true;
+        }
+
+        MidiTimingStatistics timing;
+
+        if (fShared->timing.read(timing))
+        {
+            const uint64_t timingBlocks = fTiming.blocks;
+            fTiming = timing;
+
+            if (fShowTiming && fTiming.blocks != timingBlocks)
                 repaint();
-            }
-            break;          
         }
 
+        // the number of captured events is refreshed with the rate, only state changes redraw
+        const MidiCaptureStatus& capture(fShared->capture);
+        const bool recording = capture.recording.load(std::memory_order_relaxed);
+        const uint64_t captureDropped = capture.eventsDropped.load(std::memory_order_relaxed);
+
+        if (recording != fCaptureRecording || captureDropped != fCaptureDropped)
+        {
+            fCaptureRecording = recording;
+            fCaptureDropped = captureDropped;
+            changed = true;
+        }
+
+        const uint64_t sysExTruncated = fShared->sysex.getTruncatedCount();
+        const uint64_t sysExLost = fShared->sysex.getOverflowCount();
+
+        if (sysExTruncated != fSysExTruncated || sysExLost != fSysExLost)
+        {
+            fSysExTruncated = sysExTruncated;
+            fSysExLost = sysExLost;
+            changed = true;
+        }
+
+        const uint64_t dropped = ring.getDroppedCount();
+
+        if (changed || dropped != fDroppedShown)
+        {
+            fEventsShown  = ring.getPushedCount();
+            fDroppedShown = dropped;
+            midiHistoryToText();
+            repaint();
+        }
     }
 
+   /* --------------------------------------------------------------------------------------------------------
+    * Widget Callbacks */
+
    /**
-      A state has changed on the plugin side.
-      This is called by the host to inform the UI about state changes.
+      Mouse press event.
+      On the text area a left click resets the loudness measurement and maximum peaks,
+      a middle click switches between the MIDI history and the timing histograms,
+      a right click toggles true-peak mode.
     */
-    void stateChanged(const char*, const char*)
+    bool onMouse(const MouseEvent& ev) override
     {
-        // nothing here
+        if (! ev.press)
+            return false;
+
+        if (ev.pos.getX() < static_cast<int>(kMetersWidth))
+            return false;
+
+        switch (ev.button)
+        {
+        case 1:
+            editParameter(cParameterLoudnessReset, true);
+            setParameterValue(cParameterLoudnessReset, 1.0f);
+            editParameter(cParameterLoudnessReset, false);
+
+            for (uint32_t c = 0; c < DISTRHO_PLUGIN_NUM_INPUTS; ++c)
+                fMaxPeak[c] = 0.0f;
+
+            midiHistoryToText();
+            repaint();
+            return true;
+
+        case 2:
+            fShowTiming = ! fShowTiming;
+            repaint();
+            return true;
+
+        case 3: {
+            const float mode = fParameterOutputs[cParameterPeakMode] > 0.5f ? cPeakModeSample : cPeakModeTrue;
+
+            fParameterOutputs[cParameterPeakMode] = mode;
+            editParameter(cParameterPeakMode, true);
+            setParameterValue(cParameterPeakMode, mode);
+            editParameter(cParameterPeakMode, false);
+
+            midiHistoryToText();
+            repaint();
+            return true;
+        }
+        }
+
+        return false;
     }
 
-   /* --------------------------------------------------------------------------------------------------------
-    * Widget Callbacks */
+   /**
+      Keyboard event.
+      'd' writes the MIDI statistics to stdout, useful to diagnose floods from the JACK standalone.
+      't' switches between the MIDI history and the timing histograms.
+      'c' toggles capture, 'l' maps the next MIDI control change to it (JACK standalone only).
+    */
+    bool onKeyboard(const KeyboardEvent& ev) override
+    {
+        if (! ev.press)
+            return false;
+
+        if (ev.key == 't' || ev.key == 'T')
+        {
+            fShowTiming = ! fShowTiming;
+            repaint();
+            return true;
+        }
+
+        if (ev.key == 'c' || ev.key == 'C')
+        {
+            const float capture = fParameterOutputs[cParameterCapture] > 0.5f ? 0.0f : 1.0f;
+
+            fParameterOutputs[cParameterCapture] = capture;
+            editParameter(cParameterCapture, true);
+            setParameterValue(cParameterCapture, capture);
+            editParameter(cParameterCapture, false);
+            return true;
+        }
+
+        if (ev.key == 'l' || ev.key == 'L')
+        {
+            requestParameterMidiLearn(cParameterCapture);
+            return true;
+        }
+
+        if (ev.key != 'd' && ev.key != 'D')
+            return false;
+
+        if (fShared == nullptr || getSampleRate() <= 0.0)
+            return false;
+
+        fStatistics.dump(stdout, getSampleRate(), fDumpStart.frames != 0 ? &fDumpStart : nullptr);
+        fDumpStart = fStatistics;
+        return true;
+    }
 
    /**
       The NanoVG drawing function.
@@ -143,70 +344,80 @@ protected:
         static const Color kColorSmoke(245,245,245);
         static const Color kColorCarbon(50,50,50);
 
-        // get meter values
-        const float outLeft(fParameterOutputs[cParameterOutLeft]);
-        const float outRight(fParameterOutputs[cParameterOutRight]);
-
         // useful vars
-        const float meterWidth       = static_cast<float>(getWidth())/12;
+        const float meterWidth       = kMeterWidth;
+        const float metersWidth      = kMetersWidth;
+        const float height           = getHeight();
         const float midiMsgTextGutter {5.0f}; 
         const float widthOfStroke     {3.0f}; 
-        const float redYellowHeight  = static_cast<float>(getHeight())*0.2f;
-        const float yellowBaseHeight = static_cast<float>(getHeight())*0.4f;
-        const float baseBaseHeight   = static_cast<float>(getHeight())*0.6f;
+        const float redYellowHeight  = height*0.2f;
+        const float yellowBaseHeight = height*0.4f;
+        const float baseBaseHeight   = height*0.6f;
+        const float clipHeight       = 4.0f;
+
+        const float* const outs(fParameterOutputs + channelParameter(cChannelParameterOut, 0));
+        const float* const rms(fParameterOutputs + channelParameter(cChannelParameterRms, 0));
+        const float* const holds(fParameterOutputs + channelParameter(cChannelParameterHold, 0));
+        const float* const clips(fParameterOutputs + channelParameter(cChannelParameterClip, 0));
 
         // create gradients
         Paint fGradient1 = linearGradient(0.0f, 0.0f,            0.0f, redYellowHeight,  kColorRed,    kColorYellow);
         Paint fGradient2 = linearGradient(0.0f, redYellowHeight, 0.0f, yellowBaseHeight, kColorYellow, fColor);
 
-        // paint left meter
+        // paint each layer of all meters as a single path, one meter per channel with a 1 pixel gap
         beginPath();
-        rect(0.0f, 0.0f, meterWidth-1.0f, redYellowHeight);
+        for (uint32_t c = 0; c < DISTRHO_PLUGIN_NUM_INPUTS; ++c)
+            rect(c*meterWidth, 0.0f, meterWidth-1.0f, redYellowHeight);
         fillPaint(fGradient1);
         fill();
         closePath();
 
         beginPath();
-        rect(0.0f, redYellowHeight-0.5f, meterWidth-1.0f, yellowBaseHeight);
+        for (uint32_t c = 0; c < DISTRHO_PLUGIN_NUM_INPUTS; ++c)
+            rect(c*meterWidth, redYellowHeight-0.5f, meterWidth-1.0f, yellowBaseHeight);
         fillPaint(fGradient2);
         fill();
         closePath();
 
         beginPath();
-        rect(0.0f, redYellowHeight+yellowBaseHeight-1.5f, meterWidth-1.0f, baseBaseHeight);
+        for (uint32_t c = 0; c < DISTRHO_PLUGIN_NUM_INPUTS; ++c)
+            rect(c*meterWidth, redYellowHeight+yellowBaseHeight-1.5f, meterWidth-1.0f, baseBaseHeight);
         fillColor(fColor);
         fill();
         closePath();
 
-        // paint left black matching output level
+        // paint black matching output levels
         beginPath();
-        rect(0.0f, 0.0f, meterWidth-1.0f, (1.0f-outLeft)*getHeight());
+        for (uint32_t c = 0; c < DISTRHO_PLUGIN_NUM_INPUTS; ++c)
+            rect(c*meterWidth, 0.0f, meterWidth-1.0f, (1.0f-outs[c])*height);
         fillColor(kColorBlack);
         fill();
         closePath();
 
-        // paint right meter
+        // paint RMS markers
         beginPath();
-        rect(meterWidth+1.0f, 0.0f, meterWidth-2.0f, redYellowHeight);
-        fillPaint(fGradient1);
-        fill();
-        closePath();
-
-        beginPath();
-        rect(meterWidth+1.0f, redYellowHeight-0.5f, meterWidth-2.0f, yellowBaseHeight);
-        fillPaint(fGradient2);
+        for (uint32_t c = 0; c < DISTRHO_PLUGIN_NUM_INPUTS; ++c)
+            rect(c*meterWidth, (1.0f-rms[c])*height-1.0f, meterWidth-1.0f, 2.0f);
+        fillColor(kColorSmoke);
         fill();
         closePath();
 
+        // paint hold markers
         beginPath();
-        rect(meterWidth+1.0f, redYellowHeight+yellowBaseHeight-1.5f, meterWidth-2.0f, baseBaseHeight);
-        fillColor(fColor);
+        for (uint32_t c = 0; c < DISTRHO_PLUGIN_NUM_INPUTS; ++c)
+            rect(c*meterWidth, (1.0f-holds[c])*height, meterWidth-1.0f, 2.0f);
+        fillColor(kColorYellow);
         fill();
         closePath();
 
+        // paint clip indicators
         beginPath();
-        rect(meterWidth+1.0f, 0.0f, meterWidth-2.0f, (1.0f-outRight)*getHeight());
-        fillColor(kColorBlack);
+        for (uint32_t c = 0; c < DISTRHO_PLUGIN_NUM_INPUTS; ++c)
+        {
+            if (clips[c] > 0.0f)
+                rect(c*meterWidth, 0.0f, meterWidth-1.0f, clipHeight);
+        }
+        fillColor(kColorRed);
         fill();
         closePath();
 
@@ -221,13 +432,24 @@ protected:
         textAlign(Align(ALIGN_LEFT|ALIGN_TOP));
 
         char* text = pDecodedMidiMsgs;
-        textBoxBounds((meterWidth*2)+midiMsgTextGutter, midiMsgTextGutter+widthOfStroke, getWidth()-(meterWidth*2)-(widthOfStroke)-(midiMsgTextGutter*2), text, NULL, bounds);
-        rect(bounds[0]-midiMsgTextGutter, bounds[1]-midiMsgTextGutter, getWidth()-(meterWidth*2), getHeight()-widthOfStroke);
+        textBoxBounds(metersWidth+midiMsgTextGutter, midiMsgTextGutter+widthOfStroke, getWidth()-metersWidth-(widthOfStroke)-(midiMsgTextGutter*2), text, NULL, bounds);
+        rect(bounds[0]-midiMsgTextGutter, bounds[1]-midiMsgTextGutter, getWidth()-metersWidth, getHeight()-widthOfStroke);
         fill();
         stroke();
-        fillColor(kColorCarbon);
-        textBox(bounds[0], bounds[1], (int)(bounds[2]-bounds[0]), text, nullptr);
         closePath();
+
+        if (fShowTiming)
+        {
+            drawTiming(bounds[0], bounds[1],
+                       getWidth()-bounds[0]-midiMsgTextGutter-widthOfStroke,
+                       getHeight()-bounds[1]-midiMsgTextGutter-widthOfStroke);
+        }
+        else
+        {
+            fillColor(kColorCarbon);
+            textBox(bounds[0], bounds[1], (int)(bounds[2]-bounds[0]), text, nullptr);
+        }
+
         restore();
 
     }
@@ -246,47 +468,436 @@ private:
     FontId fontId;
 
    /**
-      Meter values and MIDI messages.
-      These are the parameter outputs from the DSP side.
+      Meter, loudness and mode values.
+      These are the parameter values from the DSP side.
     */
     float fParameterOutputs[cParameterCount];
 
+   /**
+      Events shared by the DSP, null if the host does not give us direct access.
+    */
+    MidiMeterMonShared* const fShared;
+
+   /**
+      Highest peak per channel read from the DSP since the last reset (linear).
+    */
+    float fMaxPeak[DISTRHO_PLUGIN_NUM_INPUTS];
+
+   /**
+      Last received MIDI events, fHistoryNext is the slot for the next one.
+    */
+    MidiMeterMonEvent fHistory[MIDIMETERMON_HISTORY_DEPTH];
+
+   /**
+      First bytes of each SysEx message in the history, pointed to by its dataExt.
+    */
+    static const uint32_t kSysExPreviewSize = 12;
+    uint8_t fHistorySysEx[MIDIMETERMON_HISTORY_DEPTH][kSysExPreviewSize];
+    uint32_t fHistoryCount;
+    uint32_t fHistoryNext;
+
+   /**
+      Event totals as last displayed.
+    */
+    uint64_t fEventsShown;
+    uint64_t fDroppedShown;
+
+   /**
+      Last MIDI statistics read from the DSP, and the earlier copies event rates are measured from.
+    */
+    MidiStatistics fStatistics;
+    MidiStatistics fRateStart;
+    MidiStatistics fDumpStart;
+    double fEventRate;
+
+   /**
+      Last MIDI timing histograms read from the DSP, and whether they are shown instead of the history.
+    */
+    MidiTimingStatistics fTiming;
+    bool fShowTiming;
+
     /**
-     * MidiParameters Decoded to string with line breaks
+     * Capture state last shown, the text is rebuilt when it changes.
      */
-    char pDecodedMidiMsgs[MIDI_PARAMETER_BUFFER_SIZE];
+    bool fCaptureRecording;
+    uint64_t fCaptureDropped;
 
     /**
-     * Convert MidiParams to text
+     * SysEx counters last shown.
      */
-    void midiParmsToText() 
+    uint64_t fSysExTruncated;
+    uint64_t fSysExLost;
+
+   /**
+      Update the event rate once enough time has passed since fRateStart.
+      Returns true if it changed.
+    */
+    bool updateEventRate() noexcept
     {
-        uint8_t location{0};
+        const double sampleRate = getSampleRate();
 
-        //Show messages with oldest at the top
-        for (uint8_t pcount = MIDI_PARAMETER_OFFSET + MIDI_PARAMETER_COUNT - 1; pcount >= MIDI_PARAMETER_OFFSET; pcount--)
+        if (sampleRate <= 0.0)
+            return false;
+
+        // first read, or the DSP restarted
+        if (fRateStart.frames == 0 || fStatistics.frames < fRateStart.frames)
         {
-            if (fParameterOutputs[pcount] > 0) {
-                auto messageBytes = reinterpret_cast<volatile uint8_t*>(&fParameterOutputs[pcount]);
-                location += snprintf(pDecodedMidiMsgs+location,MIDI_PARAMETER_OUTPUT_LINE_SIZE,"Message Parameter %x\n",pcount);
-                location += snprintf(pDecodedMidiMsgs+location,MIDI_PARAMETER_OUTPUT_LINE_SIZE,"Func: 0x%02x,Data1: 0x%02x,Data2: 0x%02x,Data3: 0x%02x\n",messageBytes[0],messageBytes[1],messageBytes[2],messageBytes[3]);
-            } else 
+            fRateStart = fStatistics;
+            return false;
+        }
+
+        const double seconds = static_cast<double>(fStatistics.frames - fRateStart.frames) / sampleRate;
+
+        if (seconds < 0.5)
+            return false;
+
+        const double rate = static_cast<double>(fStatistics.events - fRateStart.events) / seconds;
+        fRateStart = fStatistics;
+
+        if (d_isEqual(rate, fEventRate))
+            return false;
+
+        fEventRate = rate;
+        return true;
+    }
+
+    /**
+     * MIDI history decoded to string with line breaks
+     */
+    char pDecodedMidiMsgs[MIDIMETERMON_HISTORY_BUFFER_SIZE];
+
+    /**
+     * Get the name of a meter-mode value
+     */
+    static const char* meterModeToName(const float mode) noexcept
+    {
+        switch (static_cast<uint32_t>(mode + 0.5f))
+        {
+        case MeterBallistics::kModePPM: return "PPM";
+        case MeterBallistics::kModeVU:  return "VU";
+        }
+
+        return "Digital peak";
+    }
+
+    /**
+     * Convert a linear level to decibels, with a -70 dB floor
+     */
+    static float linearToDecibels(const float value) noexcept
+    {
+        if (value <= 0.0f)
+            return LoudnessMeter::kLoudnessFloor;
+
+        const float db = 20.0f * std::log10(value);
+        return db > LoudnessMeter::kLoudnessFloor ? db : LoudnessMeter::kLoudnessFloor;
+    }
+
+    /**
+     * Name of a SysEx message, the universal messages worth telling apart are recognized.
+     * @a data may be null (the message was not kept) or hold only the start of the message.
+     */
+    static const char* sysExToName(const uint8_t* const data, const uint32_t size) noexcept
+    {
+        if (data == nullptr || size < 4)
+            return "SysEx";
+
+        // F0 <universal id> <device> <sub-id> ...
+        if (data[1] == 0x7F)
+        {
+            switch (data[3])
             {
-                location += snprintf(pDecodedMidiMsgs+location,MIDI_PARAMETER_OUTPUT_LINE_SIZE," ");
+            case 0x01: return "MTC";
+            case 0x06: return "MMC";
             }
         }
+        else if (data[1] == 0x7E)
+        {
+            switch (data[3])
+            {
+            case 0x06: return "Identity";
+            case 0x07: return "File Dump";
+            }
+        }
+
+        return "SysEx";
+    }
+
+    /**
+     * Get a short name for the MIDI message type
+     */
+    static const char* midiStatusToName(const uint8_t status) noexcept
+    {
+        switch (status & 0xF0)
+        {
+        case 0x80: return "Note Off";
+        case 0x90: return "Note On";
+        case 0xA0: return "Aftertouch";
+        case 0xB0: return "Control";
+        case 0xC0: return "Program";
+        case 0xD0: return "Pressure";
+        case 0xE0: return "Pitch Bend";
+        }
+
+        switch (status)
+        {
+        case 0xF0: return "SysEx";
+        case 0xF1: return "Time Code";
+        case 0xF2: return "Song Pos";
+        case 0xF3: return "Song Select";
+        case 0xF6: return "Tune Request";
+        case 0xF8: return "Clock";
+        case 0xFA: return "Start";
+        case 0xFB: return "Continue";
+        case 0xFC: return "Stop";
+        case 0xFE: return "Active Sense";
+        case 0xFF: return "Reset";
+        }
+
+        return "Unknown";
+    }
+
+    /**
+     * Draw one histogram with its label above, bars are scaled to the fullest bucket
+     */
+    void drawHistogram(const float x, const float y, const float width, const float height,
+                       const uint32_t* const buckets, const uint32_t count, const char* const label)
+    {
+        static const Color kColorCarbon(50,50,50);
+        static const float kLabelHeight = 14.0f;
+
+        fillColor(kColorCarbon);
+        text(x, y, label, nullptr);
+
+        uint32_t highest = 1;
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (buckets[i] > highest)
+                highest = buckets[i];
+        }
+
+        const float barsHeight = height - kLabelHeight;
+        const float barWidth   = width / count;
+        const float bottom     = y + height;
+
+        beginPath();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (buckets[i] == 0)
+                continue;
+
+            const float barHeight = std::max(1.0f, barsHeight * buckets[i] / highest);
+            rect(x + i*barWidth, bottom - barHeight, std::max(1.0f, barWidth - 1.0f), barHeight);
+        }
+        fillColor(fColor);
+        fill();
+        closePath();
     }
 
-    void logMidiMessageParameter(float packedMidiMessage) 
+    /**
+     * Draw the timing histograms: note-on intervals, clock deviation and events per block
+     */
+    void drawTiming(const float x, const float y, const float width, const float height)
     {
-        std::cout << "In logMidiMessageParameter() : " << std::hex << packedMidiMessage << std::endl;
-        
-        auto messageBytes = reinterpret_cast<uint8_t*>(&packedMidiMessage);
-        std::cout << "In logMidiMessageParameter() 2 : " << std::hex << messageBytes[0] << std::endl;
-        for (uint8_t i = 0; i < 4;i++){
-            std::cout << std::hex << ((messageBytes[i] & 0xF0)>>4) << std::hex << (messageBytes[i] & 0x0F) << " "; 
+        const double sampleRate = getSampleRate();
+        const double msPerFrame = sampleRate > 0.0 ? 1000.0 / sampleRate : 0.0;
+        const float  rowHeight  = height / 3.0f;
+        char label[MIDIMETERMON_HISTORY_LINE_SIZE];
+
+        fontSize(12.0f);
+        textAlign(Align(ALIGN_LEFT|ALIGN_TOP));
+
+        std::snprintf(label, sizeof(label), "Note-on intervals, %.0f ms per bin",
+                      static_cast<double>(MidiTimingStatistics::kIntervalBucketWidth));
+        drawHistogram(x, y, width, rowHeight - 2.0f,
+                      fTiming.intervals, MidiTimingStatistics::kIntervalBucketCount, label);
+
+        if (fTiming.clockCount != 0)
+        {
+            const double mean = fTiming.clockDeviationSum / fTiming.clockCount;
+            const double variance = fTiming.clockDeviationSquares / fTiming.clockCount - mean * mean;
+
+            std::snprintf(label, sizeof(label), "Clock %.2f ms (%s)  dev %+.3f ms  sd %.3f ms",
+                          fTiming.clockPeriod * msPerFrame,
+                          fTiming.clockPeriodFromHost ? "host" : "measured",
+                          mean * msPerFrame,
+                          variance > 0.0 ? std::sqrt(variance) * msPerFrame : 0.0);
+        }
+        else
+        {
+            std::snprintf(label, sizeof(label), "Clock deviation, no MIDI clock received");
+        }
+
+        drawHistogram(x, y + rowHeight, width, rowHeight - 2.0f,
+                      fTiming.clockDeviations, MidiTimingStatistics::kDeviationBucketCount, label);
+
+        // empty blocks are left out, they would flatten everything else
+        std::snprintf(label, sizeof(label), "Events per block, %.1f%% on the first frame",
+                      fTiming.events != 0 ? 100.0 * fTiming.eventsAtBlockStart / fTiming.events : 0.0);
+        drawHistogram(x, y + rowHeight * 2.0f, width, rowHeight - 2.0f,
+                      fTiming.eventsPerBlock + 1, MidiTimingStatistics::kBlockBucketCount - 1, label);
+    }
+
+    /**
+     * Convert the MIDI history to text
+     */
+    void midiHistoryToText()
+    {
+        const double sampleRate = getSampleRate();
+        char* text = pDecodedMidiMsgs;
+        char* const end = pDecodedMidiMsgs + MIDIMETERMON_HISTORY_BUFFER_SIZE;
+
+        if (fShared == nullptr)
+        {
+            std::snprintf(text, end-text, "MIDI events need host instance access\n");
+            return;
+        }
+
+        const float* const clips(fParameterOutputs + channelParameter(cChannelParameterClip, 0));
+        const float* const truePeaks(fParameterOutputs + channelParameter(cChannelParameterTruePeak, 0));
+
+#if DISTRHO_PLUGIN_NUM_INPUTS == 2
+        text += std::snprintf(text, end-text, "Events: %llu  Dropped: %llu  Clips: %u/%u",
+                              static_cast<unsigned long long>(fEventsShown),
+                              static_cast<unsigned long long>(fDroppedShown),
+                              static_cast<uint32_t>(clips[0]),
+                              static_cast<uint32_t>(clips[1]));
+#else
+        // too many channels for one line, show the totals and the loudest channel instead
+        uint64_t totalClips = 0;
+        uint32_t maxPeakChannel = 0, maxTruePeakChannel = 0;
+
+        for (uint32_t c = 0; c < DISTRHO_PLUGIN_NUM_INPUTS; ++c)
+        {
+            totalClips += static_cast<uint64_t>(clips[c]);
+
+            if (fMaxPeak[c] > fMaxPeak[maxPeakChannel])
+                maxPeakChannel = c;
+            if (truePeaks[c] > truePeaks[maxTruePeakChannel])
+                maxTruePeakChannel = c;
+        }
+
+        text += std::snprintf(text, end-text, "Events: %llu  Dropped: %llu  Clips: %llu",
+                              static_cast<unsigned long long>(fEventsShown),
+                              static_cast<unsigned long long>(fDroppedShown),
+                              static_cast<unsigned long long>(totalClips));
+#endif
+
+        uint64_t lastClipTime = MidiMeterMonShared::kNoClipTime;
+
+        for (uint32_t i = 0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
+        {
+            const uint64_t clipTime = fShared->lastClipTime[i].load(std::memory_order_relaxed);
+
+            if (clipTime != MidiMeterMonShared::kNoClipTime && (lastClipTime == MidiMeterMonShared::kNoClipTime || clipTime > lastClipTime))
+                lastClipTime = clipTime;
+        }
+
+        if (lastClipTime != MidiMeterMonShared::kNoClipTime && sampleRate > 0.0 && text < end)
+            text += std::snprintf(text, end-text, " @%.3fs", static_cast<double>(lastClipTime) / sampleRate);
+
+        if (text < end)
+            text += std::snprintf(text, end-text, "\n");
+
+        if (text < end)
+            text += std::snprintf(text, end-text, "M %.1f  S %.1f  I %.1f LUFS  LRA %.1f LU\n",
+                                  static_cast<double>(fParameterOutputs[cParameterLoudnessMomentary]),
+                                  static_cast<double>(fParameterOutputs[cParameterLoudnessShortTerm]),
+                                  static_cast<double>(fParameterOutputs[cParameterLoudnessIntegrated]),
+                                  static_cast<double>(fParameterOutputs[cParameterLoudnessRange]));
+
+#if DISTRHO_PLUGIN_NUM_INPUTS == 2
+        if (text < end)
+            text += std::snprintf(text, end-text, "%s  Max: %.1f / %.1f dB\n",
+                                  meterModeToName(fParameterOutputs[cParameterMeterMode]),
+                                  static_cast<double>(linearToDecibels(fMaxPeak[0])),
+                                  static_cast<double>(linearToDecibels(fMaxPeak[1])));
+
+        if (fParameterOutputs[cParameterPeakMode] > 0.5f && text < end)
+            text += std::snprintf(text, end-text, "True peak: %.1f / %.1f dBTP\n",
+                                  static_cast<double>(truePeaks[0]),
+                                  static_cast<double>(truePeaks[1]));
+#else
+        if (text < end)
+            text += std::snprintf(text, end-text, "%s  Max: %.1f dB (ch %u)\n",
+                                  meterModeToName(fParameterOutputs[cParameterMeterMode]),
+                                  static_cast<double>(linearToDecibels(fMaxPeak[maxPeakChannel])),
+                                  maxPeakChannel + 1);
+
+        if (fParameterOutputs[cParameterPeakMode] > 0.5f && text < end)
+            text += std::snprintf(text, end-text, "True peak: %.1f dBTP (ch %u)\n",
+                                  static_cast<double>(truePeaks[maxTruePeakChannel]),
+                                  maxTruePeakChannel + 1);
+#endif
+
+        int64_t noteBalance = 0;
+
+        for (uint32_t c = 0; c < MidiStatistics::kChannelCount; ++c)
+            noteBalance += fStatistics.channels[c].getNoteBalance();
+
+        if (text < end)
+            text += std::snprintf(text, end-text, "Rate: %.0f/s  Peak: %u/block  Notes held: %lld\n",
+                                  fEventRate, fStatistics.peakEventsPerBlock, static_cast<long long>(noteBalance));
+
+        if (fShared != nullptr && text < end)
+        {
+            const MidiCaptureStatus& capture(fShared->capture);
+            const uint32_t errors = capture.errors.load(std::memory_order_relaxed);
+
+            if (fCaptureRecording)
+                text += std::snprintf(text, end-text, "REC %llu events, lost %llu\n",
+                                      static_cast<unsigned long long>(capture.eventsWritten.load(std::memory_order_relaxed)),
+                                      static_cast<unsigned long long>(fCaptureDropped));
+            else if (errors != 0)
+                text += std::snprintf(text, end-text, "Capture failed, %u errors\n", errors);
+        }
+
+        if ((fSysExTruncated != 0 || fSysExLost != 0) && text < end)
+            text += std::snprintf(text, end-text, "SysEx truncated: %llu  lost: %llu\n",
+                                  static_cast<unsigned long long>(fSysExTruncated),
+                                  static_cast<unsigned long long>(fSysExLost));
+
+        //Show messages with oldest at the top
+        uint32_t index = (fHistoryNext + MIDIMETERMON_HISTORY_DEPTH - fHistoryCount) % MIDIMETERMON_HISTORY_DEPTH;
+
+        for (uint32_t i = 0; i < fHistoryCount && text < end; ++i)
+        {
+            const MidiMeterMonEvent& event(fHistory[index]);
+            const double seconds = sampleRate > 0.0 ? static_cast<double>(event.time) / sampleRate : 0.0;
+
+            if (event.midi.size > MidiEvent::kDataSize)
+            {
+                const uint8_t* const data(event.midi.dataExt);
+
+                text += std::snprintf(text, end-text, "%10.4f %-12s %u bytes ",
+                                      seconds, sysExToName(data, event.dataExtSize), event.midi.size);
+
+                for (uint32_t j = 0; j < event.dataExtSize && text < end; ++j)
+                    text += std::snprintf(text, end-text, "%02X ", data[j]);
+
+                if (text < end)
+                    text += std::snprintf(text, end-text, event.dataExtSize < event.midi.size ? "...\n" : "\n");
+            }
+            else if (event.midi.size != 0)
+            {
+                const uint8_t* const data(event.midi.data);
+                const bool isChannelMessage = data[0] < 0xF0;
+
+                text += std::snprintf(text, end-text, "%10.4f %-12s ", seconds, midiStatusToName(data[0]));
+
+                if (isChannelMessage && text < end)
+                    text += std::snprintf(text, end-text, "ch%-2u ", (data[0] & 0x0F) + 1U);
+
+                for (uint32_t j = 0; j < event.midi.size && text < end; ++j)
+                    text += std::snprintf(text, end-text, "%02X ", data[j]);
+
+                if (text < end)
+                    text += std::snprintf(text, end-text, "\n");
+            }
+
+            if (++index == MIDIMETERMON_HISTORY_DEPTH)
+                index = 0;
         }
-        std::cout << std::endl;
     }
 
    /**
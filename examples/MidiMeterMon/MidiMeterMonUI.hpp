@@ -1,19 +1,180 @@
 // Shared DSP and UI elements
 
+#ifndef MIDIMETERMON_UI_HPP_INCLUDED
+#define MIDIMETERMON_UI_HPP_INCLUDED
+
+#include "DistrhoPlugin.hpp"
+#include "MeterBallistics.hpp"
+#include "MidiCapture.hpp"
+#include "MidiStatistics.hpp"
+#include "MidiTiming.hpp"
+#include "SeqLock.hpp"
+#include "SpscRingBuffer.hpp"
+#include "SysExArena.hpp"
+
+/**
+ * Per-channel output parameters.
+ * Each one is repeated for every input channel, see channelParameter().
+ */
+enum ChannelParameters {
+    cChannelParameterOut = 0,
+    cChannelParameterRms,
+    cChannelParameterClip,
+    cChannelParameterTruePeak,
+    cChannelParameterHold,
+    cChannelParameterCount
+};
+
 /**
  * Parameter Enum
  */
 enum Parameters {
-    cParameterOutLeft = 0,
-    cParameterOutRight,
-    cParameterMidiMessage1,
-    cParameterMidiMessage2,
-    cParameterMidiMessage3,
-    cParameterMidiMessage4,
-    cParameterCount
+    cParameterLoudnessReset = 0,
+    cParameterPeakMode,
+    cParameterMeterMode,
+    cParameterPeakHoldTime,
+    cParameterCapture,
+    cParameterLoudnessMomentary,
+    cParameterLoudnessShortTerm,
+    cParameterLoudnessIntegrated,
+    cParameterLoudnessRange,
+    cParameterChannelStart,
+    cParameterCount = cParameterChannelStart + cChannelParameterCount * DISTRHO_PLUGIN_NUM_INPUTS
+};
+
+/**
+ * Index of a per-channel parameter.
+ * Values of one kind are contiguous for all channels (all outs, then all RMS values, ...).
+ */
+static inline uint32_t channelParameter(const uint32_t parameter, const uint32_t channel) noexcept
+{
+    return cParameterChannelStart + parameter * DISTRHO_PLUGIN_NUM_INPUTS + channel;
+}
+
+/**
+ * Values of cParameterPeakMode
+ */
+enum PeakModes {
+    cPeakModeSample = 0,
+    cPeakModeTrue
+};
+
+/**
+ * Number of MIDI events the DSP can queue for the UI between two idle calls.
+ * Events arriving while the ring is full are dropped and counted.
+ */
+#ifndef MIDIMETERMON_EVENT_RING_SIZE
+# define MIDIMETERMON_EVENT_RING_SIZE 8192
+#endif
+
+/**
+ * Number of MIDI events kept and displayed by the UI.
+ */
+#ifndef MIDIMETERMON_HISTORY_DEPTH
+# define MIDIMETERMON_HISTORY_DEPTH 10
+#endif
+
+/**
+ * Bytes of SysEx the DSP can hold for the UI between two idle calls, and the most kept of one message.
+ * Longer messages are truncated, messages arriving while the arena is full lose their data. Both are counted.
+ */
+#ifndef MIDIMETERMON_SYSEX_ARENA_SIZE
+# define MIDIMETERMON_SYSEX_ARENA_SIZE (256 * 1024)
+#endif
+
+#ifndef MIDIMETERMON_SYSEX_MAX_SIZE
+# define MIDIMETERMON_SYSEX_MAX_SIZE (64 * 1024)
+#endif
+
+#define MIDIMETERMON_HISTORY_LINE_SIZE 80
+#define MIDIMETERMON_HISTORY_BUFFER_SIZE ((MIDIMETERMON_HISTORY_DEPTH + 7) * MIDIMETERMON_HISTORY_LINE_SIZE)
+
+START_NAMESPACE_DISTRHO
+
+/**
+ * A MIDI event as seen by the UI.
+ * @a time is the absolute sample position (frames processed before the block plus the event frame).
+ * Events larger than MidiEvent::kDataSize have the first @a dataExtSize bytes copied into
+ * MidiMeterMonShared::sysex, or a null dataExt if it was full. The consumer must release them.
+ */
+struct MidiMeterMonEvent {
+    uint64_t  time;
+    MidiEvent midi;
+    uint32_t  dataExtSize;
+};
+
+typedef SpscRingBuffer<MidiMeterMonEvent> MidiEventRing;
+
+/**
+ * Data shared between DSP and UI through direct access.
+ * The DSP side is the only producer, the UI the only consumer.
+ */
+struct MidiMeterMonShared {
+    MidiEventRing midiEvents;
+
+    /**
+     * Copies of the SysEx messages queued in midiEvents.
+     */
+    SysExArena sysex;
+
+    /**
+     * Absolute sample time of the last clipped sample per channel, kNoClipTime if none.
+     */
+    static const uint64_t kNoClipTime = ~static_cast<uint64_t>(0);
+    std::atomic<uint64_t> lastClipTime[DISTRHO_PLUGIN_NUM_INPUTS];
+
+    /**
+     * Highest peak per channel since the UI last read it (linear).
+     * The DSP raises it with updatePeak(), the UI takes it with consumePeak().
+     */
+    std::atomic<float> peakSinceRead[DISTRHO_PLUGIN_NUM_INPUTS];
+
+    /**
+     * MIDI statistics, published by the DSP every few milliseconds.
+     */
+    SeqLock<MidiStatistics> statistics;
+
+    /**
+     * MIDI timing histograms, published together with the statistics.
+     */
+    SeqLock<MidiTimingStatistics> timing;
+
+    /**
+     * Progress of the MIDI capture to disk.
+     */
+    MidiCaptureStatus capture;
+
+    MidiMeterMonShared()
+        : midiEvents(MIDIMETERMON_EVENT_RING_SIZE),
+          sysex(MIDIMETERMON_SYSEX_ARENA_SIZE, MIDIMETERMON_SYSEX_MAX_SIZE)
+    {
+        for (uint32_t i = 0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
+        {
+            lastClipTime[i].store(kNoClipTime, std::memory_order_relaxed);
+            peakSinceRead[i].store(0.0f, std::memory_order_relaxed);
+        }
+    }
+
+    void updatePeak(const uint32_t channel, const float peak) noexcept
+    {
+        std::atomic<float>& value(peakSinceRead[channel]);
+        float current = value.load(std::memory_order_relaxed);
+
+        while (peak > current && ! value.compare_exchange_weak(current, peak, std::memory_order_relaxed)) {}
+    }
+
+    float consumePeak(const uint32_t channel) noexcept
+    {
+        return peakSinceRead[channel].exchange(0.0f, std::memory_order_relaxed);
+    }
 };
 
-#define MIDI_PARAMETER_COUNT (cParameterCount-2)
-#define MIDI_PARAMETER_OUTPUT_LINE_SIZE 125
-#define MIDI_PARAMETER_BUFFER_SIZE ((MIDI_PARAMETER_COUNT * MIDI_PARAMETER_OUTPUT_LINE_SIZE) + MIDI_PARAMETER_COUNT)
-#define MIDI_PARAMETER_OFFSET (cParameterCount - MIDI_PARAMETER_COUNT)
+/**
+ * Get the shared data from the pointer returned by UI::getPluginInstancePointer().
+ * Returns null if @a pluginInstancePointer is null (host without instance access).
+ */
+MidiMeterMonShared* getMidiMeterMonShared(void* pluginInstancePointer) noexcept;
+
+END_NAMESPACE_DISTRHO
+
+#endif // MIDIMETERMON_UI_HPP_INCLUDED
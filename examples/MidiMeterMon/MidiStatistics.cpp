@@ -0,0 +1,121 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "MidiStatistics.hpp"
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+static const char* const kSystemMessageNames[16] = {
+    "SysEx", "Time Code", "Song Pos", "Song Select", "0xF4", "0xF5", "Tune Request", "SysEx End",
+    "Clock", "0xF9", "Start", "Continue", "Stop", "0xFD", "Active Sense", "Reset"
+};
+
+static double getRate(const uint64_t count, const uint64_t previousCount, const double seconds) noexcept
+{
+    return seconds > 0.0 ? static_cast<double>(count - previousCount) / seconds : 0.0;
+}
+
+void MidiStatistics::dump(std::FILE* const file, const double sampleRate, const MidiStatistics* const previous) const noexcept
+{
+    DISTRHO_SAFE_ASSERT_RETURN(file != nullptr,);
+    DISTRHO_SAFE_ASSERT_RETURN(sampleRate > 0.0,);
+
+    // rates are measured since the previous report, or since the start
+    const uint64_t previousFrames = previous != nullptr ? previous->frames : 0;
+    const double seconds = static_cast<double>(frames - previousFrames) / sampleRate;
+
+    std::fprintf(file, "MIDI statistics at %.3f s: %llu events, %.1f events/s, peak %u events per block\n",
+                 static_cast<double>(frames) / sampleRate,
+                 static_cast<unsigned long long>(events),
+                 getRate(events, previous != nullptr ? previous->events : 0, seconds),
+                 peakEventsPerBlock);
+
+    std::fprintf(file, "  ch     events   events/s    note on   note off  balance  aftertch    control  program  pressure       bend\n");
+
+    for (uint32_t c = 0; c < kChannelCount; ++c)
+    {
+        const MidiChannelStatistics& channel(channels[c]);
+        const uint64_t count = channel.getEventCount();
+
+        if (count == 0)
+            continue;
+
+        const uint64_t previousCount = previous != nullptr ? previous->channels[c].getEventCount() : 0;
+
+        std::fprintf(file, "  %2u %10llu %10.1f %10llu %10llu %8lld %9llu %10llu %8llu %9llu %10llu\n",
+                     c + 1,
+                     static_cast<unsigned long long>(count),
+                     getRate(count, previousCount, seconds),
+                     static_cast<unsigned long long>(channel.messages[MidiChannelStatistics::kNoteOn]),
+                     static_cast<unsigned long long>(channel.messages[MidiChannelStatistics::kNoteOff]),
+                     static_cast<long long>(channel.getNoteBalance()),
+                     static_cast<unsigned long long>(channel.messages[MidiChannelStatistics::kAftertouch]),
+                     static_cast<unsigned long long>(channel.messages[MidiChannelStatistics::kControlChange]),
+                     static_cast<unsigned long long>(channel.messages[MidiChannelStatistics::kProgramChange]),
+                     static_cast<unsigned long long>(channel.messages[MidiChannelStatistics::kChannelPressure]),
+                     static_cast<unsigned long long>(channel.messages[MidiChannelStatistics::kPitchBend]));
+
+        if (channel.messages[MidiChannelStatistics::kNoteOn] != 0)
+        {
+            std::fprintf(file, "     velocity");
+
+            for (uint32_t i = 0; i < MidiChannelStatistics::kVelocityBinCount; ++i)
+                std::fprintf(file, " %u", channel.velocities[i]);
+
+            std::fprintf(file, "\n");
+        }
+
+        if (channel.messages[MidiChannelStatistics::kControlChange] != 0)
+        {
+            std::fprintf(file, "     controls");
+
+            for (uint32_t i = 0; i < 128; ++i)
+            {
+                if (channel.controllers[i] != 0)
+                    std::fprintf(file, " cc%u:%u", i, channel.controllers[i]);
+            }
+
+            std::fprintf(file, "\n");
+        }
+    }
+
+    bool hasSystem = false;
+
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        if (system[i] == 0)
+            continue;
+
+        if (! hasSystem)
+        {
+            std::fprintf(file, "  system");
+            hasSystem = true;
+        }
+
+        std::fprintf(file, " %s:%llu", kSystemMessageNames[i], static_cast<unsigned long long>(system[i]));
+    }
+
+    if (hasSystem)
+        std::fprintf(file, "\n");
+
+    std::fflush(file);
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -0,0 +1,177 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef MIDI_STATISTICS_HPP_INCLUDED
+#define MIDI_STATISTICS_HPP_INCLUDED
+
+#include "DistrhoPlugin.hpp"
+
+#include <cstdio>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+/**
+   Counters of one MIDI channel.
+   Message types are indexed by the high nibble of the status byte minus 8 (note off is 0, pitch bend is 6).
+ */
+struct MidiChannelStatistics {
+    static const uint32_t kMessageTypeCount = 7;
+    static const uint32_t kVelocityBinCount = 16;
+
+    enum MessageType {
+        kNoteOff = 0,
+        kNoteOn,
+        kAftertouch,
+        kControlChange,
+        kProgramChange,
+        kChannelPressure,
+        kPitchBend
+    };
+
+   /**
+      Messages received per type, note-ons with a velocity of 0 are counted as note-offs.
+    */
+    uint64_t messages[kMessageTypeCount];
+
+   /**
+      Note-on velocities (1 to 127), 8 velocity values per bin.
+    */
+    uint32_t velocities[kVelocityBinCount];
+
+   /**
+      Control changes received per controller number.
+    */
+    uint32_t controllers[128];
+
+    uint64_t getEventCount() const noexcept
+    {
+        uint64_t count = 0;
+
+        for (uint32_t i = 0; i < kMessageTypeCount; ++i)
+            count += messages[i];
+
+        return count;
+    }
+
+   /**
+      Note-ons minus note-offs, stays above 0 while notes are held or after lost note-offs.
+    */
+    int64_t getNoteBalance() const noexcept
+    {
+        return static_cast<int64_t>(messages[kNoteOn] - messages[kNoteOff]);
+    }
+};
+
+/**
+   MIDI statistics of one plugin instance.
+
+   The DSP owns one instance and updates it with plain increments from run(),
+   it is published to the UI through a SeqLock, see MidiMeterMonShared.
+ */
+struct MidiStatistics {
+    static const uint32_t kChannelCount = 16;
+
+   /**
+      Frames processed when these statistics were taken, the time base of all rates.
+    */
+    uint64_t frames;
+
+   /**
+      Events received so far, of any type.
+    */
+    uint64_t events;
+
+   /**
+      Highest number of events received in a single block.
+    */
+    uint32_t peakEventsPerBlock;
+
+   /**
+      System messages received per status byte (0xF0 to 0xFF), oversized events count as SysEx.
+    */
+    uint64_t system[16];
+
+    MidiChannelStatistics channels[kChannelCount];
+
+   /**
+      Count one block of events, called from the audio thread.
+    */
+    void process(const MidiEvent* const midiEvents, const uint32_t midiEventCount, const uint32_t blockFrames) noexcept
+    {
+        frames += blockFrames;
+        events += midiEventCount;
+
+        if (midiEventCount > peakEventsPerBlock)
+            peakEventsPerBlock = midiEventCount;
+
+        for (uint32_t i = 0; i < midiEventCount; ++i)
+        {
+            const MidiEvent& midiEvent(midiEvents[i]);
+
+            if (midiEvent.size > MidiEvent::kDataSize)
+            {
+                ++system[0];
+                continue;
+            }
+            if (midiEvent.size == 0)
+                continue;
+
+            const uint8_t* const data(midiEvent.data);
+            const uint8_t status = data[0];
+
+            if (status >= 0xF0)
+            {
+                ++system[status & 0x0F];
+                continue;
+            }
+            if (status < 0x80)
+                continue;
+
+            MidiChannelStatistics& channel(channels[status & 0x0F]);
+            uint32_t type = (status >> 4) - 8;
+
+            if (type == MidiChannelStatistics::kNoteOn)
+            {
+                const uint8_t velocity = midiEvent.size > 2 ? data[2] & 0x7F : 0;
+
+                if (velocity == 0)
+                    type = MidiChannelStatistics::kNoteOff;
+                else
+                    ++channel.velocities[velocity >> 3];
+            }
+            else if (type == MidiChannelStatistics::kControlChange && midiEvent.size > 1)
+            {
+                ++channel.controllers[data[1] & 0x7F];
+            }
+
+            ++channel.messages[type];
+        }
+    }
+
+   /**
+      Write a readable report to @a file.
+      Rates are computed against @a previous (taken earlier from the same instance), which may be null.
+    */
+    void dump(std::FILE* file, double sampleRate, const MidiStatistics* previous) const noexcept;
+};
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // MIDI_STATISTICS_HPP_INCLUDED
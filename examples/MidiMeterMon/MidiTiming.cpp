@@ -0,0 +1,180 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "MidiTiming.hpp"
+
+#include <cmath>
+#include <cstring>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+constexpr double MidiTimingStatistics::kIntervalBucketWidth;
+constexpr double MidiTimingStatistics::kDeviationBucketWidth;
+
+static const uint64_t kNoTime = ~static_cast<uint64_t>(0);
+
+/**
+   Weight of a new clock interval in the measured clock period.
+ */
+static const double kClockAverageWeight = 1.0 / 16.0;
+
+/**
+   Clock intervals further than this factor from the expected period are taken as a stop or a tempo jump,
+   they restart the measurement instead of being counted.
+ */
+static const double kClockGapFactor = 2.0;
+
+/**
+   Largest relative difference between the received clock and the host tempo for the host tempo to be used.
+   A device with its own tempo is measured against its own average instead.
+ */
+static const double kHostTempoTolerance = 0.05;
+
+// -----------------------------------------------------------------------------------------------------------
+
+MidiTimingAnalyzer::MidiTimingAnalyzer() noexcept
+    : fStatistics(),
+      fSampleRate(0.0),
+      fIntervalScale(0.0),
+      fDeviationScale(0.0),
+      fLastNoteOn(kNoTime),
+      fLastClock(kNoTime),
+      fHostClockPeriod(0.0),
+      fMeasuredClockPeriod(0.0),
+      fClockFromHost(false)
+{
+    setSampleRate(48000.0);
+}
+
+void MidiTimingAnalyzer::setSampleRate(const double sampleRate) noexcept
+{
+    DISTRHO_SAFE_ASSERT_RETURN(sampleRate > 0.0,);
+
+    fSampleRate     = sampleRate;
+    fIntervalScale  = 1000.0 / (MidiTimingStatistics::kIntervalBucketWidth * sampleRate);
+    fDeviationScale = 1000.0 / (MidiTimingStatistics::kDeviationBucketWidth * sampleRate);
+
+    reset();
+}
+
+void MidiTimingAnalyzer::reset() noexcept
+{
+    std::memset(&fStatistics, 0, sizeof(fStatistics));
+
+    fLastNoteOn = kNoTime;
+    fLastClock  = kNoTime;
+    fMeasuredClockPeriod = 0.0;
+    fClockFromHost = false;
+}
+
+void MidiTimingAnalyzer::process(const MidiEvent* const midiEvents, const uint32_t midiEventCount,
+                                 const uint64_t blockTime, const double hostTempo) noexcept
+{
+    // 24 clocks per quarter note
+    fHostClockPeriod = hostTempo > 0.0 ? fSampleRate * 60.0 / (hostTempo * 24.0) : 0.0;
+
+    ++fStatistics.blocks;
+    fStatistics.events += midiEventCount;
+    ++fStatistics.eventsPerBlock[midiEventCount < MidiTimingStatistics::kBlockBucketCount
+                                 ? midiEventCount
+                                 : MidiTimingStatistics::kBlockBucketCount - 1];
+
+    for (uint32_t i = 0; i < midiEventCount; ++i)
+    {
+        const MidiEvent& midiEvent(midiEvents[i]);
+        const uint64_t time = blockTime + midiEvent.frame;
+
+        if (midiEvent.frame == 0)
+            ++fStatistics.eventsAtBlockStart;
+
+        if (midiEvent.size == 0 || midiEvent.size > MidiEvent::kDataSize)
+            continue;
+
+        const uint8_t status = midiEvent.data[0];
+
+        switch (status)
+        {
+        case 0xF8:
+            processClock(time);
+            continue;
+
+        case 0xFA: // start
+        case 0xFB: // continue
+        case 0xFC: // stop
+            fLastClock = kNoTime;
+            continue;
+        }
+
+        if ((status & 0xF0) != 0x90 || midiEvent.size < 3 || midiEvent.data[2] == 0)
+            continue;
+
+        if (fLastNoteOn != kNoTime && time >= fLastNoteOn)
+        {
+            const double bucket = static_cast<double>(time - fLastNoteOn) * fIntervalScale;
+
+            ++fStatistics.intervals[bucket < MidiTimingStatistics::kIntervalBucketCount - 1
+                                    ? static_cast<uint32_t>(bucket)
+                                    : MidiTimingStatistics::kIntervalBucketCount - 1];
+        }
+
+        fLastNoteOn = time;
+    }
+
+    fStatistics.clockPeriod = fClockFromHost ? fHostClockPeriod : fMeasuredClockPeriod;
+    fStatistics.clockPeriodFromHost = fClockFromHost;
+}
+
+void MidiTimingAnalyzer::processClock(const uint64_t time) noexcept
+{
+    const uint64_t lastClock = fLastClock;
+    fLastClock = time;
+
+    if (lastClock == kNoTime || time < lastClock)
+        return;
+
+    const double interval = static_cast<double>(time - lastClock);
+    const double measured = fMeasuredClockPeriod;
+
+    // the first interval after a start or a tempo jump only seeds the average
+    const bool restart = measured <= 0.0 || interval > measured * kClockGapFactor || interval < measured / kClockGapFactor;
+
+    fMeasuredClockPeriod = restart ? interval : measured + (interval - measured) * kClockAverageWeight;
+
+    if (restart)
+        return;
+
+    // the host tempo is only trusted while the clock actually follows it
+    fClockFromHost = fHostClockPeriod > 0.0 && std::fabs(measured - fHostClockPeriod) <= fHostClockPeriod * kHostTempoTolerance;
+
+    const double expected = fClockFromHost ? fHostClockPeriod : measured;
+    const double deviation = interval - expected;
+    const double bucket = std::floor(deviation * fDeviationScale) + MidiTimingStatistics::kDeviationBucketCount / 2;
+
+    ++fStatistics.clockDeviations[bucket <= 0.0 ? 0
+                                  : bucket >= MidiTimingStatistics::kDeviationBucketCount - 1
+                                  ? MidiTimingStatistics::kDeviationBucketCount - 1
+                                  : static_cast<uint32_t>(bucket)];
+
+    ++fStatistics.clockCount;
+    fStatistics.clockDeviationSum     += deviation;
+    fStatistics.clockDeviationSquares += deviation * deviation;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
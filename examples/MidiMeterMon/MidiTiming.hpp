@@ -0,0 +1,142 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef MIDI_TIMING_HPP_INCLUDED
+#define MIDI_TIMING_HPP_INCLUDED
+
+#include "DistrhoPlugin.hpp"
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+/**
+   MIDI timing histograms, as published to the UI.
+   All buckets have a fixed width, the last bucket (and the first one for deviations) also collects everything beyond.
+ */
+struct MidiTimingStatistics {
+    static const uint32_t kIntervalBucketCount  = 128;
+    static const uint32_t kDeviationBucketCount = 64;
+    static const uint32_t kBlockBucketCount     = 64;
+
+   /**
+      Bucket widths, in milliseconds.
+      Deviation buckets are centred on 0, bucket kDeviationBucketCount/2 starts at 0.
+    */
+    static constexpr double kIntervalBucketWidth  = 1.0;
+    static constexpr double kDeviationBucketWidth = 0.25;
+
+   /**
+      Time between consecutive note-ons, on any channel.
+    */
+    uint32_t intervals[kIntervalBucketCount];
+
+   /**
+      Time between consecutive MIDI clocks (0xF8) minus the expected clock period.
+    */
+    uint32_t clockDeviations[kDeviationBucketCount];
+
+   /**
+      Blocks by number of events received, including empty blocks.
+    */
+    uint32_t eventsPerBlock[kBlockBucketCount];
+
+    uint64_t blocks;
+    uint64_t events;
+
+   /**
+      Events placed on the first frame of their block.
+      A host or driver that does not pass sample positions puts every event there.
+    */
+    uint64_t eventsAtBlockStart;
+
+   /**
+      Clock intervals measured, and the sum and sum of squares of their deviations (in frames).
+    */
+    uint64_t clockCount;
+    double clockDeviationSum;
+    double clockDeviationSquares;
+
+   /**
+      Expected clock period in frames, 0 if not known yet.
+      It comes from the host tempo when the received clock follows it, otherwise from the average of the received clocks.
+    */
+    double clockPeriod;
+    bool clockPeriodFromHost;
+};
+
+/**
+   MIDI timing analyzer, run on the audio thread.
+
+   Every event is placed on an absolute time line (frames processed before the block plus MidiEvent::frame).
+   Each event costs a constant amount of work: a few compares and at most one histogram increment per histogram.
+ */
+class MidiTimingAnalyzer
+{
+public:
+    MidiTimingAnalyzer() noexcept;
+
+   /**
+      Set the sample rate, this clears the histograms.
+    */
+    void setSampleRate(double sampleRate) noexcept;
+
+   /**
+      Clear the histograms and the timing history.
+    */
+    void reset() noexcept;
+
+   /**
+      Analyze one block of events.
+      @a blockTime is the absolute time of the first frame of the block.
+      @a hostTempo is the host tempo in beats per minute, or 0 if unknown.
+    */
+    void process(const MidiEvent* midiEvents, uint32_t midiEventCount, uint64_t blockTime, double hostTempo) noexcept;
+
+    const MidiTimingStatistics& getStatistics() const noexcept
+    {
+        return fStatistics;
+    }
+
+private:
+    void processClock(uint64_t time) noexcept;
+
+    MidiTimingStatistics fStatistics;
+
+    double fSampleRate;
+
+    // buckets per frame
+    double fIntervalScale;
+    double fDeviationScale;
+
+    // time of the last note-on and clock, kNoTime if none
+    uint64_t fLastNoteOn;
+    uint64_t fLastClock;
+
+    // period from the host tempo (0 if unknown), the running average of the received clock periods
+    // and whether the received clock follows the host tempo
+    double fHostClockPeriod;
+    double fMeasuredClockPeriod;
+    bool   fClockFromHost;
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(MidiTimingAnalyzer)
+};
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // MIDI_TIMING_HPP_INCLUDED
@@ -0,0 +1,102 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SEQ_LOCK_HPP_INCLUDED
+#define SEQ_LOCK_HPP_INCLUDED
+
+#include "DistrhoUtils.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+/**
+   Single-writer sequence lock around a plain data block.
+
+   The writer never waits: write() bumps the sequence to odd, copies the data and bumps it back to even.@n
+   Readers copy the data and retry if the sequence was odd or changed during the copy.
+   read() gives up after a few attempts, so a reader never spins for long against a busy writer.
+
+   @a DataType must be trivially copyable, it is copied with memcpy on both sides.
+ */
+template <class DataType>
+class SeqLock
+{
+public:
+    static_assert(std::is_trivially_copyable<DataType>::value, "SeqLock data must be trivially copyable");
+
+    SeqLock() noexcept
+        : fSequence(0),
+          fData() {}
+
+   /**
+      Publish a new copy of the data, writer side.
+      Only one thread may write.
+    */
+    void write(const DataType& data) noexcept
+    {
+        const uint32_t sequence = fSequence.load(std::memory_order_relaxed);
+
+        fSequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        std::memcpy(&fData, &data, sizeof(DataType));
+
+        fSequence.store(sequence + 2, std::memory_order_release);
+    }
+
+   /**
+      Copy the last published data, reader side.@n
+      Returns false if no consistent copy could be taken, @a data may then hold a torn copy and should be ignored.
+    */
+    bool read(DataType& data, const uint32_t attempts = 4) const noexcept
+    {
+        for (uint32_t i = 0; i < attempts; ++i)
+        {
+            const uint32_t sequence = fSequence.load(std::memory_order_acquire);
+
+            if (sequence & 1)
+                continue;
+
+            std::memcpy(&data, &fData, sizeof(DataType));
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (fSequence.load(std::memory_order_relaxed) == sequence)
+                return true;
+        }
+
+        return false;
+    }
+
+private:
+    // keeps the sequence and the data off the cache lines of neighbouring members
+    char fPad1[64];
+    std::atomic<uint32_t> fSequence;
+    DataType fData;
+    char fPad2[64];
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(SeqLock)
+};
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // SEQ_LOCK_HPP_INCLUDED
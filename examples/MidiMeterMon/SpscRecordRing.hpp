@@ -0,0 +1,184 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SPSC_RECORD_RING_HPP_INCLUDED
+#define SPSC_RECORD_RING_HPP_INCLUDED
+
+#include "DistrhoUtils.hpp"
+
+#include <atomic>
+#include <cstring>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+/**
+   Bounded single-producer/single-consumer ring of variable-length records.
+
+   Each record is stored as its size followed by its bytes, wrapping around the end of the storage.
+   The storage is allocated once in the constructor, push() and pop() never allocate or lock.@n
+   A record is either written whole or dropped and counted, the consumer never sees a partial record.
+ */
+class SpscRecordRing
+{
+public:
+   /**
+      Constructor, @a capacity (in bytes) is rounded up to the next power of two.
+    */
+    explicit SpscRecordRing(const uint32_t capacity)
+        : fCapacity(nextPowerOfTwo(capacity)),
+          fMask(fCapacity - 1),
+          fBuffer(new uint8_t[fCapacity]),
+          fHead(0),
+          fPushedCount(0),
+          fDroppedCount(0),
+          fTail(0) {}
+
+    ~SpscRecordRing()
+    {
+        delete[] fBuffer;
+    }
+
+    uint32_t getCapacity() const noexcept
+    {
+        return fCapacity;
+    }
+
+   /**
+      Push one record made of @a firstSize bytes from @a first followed by @a secondSize bytes from @a second.
+      Producer side. Returns false if there is not enough space, in which case the record is counted as dropped.
+    */
+    bool push(const void* const first, const uint32_t firstSize,
+              const void* const second, const uint32_t secondSize) noexcept
+    {
+        const uint32_t size = firstSize + secondSize;
+        const uint32_t head = fHead.load(std::memory_order_relaxed);
+
+        if (fCapacity - (head - fTail.load(std::memory_order_acquire)) < sizeof(uint32_t) + size)
+        {
+            fDroppedCount.store(fDroppedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        uint32_t pos = head;
+        pos = copyIn(pos, &size, sizeof(uint32_t));
+        pos = copyIn(pos, first, firstSize);
+        pos = copyIn(pos, second, secondSize);
+
+        fHead.store(pos, std::memory_order_release);
+        fPushedCount.store(fPushedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+   /**
+      Pop the oldest record into @a buffer, consumer side.@n
+      Returns the record size, or 0 if the ring is empty.
+      Records larger than @a bufferSize are skipped and @a bufferSize + 1 is returned.
+    */
+    uint32_t pop(void* const buffer, const uint32_t bufferSize) noexcept
+    {
+        const uint32_t tail = fTail.load(std::memory_order_relaxed);
+
+        if (tail == fHead.load(std::memory_order_acquire))
+            return 0;
+
+        uint32_t size;
+        uint32_t pos = copyOut(tail, &size, sizeof(uint32_t));
+
+        if (size > bufferSize)
+        {
+            fTail.store(pos + size, std::memory_order_release);
+            return bufferSize + 1;
+        }
+
+        pos = copyOut(pos, buffer, size);
+        fTail.store(pos, std::memory_order_release);
+        return size;
+    }
+
+   /**
+      Total number of records pushed and dropped since creation.@n
+      These only ever increase, the consumer can read them at any time.
+    */
+    uint64_t getPushedCount() const noexcept
+    {
+        return fPushedCount.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getDroppedCount() const noexcept
+    {
+        return fDroppedCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    static uint32_t nextPowerOfTwo(uint32_t size) noexcept
+    {
+        uint32_t ret = 2;
+
+        while (ret < size)
+            ret <<= 1;
+
+        return ret;
+    }
+
+    // positions are free running, only their low bits address the buffer
+    uint32_t copyIn(const uint32_t pos, const void* const data, const uint32_t size) noexcept
+    {
+        if (size == 0)
+            return pos;
+
+        const uint32_t offset = pos & fMask;
+        const uint32_t first  = size < fCapacity - offset ? size : fCapacity - offset;
+
+        std::memcpy(fBuffer + offset, data, first);
+        std::memcpy(fBuffer, static_cast<const uint8_t*>(data) + first, size - first);
+        return pos + size;
+    }
+
+    uint32_t copyOut(const uint32_t pos, void* const data, const uint32_t size) const noexcept
+    {
+        const uint32_t offset = pos & fMask;
+        const uint32_t first  = size < fCapacity - offset ? size : fCapacity - offset;
+
+        std::memcpy(data, fBuffer + offset, first);
+        std::memcpy(static_cast<uint8_t*>(data) + first, fBuffer, size - first);
+        return pos + size;
+    }
+
+    const uint32_t fCapacity;
+    const uint32_t fMask;
+    uint8_t* const fBuffer;
+
+    // producer owned, padded so it never shares a cache line with the consumer index
+    char fPad1[64];
+    std::atomic<uint32_t> fHead;
+    std::atomic<uint64_t> fPushedCount;
+    std::atomic<uint64_t> fDroppedCount;
+    char fPad2[64];
+
+    // consumer owned
+    std::atomic<uint32_t> fTail;
+    char fPad3[64];
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(SpscRecordRing)
+};
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // SPSC_RECORD_RING_HPP_INCLUDED
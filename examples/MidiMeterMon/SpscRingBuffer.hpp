@@ -0,0 +1,152 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SPSC_RING_BUFFER_HPP_INCLUDED
+#define SPSC_RING_BUFFER_HPP_INCLUDED
+
+#include "DistrhoUtils.hpp"
+
+#include <atomic>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+/**
+   Bounded single-producer/single-consumer ring buffer.
+
+   The storage is allocated once in the constructor, push() and pop() never allocate or lock.@n
+   push() must only be called from one thread (the audio thread), pop() from one other thread (the UI).@n
+   When the ring is full new elements are dropped and counted, old elements are never overwritten.
+ */
+template <class ElementType>
+class SpscRingBuffer
+{
+public:
+   /**
+      Constructor, @a capacity is rounded up to the next power of two.
+    */
+    explicit SpscRingBuffer(const uint32_t capacity)
+        : fCapacity(nextPowerOfTwo(capacity)),
+          fMask(fCapacity - 1),
+          fElements(new ElementType[fCapacity]),
+          fHead(0),
+          fPushedCount(0),
+          fDroppedCount(0),
+          fTail(0) {}
+
+    ~SpscRingBuffer()
+    {
+        delete[] fElements;
+    }
+
+    uint32_t getCapacity() const noexcept
+    {
+        return fCapacity;
+    }
+
+   /**
+      Push an element, producer side.@n
+      Returns false if the ring is full, in which case the element is counted as dropped.
+    */
+    bool push(const ElementType& element) noexcept
+    {
+        const uint32_t head = fHead.load(std::memory_order_relaxed);
+
+        if (head - fTail.load(std::memory_order_acquire) >= fCapacity)
+        {
+            fDroppedCount.store(fDroppedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        fElements[head & fMask] = element;
+        fHead.store(head + 1, std::memory_order_release);
+        fPushedCount.store(fPushedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+   /**
+      Pop the oldest element, consumer side.@n
+      Returns false if the ring is empty.
+    */
+    bool pop(ElementType& element) noexcept
+    {
+        const uint32_t tail = fTail.load(std::memory_order_relaxed);
+
+        if (tail == fHead.load(std::memory_order_acquire))
+            return false;
+
+        element = fElements[tail & fMask];
+        fTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+   /**
+      Number of elements waiting to be popped, safe to call from either side.
+    */
+    uint32_t getReadableCount() const noexcept
+    {
+        return fHead.load(std::memory_order_acquire) - fTail.load(std::memory_order_acquire);
+    }
+
+   /**
+      Total number of elements pushed and dropped since creation.@n
+      These only ever increase, the consumer can read them at any time.
+    */
+    uint64_t getPushedCount() const noexcept
+    {
+        return fPushedCount.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getDroppedCount() const noexcept
+    {
+        return fDroppedCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    static uint32_t nextPowerOfTwo(uint32_t size) noexcept
+    {
+        uint32_t ret = 2;
+
+        while (ret < size)
+            ret <<= 1;
+
+        return ret;
+    }
+
+    const uint32_t fCapacity;
+    const uint32_t fMask;
+    ElementType* const fElements;
+
+    // producer owned, padded so it never shares a cache line with the consumer index
+    char fPad1[64];
+    std::atomic<uint32_t> fHead;
+    std::atomic<uint64_t> fPushedCount;
+    std::atomic<uint64_t> fDroppedCount;
+    char fPad2[64];
+
+    // consumer owned
+    std::atomic<uint32_t> fTail;
+    char fPad3[64];
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(SpscRingBuffer)
+};
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // SPSC_RING_BUFFER_HPP_INCLUDED
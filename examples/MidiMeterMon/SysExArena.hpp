@@ -0,0 +1,154 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SYSEX_ARENA_HPP_INCLUDED
+#define SYSEX_ARENA_HPP_INCLUDED
+
+#include "DistrhoUtils.hpp"
+
+#include <atomic>
+#include <cstring>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+/**
+   Fixed-capacity storage for SysEx messages passed from the audio thread to one consumer.
+
+   MidiEvent::dataExt only stays valid during run(), so the producer copies each large message here
+   with store(), a bump allocation that never locks or allocates. The consumer calls release() for every
+   message once it is done with it, and as soon as all stored bytes are released the producer starts
+   again from the beginning of the buffer. Data is published by whatever carries the returned pointer
+   to the consumer, usually a SpscRingBuffer, the arena itself only synchronizes the release.
+
+   Messages longer than the maximum message size are truncated, messages that do not fit the remaining
+   space are not stored. Both are counted.
+ */
+class SysExArena
+{
+public:
+   /**
+      Constructor, @a capacity is the total storage in bytes, @a maxMessageSize the most bytes kept of one message.
+    */
+    SysExArena(const uint32_t capacity, const uint32_t maxMessageSize)
+        : fCapacity(capacity),
+          fMaxMessageSize(maxMessageSize < capacity ? maxMessageSize : capacity),
+          fData(new uint8_t[capacity]),
+          fOffset(0),
+          fAllocated(0),
+          fTruncatedCount(0),
+          fOverflowCount(0),
+          fReleased(0) {}
+
+    ~SysExArena()
+    {
+        delete[] fData;
+    }
+
+   /**
+      Copy a message, producer side.@n
+      Returns the copy and sets @a storedSize to the number of bytes kept,
+      or returns null if the arena is full, in which case the message is counted as an overflow.
+    */
+    const uint8_t* store(const uint8_t* const data, const uint32_t size, uint32_t& storedSize) noexcept
+    {
+        storedSize = 0;
+        DISTRHO_SAFE_ASSERT_RETURN(data != nullptr && size != 0, nullptr);
+
+        // everything handed out so far was released, start over
+        if (fOffset != 0 && fReleased.load(std::memory_order_acquire) == fAllocated)
+            fOffset = 0;
+
+        const uint32_t stored = size < fMaxMessageSize ? size : fMaxMessageSize;
+
+        if (stored > fCapacity - fOffset)
+        {
+            fOverflowCount.store(fOverflowCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        if (stored < size)
+            fTruncatedCount.store(fTruncatedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        uint8_t* const copy = fData + fOffset;
+        std::memcpy(copy, data, stored);
+
+        fOffset += stored;
+        fAllocated += stored;
+        storedSize = stored;
+        return copy;
+    }
+
+   /**
+      Take back the last stored message, producer side.@n
+      Used when the message could not be handed to the consumer after all.
+    */
+    void discard(const uint32_t storedSize) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(storedSize <= fOffset,);
+
+        fOffset -= storedSize;
+        fAllocated -= storedSize;
+    }
+
+   /**
+      Give back a message of @a storedSize bytes, consumer side.@n
+      The data must not be read after this.
+    */
+    void release(const uint32_t storedSize) noexcept
+    {
+        fReleased.store(fReleased.load(std::memory_order_relaxed) + storedSize, std::memory_order_release);
+    }
+
+   /**
+      Total number of truncated and not stored messages since creation.
+    */
+    uint64_t getTruncatedCount() const noexcept
+    {
+        return fTruncatedCount.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getOverflowCount() const noexcept
+    {
+        return fOverflowCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    const uint32_t fCapacity;
+    const uint32_t fMaxMessageSize;
+    uint8_t* const fData;
+
+    // producer owned, padded so it never shares a cache line with the consumer total
+    char fPad1[64];
+    uint32_t fOffset;
+    uint64_t fAllocated;
+    std::atomic<uint64_t> fTruncatedCount;
+    std::atomic<uint64_t> fOverflowCount;
+    char fPad2[64];
+
+    // consumer owned
+    std::atomic<uint64_t> fReleased;
+    char fPad3[64];
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(SysExArena)
+};
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // SYSEX_ARENA_HPP_INCLUDED
@@ -0,0 +1,159 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "TruePeakMeter.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE__)
+# define TRUE_PEAK_METER_HAVE_SSE 1
+# include <xmmintrin.h>
+#endif
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+// Coefficient table
+
+static const uint32_t kOversampling = TruePeakMeter::kOversampling;
+static const uint32_t kTapsPerPhase = TruePeakMeter::kTapsPerPhase;
+
+/**
+   Interpolation filter from ITU-R BS.1770-4 annex 2, one row per phase.
+   Using the normative table (rather than designing our own lowpass) keeps the passband flat up to
+   20 kHz at 48 kHz and makes readings match other compliant meters.
+ */
+static const float kPhaseCoefficients[kOversampling][kTapsPerPhase] = {
+    {  0.0017089843750f,  0.0109863281250f, -0.0196533203125f,  0.0332031250000f,
+      -0.0594482421875f,  0.1373291015625f,  0.9721679687500f, -0.1022949218750f,
+       0.0476074218750f, -0.0266113281250f,  0.0148925781250f, -0.0083007812500f },
+    { -0.0291748046875f,  0.0292968750000f, -0.0517578125000f,  0.0891113281250f,
+      -0.1665039062500f,  0.4650878906250f,  0.7797851562500f, -0.2003173828125f,
+       0.1015625000000f, -0.0582275390625f,  0.0330810546875f, -0.0189208984375f },
+    { -0.0189208984375f,  0.0330810546875f, -0.0582275390625f,  0.1015625000000f,
+      -0.2003173828125f,  0.7797851562500f,  0.4650878906250f, -0.1665039062500f,
+       0.0891113281250f, -0.0517578125000f,  0.0292968750000f, -0.0291748046875f },
+    { -0.0083007812500f,  0.0148925781250f, -0.0266113281250f,  0.0476074218750f,
+      -0.1022949218750f,  0.9721679687500f,  0.1373291015625f, -0.0594482421875f,
+       0.0332031250000f, -0.0196533203125f,  0.0109863281250f,  0.0017089843750f }
+};
+
+struct TruePeakCoefficients {
+   /**
+      Row j holds the coefficients of all phases applied to the j-th oldest sample of the history.
+    */
+#ifdef TRUE_PEAK_METER_HAVE_SSE
+    __m128 rows[kTapsPerPhase];
+#else
+    float rows[kTapsPerPhase][kOversampling];
+#endif
+
+    TruePeakCoefficients() noexcept
+    {
+        float table[kTapsPerPhase][kOversampling];
+
+        // the newest sample of the history meets tap 0
+        for (uint32_t p = 0; p < kOversampling; ++p)
+            for (uint32_t k = 0; k < kTapsPerPhase; ++k)
+                table[kTapsPerPhase - 1 - k][p] = kPhaseCoefficients[p][k];
+
+#ifdef TRUE_PEAK_METER_HAVE_SSE
+        for (uint32_t j = 0; j < kTapsPerPhase; ++j)
+            rows[j] = _mm_loadu_ps(table[j]);
+#else
+        std::memcpy(rows, table, sizeof(rows));
+#endif
+    }
+};
+
+static const TruePeakCoefficients sCoefficients;
+
+// -----------------------------------------------------------------------------------------------------------
+
+TruePeakMeter::TruePeakMeter() noexcept
+    : fHistory(),
+      fHistoryPos(0) {}
+
+void TruePeakMeter::reset() noexcept
+{
+    std::memset(fHistory, 0, sizeof(fHistory));
+    fHistoryPos = 0;
+}
+
+float TruePeakMeter::process(const float* const input, const uint32_t frames) noexcept
+{
+    float* const history = fHistory;
+    uint32_t pos = fHistoryPos;
+
+#ifdef TRUE_PEAK_METER_HAVE_SSE
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 peak = _mm_setzero_ps();
+
+    for (uint32_t i = 0; i < frames; ++i)
+    {
+        history[pos] = history[pos + kTapsPerPhase] = input[i];
+
+        if (++pos == kTapsPerPhase)
+            pos = 0;
+
+        // history[pos] is now the oldest sample, history[pos + kTapsPerPhase - 1] the newest
+        const float* const window = history + pos;
+
+        __m128 acc = _mm_mul_ps(_mm_set1_ps(window[0]), sCoefficients.rows[0]);
+
+        for (uint32_t j = 1; j < kTapsPerPhase; ++j)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(window[j]), sCoefficients.rows[j]));
+
+        peak = _mm_max_ps(peak, _mm_andnot_ps(signMask, acc));
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, peak);
+
+    fHistoryPos = pos;
+    return std::fmax(std::fmax(lanes[0], lanes[1]), std::fmax(lanes[2], lanes[3]));
+#else
+    float peak = 0.0f;
+
+    for (uint32_t i = 0; i < frames; ++i)
+    {
+        history[pos] = history[pos + kTapsPerPhase] = input[i];
+
+        if (++pos == kTapsPerPhase)
+            pos = 0;
+
+        const float* const window = history + pos;
+
+        for (uint32_t p = 0; p < kOversampling; ++p)
+        {
+            float acc = 0.0f;
+
+            for (uint32_t j = 0; j < kTapsPerPhase; ++j)
+                acc += window[j] * sCoefficients.rows[j][p];
+
+            peak = std::fmax(peak, std::fabs(acc));
+        }
+    }
+
+    fHistoryPos = pos;
+    return peak;
+#endif
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -0,0 +1,63 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef TRUE_PEAK_METER_HPP_INCLUDED
+#define TRUE_PEAK_METER_HPP_INCLUDED
+
+#include "DistrhoUtils.hpp"
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+/**
+   True-peak detector for one channel, as described in ITU-R BS.1770 annex 2.
+
+   The input is upsampled 4x by the 48 tap polyphase FIR (12 taps per phase) given in the annex.
+   The coefficient table is computed once and stored transposed, so a single 4-wide vector
+   multiply-add per tap produces all 4 interpolated samples of an input sample.
+ */
+class TruePeakMeter
+{
+public:
+    static const uint32_t kOversampling = 4;
+    static const uint32_t kTapsPerPhase = 12;
+
+    TruePeakMeter() noexcept;
+
+   /**
+      Clear the filter history.
+    */
+    void reset() noexcept;
+
+   /**
+      Process @a frames samples and return the highest absolute interpolated value (linear).
+    */
+    float process(const float* input, uint32_t frames) noexcept;
+
+private:
+    // each sample is written twice so the last kTapsPerPhase samples are always contiguous
+    float    fHistory[kTapsPerPhase * 2];
+    uint32_t fHistoryPos;
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(TruePeakMeter)
+};
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // TRUE_PEAK_METER_HPP_INCLUDED
@@ -0,0 +1,232 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Checks LoudnessMeter against the synthetic cases of EBU Tech 3341 (loudness) and Tech 3342 (loudness range).
+// The cases that need programme material or more than two channels are left out.
+
+#include "LoudnessMeter.hpp"
+
+#include <cmath>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+// Feeds a stereo 1 kHz sine of changing level to a LoudnessMeter
+class SineFeeder
+{
+public:
+    static const uint32_t kChunkSize = 480;
+
+    SineFeeder(LoudnessMeter& meter, const double sampleRate)
+        : fMeter(meter),
+          fSampleRate(sampleRate),
+          fPhase(0.0),
+          fFrames(0)
+    {
+        fMeter.setSampleRate(sampleRate);
+    }
+
+    // @a seconds of sine at @a dbfs peak level, @a check is called after every chunk
+    template <class Check>
+    void feed(const double dbfs, const double seconds, Check& check)
+    {
+        const float amplitude = static_cast<float>(std::pow(10.0, dbfs / 20.0));
+        const double increment = 2.0 * M_PI * 1000.0 / fSampleRate;
+        const float* const inputs[2] = { fBuffer, fBuffer };
+
+        for (uint64_t remaining = static_cast<uint64_t>(seconds * fSampleRate + 0.5); remaining != 0;)
+        {
+            const uint32_t todo = remaining < kChunkSize ? static_cast<uint32_t>(remaining) : kChunkSize;
+
+            for (uint32_t i = 0; i < todo; ++i)
+            {
+                fBuffer[i] = amplitude * static_cast<float>(std::sin(fPhase));
+                fPhase = std::fmod(fPhase + increment, 2.0 * M_PI);
+            }
+
+            fMeter.process(inputs, 2, todo);
+            fFrames += todo;
+            remaining -= todo;
+
+            check(fMeter, static_cast<double>(fFrames) / fSampleRate);
+        }
+    }
+
+    void feed(const double dbfs, const double seconds)
+    {
+        NoCheck noCheck;
+        feed(dbfs, seconds, noCheck);
+    }
+
+private:
+    struct NoCheck {
+        void operator()(const LoudnessMeter&, double) {}
+    };
+
+    LoudnessMeter& fMeter;
+    const double fSampleRate;
+    double fPhase;
+    uint64_t fFrames;
+    float fBuffer[kChunkSize];
+};
+
+static uint32_t gFailures = 0;
+
+static void expect(const char* const name, const char* const what, const float value,
+                   const float expected, const float tolerance)
+{
+    const bool ok = std::fabs(value - expected) <= tolerance;
+
+    d_stdout("  %-40s %-10s %7.2f, expected %6.1f +/- %.1f%s", name, what, value, expected, tolerance,
+             ok ? "" : "  FAILED");
+
+    if (! ok)
+        ++gFailures;
+}
+
+// Short-term loudness must stay within tolerance once the first 3 s are in
+struct ShortTermCheck {
+    float worst;
+
+    ShortTermCheck()
+        : worst(-23.0f) {}
+
+    void operator()(const LoudnessMeter& meter, const double time)
+    {
+        if (time >= 3.0 && std::fabs(meter.getShortTerm() + 23.0f) > std::fabs(worst + 23.0f))
+            worst = meter.getShortTerm();
+    }
+};
+
+// -----------------------------------------------------------------------------------------------------------
+
+static void testTech3341(const double sampleRate)
+{
+    d_stdout("EBU Tech 3341 at %.0f Hz:", sampleRate);
+
+    LoudnessMeter meter;
+
+    // case 1 and 2: constant level, all three values match it
+    {
+        SineFeeder feeder(meter, sampleRate);
+        feeder.feed(-23.0, 20.0);
+        expect("1: -23 dBFS 20 s", "momentary",  meter.getMomentary(),  -23.0f, 0.1f);
+        expect("1: -23 dBFS 20 s", "short-term", meter.getShortTerm(),  -23.0f, 0.1f);
+        expect("1: -23 dBFS 20 s", "integrated", meter.getIntegrated(), -23.0f, 0.1f);
+    }
+    {
+        SineFeeder feeder(meter, sampleRate);
+        feeder.feed(-33.0, 20.0);
+        expect("2: -33 dBFS 20 s", "momentary",  meter.getMomentary(),  -33.0f, 0.1f);
+        expect("2: -33 dBFS 20 s", "short-term", meter.getShortTerm(),  -33.0f, 0.1f);
+        expect("2: -33 dBFS 20 s", "integrated", meter.getIntegrated(), -33.0f, 0.1f);
+    }
+
+    // case 3: quieter parts are removed by the relative gate
+    {
+        SineFeeder feeder(meter, sampleRate);
+        feeder.feed(-36.0, 10.0);
+        feeder.feed(-23.0, 60.0);
+        feeder.feed(-36.0, 10.0);
+        expect("3: -36/-23/-36 dBFS 10/60/10 s", "integrated", meter.getIntegrated(), -23.0f, 0.1f);
+    }
+
+    // case 4: and silence-like parts by the absolute gate
+    {
+        SineFeeder feeder(meter, sampleRate);
+        feeder.feed(-72.0, 10.0);
+        feeder.feed(-36.0, 10.0);
+        feeder.feed(-23.0, 60.0);
+        feeder.feed(-36.0, 10.0);
+        feeder.feed(-72.0, 10.0);
+        expect("4: -72/-36/-23/-36/-72 dBFS", "integrated", meter.getIntegrated(), -23.0f, 0.1f);
+    }
+
+    // case 5: louder middle part, all above the relative gate
+    {
+        SineFeeder feeder(meter, sampleRate);
+        feeder.feed(-26.0, 20.0);
+        feeder.feed(-20.0, 20.1);
+        feeder.feed(-26.0, 20.0);
+        expect("5: -26/-20/-26 dBFS 20/20.1/20 s", "integrated", meter.getIntegrated(), -23.0f, 0.1f);
+    }
+
+    // case 9: every 3 s window holds the same mix of both levels
+    {
+        SineFeeder feeder(meter, sampleRate);
+        ShortTermCheck check;
+
+        for (uint32_t i = 0; i < 20; ++i)
+        {
+            feeder.feed(-20.0, 1.34, check);
+            feeder.feed(-30.0, 1.66, check);
+        }
+
+        expect("9: 20x -20/-30 dBFS 1.34/1.66 s", "short-term", check.worst, -23.0f, 0.1f);
+    }
+}
+
+static void testTech3342(const double sampleRate)
+{
+    d_stdout("EBU Tech 3342 at %.0f Hz:", sampleRate);
+
+    static const struct {
+        const char* name;
+        double levels[5];
+        uint32_t levelCount;
+        float range;
+    } kCases[] = {
+        { "1: -20/-30 dBFS 20 s each",         { -20.0, -30.0 },                      2, 10.0f },
+        { "2: -20/-15 dBFS 20 s each",         { -20.0, -15.0 },                      2,  5.0f },
+        { "3: -40/-20 dBFS 20 s each",         { -40.0, -20.0 },                      2, 20.0f },
+        { "4: -50/-35/-20/-35/-50 dBFS 20 s",  { -50.0, -35.0, -20.0, -35.0, -50.0 }, 5, 15.0f },
+    };
+
+    LoudnessMeter meter;
+
+    for (uint32_t c = 0; c < sizeof(kCases)/sizeof(kCases[0]); ++c)
+    {
+        SineFeeder feeder(meter, sampleRate);
+
+        for (uint32_t i = 0; i < kCases[c].levelCount; ++i)
+            feeder.feed(kCases[c].levels[i], 20.0);
+
+        expect(kCases[c].name, "range", meter.getRange(), kCases[c].range, 1.0f);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+int main()
+{
+    USE_NAMESPACE_DISTRHO;
+
+    testTech3341(48000.0);
+    testTech3341(44100.0);
+    testTech3342(48000.0);
+
+    if (gFailures != 0)
+    {
+        d_stderr2("LoudnessTest: %u failures", gFailures);
+        return 1;
+    }
+
+    d_stdout("LoudnessTest: ok");
+    return 0;
+}
@@ -0,0 +1,299 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Checks meterProcessBlock() against a plain scalar loop and times both for common buffer sizes,
+// with and without the sub-block values for the ballistics, then does the same timing for
+// TruePeakMeter against the annex 2 reference (see TruePeakTest).
+
+#include "MeterKernel.hpp"
+#include "TruePeakReference.hpp"
+
+#include "Timer.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+// What the plugin did before MeterKernel: copy, then measure in a second loop
+static void referenceProcessBlock(const float* const input, float* const output, const uint32_t frames,
+                                  MeterBlockStats& stats) noexcept
+{
+    if (output != nullptr && output != input)
+        std::memcpy(output, input, sizeof(float)*frames);
+
+    stats.peak = 0.0f;
+    stats.sumOfSquares = 0.0f;
+    stats.clipCount = 0;
+    stats.firstClipFrame = -1;
+
+    for (uint32_t i = 0; i < frames; ++i)
+    {
+        const float a = std::fabs(input[i]);
+
+        if (a > stats.peak)
+            stats.peak = a;
+
+        stats.sumOfSquares += input[i] * input[i];
+
+        if (a >= 1.0f)
+        {
+            if (stats.firstClipFrame < 0)
+                stats.firstClipFrame = static_cast<int32_t>(i);
+            ++stats.clipCount;
+        }
+    }
+}
+
+// The ballistics pass the engine used to run over the audio again, after the kernel
+static void referenceSubBlocks(const float* const input, const uint32_t frames,
+                               float* const subPeaks, float* const subMeans) noexcept
+{
+    for (uint32_t offset = 0, s = 0; offset < frames; offset += kMeterSubBlockSize, ++s)
+    {
+        const uint32_t todo = frames - offset < kMeterSubBlockSize ? frames - offset : kMeterSubBlockSize;
+        float peak = 0.0f, sum = 0.0f;
+
+        for (uint32_t i = 0; i < todo; ++i)
+        {
+            const float a = std::fabs(input[offset + i]);
+            peak = std::fmax(peak, a);
+            sum += a;
+        }
+
+        subPeaks[s] = peak;
+        subMeans[s] = sum / todo;
+    }
+}
+
+static float randomSample(const float range)
+{
+    return (static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX) * 2.0f - 1.0f) * range;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+static uint32_t checkKernel()
+{
+    uint32_t failures = 0;
+    std::vector<float> input(4096 + 3), output(4096 + 3), refOutput(4096 + 3);
+    std::vector<float> subPeaks(4096 / kMeterSubBlockSize), subMeans(4096 / kMeterSubBlockSize);
+    std::vector<float> refSubPeaks(4096 / kMeterSubBlockSize), refSubMeans(4096 / kMeterSubBlockSize);
+
+    for (uint32_t t = 0; t < 2000; ++t)
+    {
+        // odd sizes and offsets to cover the scalar tails and unaligned loads
+        const uint32_t frames = static_cast<uint32_t>(std::rand()) % 4096;
+        const uint32_t offset = static_cast<uint32_t>(std::rand()) % 4;
+        const float range = t % 3 == 0 ? 1.05f : 0.9f;
+
+        for (uint32_t i = 0; i < frames; ++i)
+            input[offset + i] = randomSample(range);
+
+        MeterBlockStats stats, refStats;
+        referenceProcessBlock(&input[offset], &refOutput[offset], frames, refStats);
+        referenceSubBlocks(&input[offset], frames, refSubPeaks.data(), refSubMeans.data());
+
+        // every other run with the sub-block values
+        if (t % 2 == 0)
+        {
+            meterProcessBlock(&input[offset], &output[offset], frames, stats, subPeaks.data(), subMeans.data());
+
+            for (uint32_t s = 0; s < (frames + kMeterSubBlockSize - 1) / kMeterSubBlockSize; ++s)
+            {
+                if (subPeaks[s] != refSubPeaks[s] || std::fabs(subMeans[s] - refSubMeans[s]) > 1e-6f)
+                {
+                    d_stderr2("MeterKernel sub-block %u mismatch at %u frames", s, frames);
+                    ++failures;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            meterProcessBlock(&input[offset], &output[offset], frames, stats);
+        }
+
+        // lanes sum in a different order, allow for rounding
+        const float sumError = std::fabs(stats.sumOfSquares - refStats.sumOfSquares);
+
+        if (stats.peak != refStats.peak
+            || sumError > 1e-5f * refStats.sumOfSquares + 1e-6f
+            || stats.clipCount != refStats.clipCount
+            || stats.firstClipFrame != refStats.firstClipFrame
+            || std::memcmp(&output[offset], &refOutput[offset], sizeof(float)*frames) != 0)
+        {
+            d_stderr2("MeterKernel mismatch at %u frames", frames);
+            ++failures;
+        }
+    }
+
+    return failures;
+}
+
+static void benchmarkKernel()
+{
+    static const uint32_t kTotalFrames = 1 << 24;
+
+    std::vector<float> input(4096), output(4096);
+
+    for (uint32_t i = 0; i < 4096; ++i)
+        input[i] = randomSample(0.99f);
+
+    d_stdout("MeterKernel (%s), ns per frame:", getMeterKernelName());
+    d_stdout("  frames  reference  kernel  speedup");
+
+    for (uint32_t frames = 16; frames <= 4096; frames *= 2)
+    {
+        const uint32_t iterations = kTotalFrames / frames;
+        MeterBlockStats stats;
+        float sink = 0.0f;
+
+        Timer timer;
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            referenceProcessBlock(input.data(), output.data(), frames, stats);
+            sink += stats.peak;
+        }
+        const double refTime = timer.elapsed();
+
+        timer.reset();
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            meterProcessBlock(input.data(), output.data(), frames, stats);
+            sink += stats.peak;
+        }
+        const double kernelTime = timer.elapsed();
+
+        // keep the loops from being optimized out
+        if (sink < 0.0f)
+            d_stdout("%f", sink);
+
+        d_stdout("  %6u  %9.3f  %6.3f  %6.2fx", frames, refTime * 1e9 / kTotalFrames, kernelTime * 1e9 / kTotalFrames,
+                 refTime / kernelTime);
+    }
+}
+
+// The engine needs the sub-block values too, compare with the second pass it used to run
+static void benchmarkSubBlocks()
+{
+    static const uint32_t kTotalFrames = 1 << 24;
+
+    std::vector<float> input(4096), output(4096);
+    std::vector<float> subPeaks(4096 / kMeterSubBlockSize), subMeans(4096 / kMeterSubBlockSize);
+
+    for (uint32_t i = 0; i < 4096; ++i)
+        input[i] = randomSample(0.99f);
+
+    d_stdout("MeterKernel with sub-blocks, ns per frame:");
+    d_stdout("  frames  two passes  one pass  speedup");
+
+    for (uint32_t frames = 16; frames <= 4096; frames *= 2)
+    {
+        const uint32_t iterations = kTotalFrames / frames;
+        MeterBlockStats stats;
+        float sink = 0.0f;
+
+        Timer timer;
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            meterProcessBlock(input.data(), output.data(), frames, stats);
+            referenceSubBlocks(input.data(), frames, subPeaks.data(), subMeans.data());
+            sink += stats.peak + subMeans[0];
+        }
+        const double twoPassTime = timer.elapsed();
+
+        timer.reset();
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            meterProcessBlock(input.data(), output.data(), frames, stats, subPeaks.data(), subMeans.data());
+            sink += stats.peak + subMeans[0];
+        }
+        const double onePassTime = timer.elapsed();
+
+        if (sink < 0.0f)
+            d_stdout("%f", sink);
+
+        d_stdout("  %6u  %10.3f  %8.3f  %6.2fx", frames, twoPassTime * 1e9 / kTotalFrames,
+                 onePassTime * 1e9 / kTotalFrames, twoPassTime / onePassTime);
+    }
+}
+
+static void benchmarkTruePeak()
+{
+    static const uint32_t kTotalFrames = 1 << 21;
+
+    std::vector<float> input(4096);
+
+    for (uint32_t i = 0; i < 4096; ++i)
+        input[i] = randomSample(0.99f);
+
+    d_stdout("TruePeakMeter, ns per frame:");
+    d_stdout("  frames  reference   meter  speedup");
+
+    for (uint32_t frames = 16; frames <= 4096; frames *= 2)
+    {
+        const uint32_t iterations = kTotalFrames / frames;
+        TruePeakReference reference;
+        TruePeakMeter meter;
+        double sink = 0.0;
+
+        Timer timer;
+        for (uint32_t i = 0; i < iterations; ++i)
+            sink += reference.process(input.data(), frames);
+        const double refTime = timer.elapsed();
+
+        timer.reset();
+        for (uint32_t i = 0; i < iterations; ++i)
+            sink += meter.process(input.data(), frames);
+        const double meterTime = timer.elapsed();
+
+        if (sink < 0.0)
+            d_stdout("%f", sink);
+
+        d_stdout("  %6u  %9.3f  %6.3f  %6.2fx", frames, refTime * 1e9 / kTotalFrames, meterTime * 1e9 / kTotalFrames,
+                 refTime / meterTime);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+int main()
+{
+    USE_NAMESPACE_DISTRHO;
+
+    std::srand(2);
+
+    const uint32_t failures = checkKernel();
+
+    benchmarkKernel();
+    benchmarkSubBlocks();
+    benchmarkTruePeak();
+
+    if (failures != 0)
+    {
+        d_stderr2("MeterKernelBench: %u failures", failures);
+        return 1;
+    }
+
+    d_stdout("MeterKernelBench: ok");
+    return 0;
+}
@@ -0,0 +1,370 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Pushes 1M events through MidiCaptureWriter as fast as the ring takes them, then reads the
+// capture file back and checks every event and its time. Oversized SysEx must be counted, not written.
+
+#include "MidiCapture.hpp"
+
+#include "Timer.hpp"
+
+#include <cstdlib>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+static const uint32_t kEventCount     = 1000000;
+static const uint32_t kOversizedEvery = 100000;
+
+struct ExpectedEvent {
+    uint64_t time;
+    std::vector<uint8_t> data;
+};
+
+// A deterministic mix of channel messages, SysEx of various sizes and a few escaped messages
+static void makeEvent(const uint32_t index, std::vector<uint8_t>& data)
+{
+    const uint32_t kind = index % 97;
+
+    data.clear();
+
+    if (kind == 0)
+    {
+        const uint32_t size = 2 + (index / 97) % 600;
+
+        data.push_back(0xF0);
+        for (uint32_t i = 1; i < size - 1; ++i)
+            data.push_back(static_cast<uint8_t>((index + i) & 0x7F));
+        data.push_back(0xF7);
+    }
+    else if (kind == 1)
+    {
+        data.push_back(0xF8);
+    }
+    else if (kind % 5 == 0)
+    {
+        data.push_back(static_cast<uint8_t>(0xC0 | (index & 0x0F)));
+        data.push_back(static_cast<uint8_t>(index & 0x7F));
+    }
+    else
+    {
+        data.push_back(static_cast<uint8_t>((kind % 2 ? 0x90 : 0x80) | (index & 0x0F)));
+        data.push_back(static_cast<uint8_t>(index & 0x7F));
+        data.push_back(static_cast<uint8_t>((index >> 7) & 0x7F));
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------
+// Standard MIDI File reading, only what the writer produces
+
+struct FileReader {
+    const std::vector<uint8_t>& file;
+    uint32_t pos;
+    bool ok;
+
+    FileReader(const std::vector<uint8_t>& f)
+        : file(f), pos(0), ok(true) {}
+
+    uint8_t byte()
+    {
+        if (pos >= file.size())
+        {
+            ok = false;
+            return 0;
+        }
+        return file[pos++];
+    }
+
+    uint32_t bigEndian(const uint32_t size)
+    {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < size; ++i)
+            value = value << 8 | byte();
+        return value;
+    }
+
+    uint32_t variableLength()
+    {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            const uint8_t b = byte();
+            value = value << 7 | (b & 0x7F);
+            if ((b & 0x80) == 0)
+                break;
+        }
+        return value;
+    }
+
+    bool expect(const char* const chunk)
+    {
+        for (uint32_t i = 0; i < 4; ++i)
+            if (byte() != static_cast<uint8_t>(chunk[i]))
+                ok = false;
+        return ok;
+    }
+};
+
+static bool readFile(const char* const path, std::vector<uint8_t>& data)
+{
+    std::FILE* const file = std::fopen(path, "rb");
+    DISTRHO_SAFE_ASSERT_RETURN(file != nullptr, false);
+
+    uint8_t buffer[65536];
+    for (std::size_t r; (r = std::fread(buffer, 1, sizeof(buffer), file)) != 0;)
+        data.insert(data.end(), buffer, buffer + r);
+
+    std::fclose(file);
+    return true;
+}
+
+// Returns the number of events that match @a expected, in order, ticks count from @a startTime
+static uint32_t checkFile(const std::vector<uint8_t>& file, const std::vector<ExpectedEvent>& expected,
+                          const uint64_t startTime)
+{
+    FileReader reader(file);
+
+    reader.expect("MThd");
+    DISTRHO_SAFE_ASSERT_RETURN(reader.bigEndian(4) == 6, 0);
+    DISTRHO_SAFE_ASSERT_RETURN(reader.bigEndian(2) == 1, 0);
+    DISTRHO_SAFE_ASSERT_RETURN(reader.bigEndian(2) == 2, 0);
+    reader.bigEndian(2);
+
+    // skip the conductor track
+    reader.expect("MTrk");
+    reader.pos += reader.bigEndian(4);
+
+    reader.expect("MTrk");
+    const uint32_t trackEnd = reader.pos + 4 + reader.bigEndian(4);
+    DISTRHO_SAFE_ASSERT_RETURN(reader.ok && trackEnd == file.size(), 0);
+
+    uint64_t time = startTime;
+    uint32_t matched = 0;
+    std::vector<uint8_t> data;
+
+    while (reader.ok && reader.pos < trackEnd)
+    {
+        time += reader.variableLength();
+
+        const uint8_t status = reader.byte();
+        data.clear();
+
+        if (status == 0xFF)
+        {
+            const uint8_t type = reader.byte();
+            reader.pos += reader.variableLength();
+
+            if (type == 0x2F)
+                break;
+            continue;
+        }
+
+        if (status == 0xF0)
+        {
+            data.push_back(status);
+            for (uint32_t size = reader.variableLength(); size != 0; --size)
+                data.push_back(reader.byte());
+        }
+        else if (status == 0xF7)
+        {
+            for (uint32_t size = reader.variableLength(); size != 0; --size)
+                data.push_back(reader.byte());
+        }
+        else
+        {
+            data.push_back(status);
+            data.push_back(reader.byte());
+            if ((status & 0xF0) != 0xC0 && (status & 0xF0) != 0xD0)
+                data.push_back(reader.byte());
+        }
+
+        if (matched >= expected.size() || expected[matched].time != time || expected[matched].data != data)
+        {
+            d_stderr2("event %u differs in the file", matched);
+            return matched;
+        }
+
+        ++matched;
+    }
+
+    DISTRHO_SAFE_ASSERT(reader.ok && reader.pos == trackEnd);
+    return matched;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+static bool testCapture()
+{
+    char directory[] = "/tmp/midicapturetest-XXXXXX";
+    DISTRHO_SAFE_ASSERT_RETURN(mkdtemp(directory) != nullptr, false);
+
+    MidiCaptureStatus status;
+    MidiCaptureWriter writer(status);
+    writer.setDirectory(directory);
+    writer.startThread();
+
+    std::vector<ExpectedEvent> expected;
+    expected.reserve(kEventCount);
+
+    std::vector<uint8_t> oversized(MidiCaptureWriter::kMaxEventSize + 1, 0x01);
+    oversized.front() = 0xF0;
+    oversized.back() = 0xF7;
+
+    static const uint64_t kStartTime = 1000;
+
+    uint64_t time = kStartTime;
+    uint32_t oversizedCount = 0, fullRing = 0;
+    bool ok = true;
+
+    while (! writer.start(time, 48000.0))
+        d_msleep(1);
+
+    Timer timer;
+
+    for (uint32_t i = 0; i < kEventCount; ++i)
+    {
+        ExpectedEvent event;
+        event.time = time += static_cast<uint32_t>(std::rand()) % 16;
+        makeEvent(i, event.data);
+
+        MidiEvent midiEvent;
+        midiEvent.frame = 0;
+        midiEvent.size = static_cast<uint32_t>(event.data.size());
+        midiEvent.dataExt = nullptr;
+
+        if (midiEvent.size > MidiEvent::kDataSize)
+            midiEvent.dataExt = event.data.data();
+        else
+            std::memcpy(midiEvent.data, event.data.data(), midiEvent.size);
+
+        // a full ring is the audio thread's problem, here we wait for the writer instead
+        while (! writer.write(event.time, midiEvent))
+        {
+            ++fullRing;
+            d_msleep(1);
+        }
+
+        expected.push_back(event);
+
+        if (i % kOversizedEvery == 0)
+        {
+            midiEvent.size = static_cast<uint32_t>(oversized.size());
+            midiEvent.dataExt = oversized.data();
+
+            if (writer.write(event.time, midiEvent))
+            {
+                d_stderr2("oversized SysEx was accepted");
+                ok = false;
+            }
+            ++oversizedCount;
+        }
+    }
+
+    while (! writer.stop(time))
+    {
+        ++fullRing;
+        d_msleep(1);
+    }
+
+    while (status.eventsWritten.load() != kEventCount || status.recording.load())
+        d_msleep(1);
+
+    const double elapsed = timer.elapsed();
+    writer.stopThread(-1);
+
+    d_stdout("MidiCapture: %u events in %.3f s, %.2f M events/s, waited for the writer %u times",
+             kEventCount, elapsed, kEventCount / elapsed / 1e6, fullRing);
+
+    if (status.files.load() != 1 || status.errors.load() != 0)
+    {
+        d_stderr2("expected 1 file and no errors, got %u files and %u errors", status.files.load(), status.errors.load());
+        ok = false;
+    }
+
+    // every push retried on a full ring is counted as a drop as well
+    if (status.eventsDropped.load() != oversizedCount + fullRing)
+    {
+        d_stderr2("expected %u dropped events, got %llu", oversizedCount + fullRing,
+                  static_cast<unsigned long long>(status.eventsDropped.load()));
+        ok = false;
+    }
+
+    // find, check and remove the capture file
+    uint32_t files = 0;
+
+    if (DIR* const dir = opendir(directory))
+    {
+        while (const dirent* const entry = readdir(dir))
+        {
+            if (entry->d_name[0] == '.')
+                continue;
+
+            const String path(String(directory) + "/" + entry->d_name);
+            std::vector<uint8_t> file;
+            ++files;
+
+            if (readFile(path, file))
+            {
+                const uint32_t matched = checkFile(file, expected, kStartTime);
+
+                d_stdout("MidiCapture: %u of %u events read back from a %u byte file", matched, kEventCount,
+                         static_cast<uint32_t>(file.size()));
+
+                if (matched != kEventCount)
+                    ok = false;
+            }
+
+            std::remove(path);
+        }
+
+        closedir(dir);
+    }
+
+    rmdir(directory);
+
+    if (files != 1)
+    {
+        d_stderr2("expected one capture file, found %u", files);
+        ok = false;
+    }
+
+    return ok;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+int main()
+{
+    USE_NAMESPACE_DISTRHO;
+
+    std::srand(9);
+
+    if (! testCapture())
+    {
+        d_stderr2("MidiCaptureTest: failed");
+        return 1;
+    }
+
+    d_stdout("MidiCaptureTest: ok");
+    return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef TRUE_PEAK_REFERENCE_HPP_INCLUDED
+#define TRUE_PEAK_REFERENCE_HPP_INCLUDED
+
+#include "TruePeakMeter.hpp"
+
+#include <cmath>
+#include <cstring>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+// Straight transcription of the ITU-R BS.1770-4 annex 2 interpolator, in double precision.
+// Written from the annex rather than shared with TruePeakMeter, so a typo in either shows up.
+class TruePeakReference
+{
+public:
+    static const uint32_t kOversampling = 4;
+    static const uint32_t kTapsPerPhase = 12;
+
+    TruePeakReference()
+        : fHistory() {}
+
+    double process(const float* const input, const uint32_t frames)
+    {
+        static const double kPhases[kOversampling][kTapsPerPhase] = {
+            {  0.0017089843750,  0.0109863281250, -0.0196533203125,  0.0332031250000,
+              -0.0594482421875,  0.1373291015625,  0.9721679687500, -0.1022949218750,
+               0.0476074218750, -0.0266113281250,  0.0148925781250, -0.0083007812500 },
+            { -0.0291748046875,  0.0292968750000, -0.0517578125000,  0.0891113281250,
+              -0.1665039062500,  0.4650878906250,  0.7797851562500, -0.2003173828125,
+               0.1015625000000, -0.0582275390625,  0.0330810546875, -0.0189208984375 },
+            { -0.0189208984375,  0.0330810546875, -0.0582275390625,  0.1015625000000,
+              -0.2003173828125,  0.7797851562500,  0.4650878906250, -0.1665039062500,
+               0.0891113281250, -0.0517578125000,  0.0292968750000, -0.0291748046875 },
+            { -0.0083007812500,  0.0148925781250, -0.0266113281250,  0.0476074218750,
+              -0.1022949218750,  0.9721679687500,  0.1373291015625, -0.0594482421875,
+               0.0332031250000, -0.0196533203125,  0.0109863281250,  0.0017089843750 }
+        };
+
+        double peak = 0.0;
+
+        for (uint32_t i = 0; i < frames; ++i)
+        {
+            // fHistory[0] is the newest sample
+            std::memmove(fHistory + 1, fHistory, sizeof(double)*(kTapsPerPhase - 1));
+            fHistory[0] = input[i];
+
+            for (uint32_t p = 0; p < kOversampling; ++p)
+            {
+                double acc = 0.0;
+
+                for (uint32_t k = 0; k < kTapsPerPhase; ++k)
+                    acc += kPhases[p][k] * fHistory[k];
+
+                peak = std::fmax(peak, std::fabs(acc));
+            }
+        }
+
+        return peak;
+    }
+
+private:
+    double fHistory[kTapsPerPhase];
+};
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // TRUE_PEAK_REFERENCE_HPP_INCLUDED
@@ -0,0 +1,146 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Checks TruePeakMeter against the ITU-R BS.1770 annex 2 interpolator, and against the synthetic
+// true-peak sine vectors used for compliance (EBU Tech 3341 style, +0.2/-0.4 dB at 48 kHz).
+
+#include "TruePeakReference.hpp"
+
+#include <cstdlib>
+#include <vector>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+static const double kSampleRate = 48000.0;
+
+static uint32_t gFailures = 0;
+
+static double toDecibels(const double value)
+{
+    return 20.0 * std::log10(value);
+}
+
+// One second of sine with @a peak amplitude, starting at @a phaseDegrees
+static std::vector<float> makeSine(const double frequency, const double phaseDegrees, const double peakDecibels)
+{
+    const double amplitude = std::pow(10.0, peakDecibels / 20.0);
+    std::vector<float> buffer(static_cast<uint32_t>(kSampleRate));
+
+    for (uint32_t i = 0; i < buffer.size(); ++i)
+        buffer[i] = static_cast<float>(amplitude * std::sin(2.0 * M_PI * frequency * i / kSampleRate
+                                                            + phaseDegrees * M_PI / 180.0));
+
+    return buffer;
+}
+
+static void testSine(const char* const name, const double frequency, const double phaseDegrees,
+                     const double peakDecibels)
+{
+    const std::vector<float> buffer(makeSine(frequency, phaseDegrees, peakDecibels));
+
+    float samplePeak = 0.0f;
+    for (uint32_t i = 0; i < buffer.size(); ++i)
+        samplePeak = std::fmax(samplePeak, std::fabs(buffer[i]));
+
+    // the sine starts with a step, let the filter ring that out before measuring
+    static const uint32_t kSettle = TruePeakMeter::kTapsPerPhase;
+
+    TruePeakMeter meter;
+    meter.process(buffer.data(), kSettle);
+
+    const double truePeak = toDecibels(meter.process(buffer.data() + kSettle,
+                                                     static_cast<uint32_t>(buffer.size()) - kSettle));
+    const double error = truePeak - peakDecibels;
+    const bool ok = error <= 0.2 && error >= -0.4;
+
+    d_stdout("  %-28s sample %6.2f dBFS, true %6.3f dBTP, expected %5.1f +0.2/-0.4%s", name,
+             toDecibels(samplePeak), truePeak, peakDecibels, ok ? "" : "  FAILED");
+
+    if (! ok)
+        ++gFailures;
+}
+
+static void testVectors()
+{
+    d_stdout("True-peak sine vectors at %.0f Hz:", kSampleRate);
+
+    // the sample grid moves against the crest, from exact hits to 3 dB below it
+    testSine("fs/4, 0 deg, -6 dB",    kSampleRate / 4.0,  0.0, -6.0);
+    testSine("fs/4, 45 deg, -6 dB",   kSampleRate / 4.0, 45.0, -6.0);
+    testSine("fs/6, 60 deg, -6 dB",   kSampleRate / 6.0, 60.0, -6.0);
+    testSine("fs/8, 67.5 deg, -6 dB", kSampleRate / 8.0, 67.5, -6.0);
+
+    // above full scale: samples at 0 dBFS hide a +3 dBTP signal
+    testSine("fs/4, 45 deg, +3 dB",   kSampleRate / 4.0, 45.0,  3.0);
+
+    // the interpolator has to stay flat lower in the passband too
+    testSine("997 Hz, -6 dB",         997.0,              0.0, -6.0);
+}
+
+// The vectorized meter must give the annex filter's answer for any block size and history state
+static void testAgainstReference()
+{
+    d_stdout("TruePeakMeter against the annex 2 reference:");
+
+    TruePeakMeter meter;
+    TruePeakReference reference;
+    std::vector<float> buffer(4096);
+    double worst = 0.0;
+
+    for (uint32_t t = 0; t < 2000; ++t)
+    {
+        const uint32_t frames = static_cast<uint32_t>(std::rand()) % 4096;
+
+        for (uint32_t i = 0; i < frames; ++i)
+            buffer[i] = (static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX) * 2.0f - 1.0f) * 0.9f;
+
+        const double value    = meter.process(buffer.data(), frames);
+        const double expected = reference.process(buffer.data(), frames);
+
+        worst = std::fmax(worst, std::fabs(value - expected));
+    }
+
+    const bool ok = worst <= 1e-5;
+    d_stdout("  random blocks, largest difference %g%s", worst, ok ? "" : "  FAILED");
+
+    if (! ok)
+        ++gFailures;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+int main()
+{
+    USE_NAMESPACE_DISTRHO;
+
+    std::srand(4);
+
+    testVectors();
+    testAgainstReference();
+
+    if (gFailures != 0)
+    {
+        d_stderr2("TruePeakTest: %u failures", gFailures);
+        return 1;
+    }
+
+    d_stdout("TruePeakTest: ok");
+    return 0;
+}
@@ -0,0 +1,303 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Checks the base64 codec against the original character-at-a-time implementation,
+// then times both on a few MiB of data.
+
+#include "extra/Base64.hpp"
+
+#include "Timer.hpp"
+
+#include <cctype>
+#include <string>
+
+// -----------------------------------------------------------------------
+// The previous implementation, kept as reference
+
+namespace Reference {
+
+static const char* const kBase64Chars =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+    "abcdefghijklmnopqrstuvwxyz"
+    "0123456789+/";
+
+static uint findBase64CharIndex(const char c)
+{
+    for (uint i=0; i<64; ++i)
+    {
+        if (kBase64Chars[i] == c)
+            return i;
+    }
+
+    return 0;
+}
+
+static bool isBase64Char(const char c)
+{
+    return (std::isalnum(c) || (c == '+') || (c == '/'));
+}
+
+static std::vector<uint8_t> decode(const char* const base64string)
+{
+    uint i=0, j=0;
+    uint charArray3[3], charArray4[4];
+
+    std::vector<uint8_t> ret;
+
+    for (std::size_t l=0, len=std::strlen(base64string); l<len; ++l)
+    {
+        const char c = base64string[l];
+
+        if (c == '\0' || c == '=')
+            break;
+        if (c == ' ' || c == '\n')
+            continue;
+        if (! isBase64Char(c))
+            continue;
+
+        charArray4[i++] = static_cast<uint>(c);
+
+        if (i == 4)
+        {
+            for (i=0; i<4; ++i)
+                charArray4[i] = findBase64CharIndex(static_cast<char>(charArray4[i]));
+
+            charArray3[0] =  (charArray4[0] << 2)        + ((charArray4[1] & 0x30) >> 4);
+            charArray3[1] = ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
+            charArray3[2] = ((charArray4[2] & 0x3) << 6) +   charArray4[3];
+
+            for (i=0; i<3; ++i)
+                ret.push_back(static_cast<uint8_t>(charArray3[i]));
+
+            i = 0;
+        }
+    }
+
+    if (i != 0)
+    {
+        for (j=0; j<i && j<4; ++j)
+            charArray4[j] = findBase64CharIndex(static_cast<char>(charArray4[j]));
+
+        for (j=i; j<4; ++j)
+            charArray4[j] = 0;
+
+        charArray3[0] =  (charArray4[0] << 2)        + ((charArray4[1] & 0x30) >> 4);
+        charArray3[1] = ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
+        charArray3[2] = ((charArray4[2] & 0x3) << 6) +   charArray4[3];
+
+        for (j=0; i>0 && j<i-1; j++)
+            ret.push_back(static_cast<uint8_t>(charArray3[j]));
+    }
+
+    return ret;
+}
+
+static std::string encode(const void* const data, const std::size_t dataSize)
+{
+    const uchar* bytesToEncode((const uchar*)data);
+
+    uint i=0, j=0;
+    uint charArray3[3], charArray4[4];
+
+    std::string ret;
+
+    for (std::size_t s=0; s<dataSize; ++s)
+    {
+        charArray3[i++] = *(bytesToEncode++);
+
+        if (i == 3)
+        {
+            charArray4[0] =  (charArray3[0] & 0xfc) >> 2;
+            charArray4[1] = ((charArray3[0] & 0x03) << 4) + ((charArray3[1] & 0xf0) >> 4);
+            charArray4[2] = ((charArray3[1] & 0x0f) << 2) + ((charArray3[2] & 0xc0) >> 6);
+            charArray4[3] =   charArray3[2] & 0x3f;
+
+            for (i=0; i<4; ++i)
+                ret += kBase64Chars[charArray4[i]];
+
+            i = 0;
+        }
+    }
+
+    if (i != 0)
+    {
+        for (j=i; j<3; ++j)
+            charArray3[j] = '\0';
+
+        charArray4[0] =  (charArray3[0] & 0xfc) >> 2;
+        charArray4[1] = ((charArray3[0] & 0x03) << 4) + ((charArray3[1] & 0xf0) >> 4);
+        charArray4[2] = ((charArray3[1] & 0x0f) << 2) + ((charArray3[2] & 0xc0) >> 6);
+        charArray4[3] =   charArray3[2] & 0x3f;
+
+        for (j=0; j<4 && i<3 && j<i+1; ++j)
+            ret += kBase64Chars[charArray4[j]];
+
+        for (; i++ < 3;)
+            ret += '=';
+    }
+
+    return ret;
+}
+
+} // namespace Reference
+
+// -----------------------------------------------------------------------
+
+static std::vector<uint8_t> randomBytes(const std::size_t size)
+{
+    std::vector<uint8_t> data(size);
+
+    for (std::size_t i=0; i<size; ++i)
+        data[i] = static_cast<uint8_t>(std::rand() >> 7);
+
+    return data;
+}
+
+int main()
+{
+    static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    uint failures = 0;
+    std::srand(5);
+
+    // round trip of every size up to a few blocks, encoded output must match the reference
+    for (std::size_t size=0; size<3000; ++size)
+    {
+        const std::vector<uint8_t> data(randomBytes(size));
+        const String encoded(d_getBase64StringFromChunk(data.data(), size));
+
+        if (std::strcmp(encoded.buffer(), Reference::encode(data.data(), size).c_str()) != 0)
+        {
+            d_stderr2("encode mismatch at size %u", static_cast<uint>(size));
+            ++failures;
+        }
+
+        if (std::strcmp(String::asBase64(data.data(), size).buffer(), encoded.buffer()) != 0)
+        {
+            d_stderr2("String::asBase64 mismatch at size %u", static_cast<uint>(size));
+            ++failures;
+        }
+
+        if (d_getChunkFromBase64String(encoded.buffer()) != data)
+        {
+            d_stderr2("decode mismatch at size %u", static_cast<uint>(size));
+            ++failures;
+        }
+    }
+
+    // noisy input: whitespace, invalid characters, stray '=' and missing padding decode like the reference.
+    // The new decoder reports invalid characters through d_safe_assert, silence stderr for this part.
+    std::fflush(stderr);
+    FILE* const savedStderr = stderr;
+    stderr = std::fopen("/dev/null", "w");
+
+    for (uint t=0; t<20000; ++t)
+    {
+        std::string str;
+
+        for (uint i=0, size=static_cast<uint>(std::rand() % 200); i<size; ++i)
+        {
+            const int r = std::rand() % 100;
+
+            /**/ if (r < 90) str += kAlphabet[std::rand() % 64];
+            else if (r < 94) str += ' ';
+            else if (r < 97) str += '\n';
+            else if (r < 99) str += static_cast<char>(std::rand() % 255 + 1);
+            else             str += '=';
+        }
+
+        if (d_getChunkFromBase64String(str.c_str()) != Reference::decode(str.c_str()))
+        {
+            std::fprintf(savedStderr, "noisy decode mismatch for '%s'\n", str.c_str());
+            ++failures;
+        }
+    }
+
+    std::fclose(stderr);
+    stderr = savedStderr;
+
+    // large buffers, String::asBase64 used to build its result on the stack
+    {
+        const std::size_t size = 16*1024*1024;
+        const std::vector<uint8_t> data(randomBytes(size));
+        const String encoded(String::asBase64(data.data(), size));
+
+        if (encoded.length() != (size + 2) / 3 * 4 || d_getChunkFromBase64String(encoded.buffer()) != data)
+        {
+            d_stderr2("16 MiB round trip failed");
+            ++failures;
+        }
+    }
+
+    // benchmark
+    {
+        const std::size_t size = 4*1024*1024;
+        const std::vector<uint8_t> data(randomBytes(size));
+
+        Timer timer;
+        const std::string refEncoded(Reference::encode(data.data(), size));
+        const double refEncodeTime = timer.elapsed();
+
+        timer.reset();
+        const String encoded(d_getBase64StringFromChunk(data.data(), size));
+        const double encodeTime = timer.elapsed();
+
+        timer.reset();
+        const std::vector<uint8_t> refDecoded(Reference::decode(encoded.buffer()));
+        const double refDecodeTime = timer.elapsed();
+
+        timer.reset();
+        const std::vector<uint8_t> decoded(d_getChunkFromBase64String(encoded.buffer()));
+        const double decodeTime = timer.elapsed();
+
+        // line breaks every 76 characters, as MIME writes it
+        std::string wrapped;
+        for (std::size_t i=0; i<encoded.length(); i+=76)
+        {
+            wrapped.append(encoded.buffer() + i, std::min<std::size_t>(76, encoded.length() - i));
+            wrapped += '\n';
+        }
+
+        timer.reset();
+        const std::vector<uint8_t> refWrapped(Reference::decode(wrapped.c_str()));
+        const double refWrappedTime = timer.elapsed();
+
+        timer.reset();
+        const std::vector<uint8_t> decodedWrapped(d_getChunkFromBase64String(wrapped.c_str()));
+        const double wrappedTime = timer.elapsed();
+
+        if (refEncoded != encoded.buffer() || refDecoded != data || decoded != data
+            || refWrapped != data || decodedWrapped != data)
+        {
+            d_stderr2("4 MiB round trip failed");
+            ++failures;
+        }
+
+        d_stdout("4 MiB, reference / current:");
+        d_stdout("  encode         %8.2f ms %8.2f ms", refEncodeTime*1000.0, encodeTime*1000.0);
+        d_stdout("  decode         %8.2f ms %8.2f ms", refDecodeTime*1000.0, decodeTime*1000.0);
+        d_stdout("  decode wrapped %8.2f ms %8.2f ms", refWrappedTime*1000.0, wrappedTime*1000.0);
+    }
+
+    if (failures != 0)
+    {
+        d_stderr2("Base64: %u failures", failures);
+        return 1;
+    }
+
+    d_stdout("Base64: ok");
+    return 0;
+}
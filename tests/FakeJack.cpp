@@ -0,0 +1,225 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "FakeJack.hpp"
+
+#include "jack/jack.h"
+#include "jack/midiport.h"
+#include "jack/transport.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// -----------------------------------------------------------------------
+
+struct _jack_port {
+    std::string name;
+    bool isMidi;
+    bool isOutput;
+    float audio[FakeJack::kBufferSize];
+    std::vector<FakeJackMidiEvent> midi;
+};
+
+static std::vector<jack_port_t*> gPorts;
+static JackProcessCallback gProcessCallback = nullptr;
+static void* gProcessArg = nullptr;
+static int gClient;
+
+static jack_port_t* findPort(const bool isMidi, const bool isOutput, uint32_t index)
+{
+    for (size_t i=0; i < gPorts.size(); ++i)
+    {
+        if (gPorts[i]->isMidi == isMidi && gPorts[i]->isOutput == isOutput && index-- == 0)
+            return gPorts[i];
+    }
+
+    std::abort();
+    return nullptr;
+}
+
+namespace FakeJack {
+
+float* audioInput(const uint32_t index)
+{
+    return findPort(false, false, index)->audio;
+}
+
+const float* audioOutput(const uint32_t index)
+{
+    return findPort(false, true, index)->audio;
+}
+
+std::vector<FakeJackMidiEvent>& midiInput()
+{
+    return findPort(true, false, 0)->midi;
+}
+
+const std::vector<FakeJackMidiEvent>& midiOutput()
+{
+    return findPort(true, true, 0)->midi;
+}
+
+void process()
+{
+    gProcessCallback(kBufferSize, gProcessArg);
+}
+
+}
+
+// -----------------------------------------------------------------------
+
+extern "C" {
+
+jack_client_t* jack_client_open(const char*, jack_options_t, jack_status_t*, ...)
+{
+    return (jack_client_t*)&gClient;
+}
+
+int jack_client_close(jack_client_t*)
+{
+    return 0;
+}
+
+char* jack_get_client_name(jack_client_t*)
+{
+    return nullptr;
+}
+
+int jack_activate(jack_client_t*)
+{
+    std::exit(fakeJackMain());
+    return 0;
+}
+
+int jack_deactivate(jack_client_t*)
+{
+    return 0;
+}
+
+jack_port_t* jack_port_register(jack_client_t*, const char* name, const char* type, unsigned long flags, unsigned long)
+{
+    jack_port_t* const port = new jack_port_t;
+    port->name     = name;
+    port->isMidi   = std::strcmp(type, JACK_DEFAULT_MIDI_TYPE) == 0;
+    port->isOutput = (flags & JackPortIsOutput) != 0;
+    std::memset(port->audio, 0, sizeof(port->audio));
+
+    gPorts.push_back(port);
+    return port;
+}
+
+int jack_port_unregister(jack_client_t*, jack_port_t*)
+{
+    return 0;
+}
+
+void* jack_port_get_buffer(jack_port_t* port, jack_nframes_t)
+{
+    return port->isMidi ? (void*)port : (void*)port->audio;
+}
+
+int jack_set_process_callback(jack_client_t*, JackProcessCallback callback, void* arg)
+{
+    gProcessCallback = callback;
+    gProcessArg = arg;
+    return 0;
+}
+
+int jack_set_buffer_size_callback(jack_client_t*, JackBufferSizeCallback, void*)
+{
+    return 0;
+}
+
+int jack_set_sample_rate_callback(jack_client_t*, JackSampleRateCallback, void*)
+{
+    return 0;
+}
+
+void jack_on_shutdown(jack_client_t*, JackShutdownCallback, void*)
+{
+}
+
+jack_nframes_t jack_get_buffer_size(jack_client_t*)
+{
+    return FakeJack::kBufferSize;
+}
+
+jack_nframes_t jack_get_sample_rate(jack_client_t*)
+{
+    return FakeJack::kSampleRate;
+}
+
+uint32_t jack_midi_get_event_count(void* buffer)
+{
+    return static_cast<uint32_t>(((jack_port_t*)buffer)->midi.size());
+}
+
+int jack_midi_event_get(jack_midi_event_t* event, void* buffer, uint32_t index)
+{
+    jack_port_t* const port = (jack_port_t*)buffer;
+
+    if (index >= port->midi.size())
+        return -1;
+
+    FakeJackMidiEvent& midiEvent(port->midi[index]);
+    event->time   = midiEvent.frame;
+    event->size   = midiEvent.size;
+    event->buffer = midiEvent.data;
+    return 0;
+}
+
+void jack_midi_clear_buffer(void* buffer)
+{
+    ((jack_port_t*)buffer)->midi.clear();
+}
+
+jack_midi_data_t* jack_midi_event_reserve(void* buffer, jack_nframes_t frame, size_t size)
+{
+    jack_port_t* const port = (jack_port_t*)buffer;
+
+    if (size > 3 || frame >= FakeJack::kBufferSize)
+        return nullptr;
+
+    // the caller fills in the data before writing more events
+    const FakeJackMidiEvent midiEvent = { frame, static_cast<uint8_t>(size), { 0, 0, 0 } };
+    port->midi.push_back(midiEvent);
+    return port->midi.back().data;
+}
+
+int jack_midi_event_write(void* buffer, jack_nframes_t frame, const jack_midi_data_t* data, size_t size)
+{
+    jack_port_t* const port = (jack_port_t*)buffer;
+
+    if (size > 3 || frame >= FakeJack::kBufferSize)
+        return -1;
+
+    FakeJackMidiEvent midiEvent = { frame, static_cast<uint8_t>(size), { 0, 0, 0 } };
+    std::memcpy(midiEvent.data, data, size);
+    port->midi.push_back(midiEvent);
+    return 0;
+}
+
+jack_transport_state_t jack_transport_query(const jack_client_t*, jack_position_t* pos)
+{
+    std::memset(pos, 0, sizeof(jack_position_t));
+    pos->frame_rate = FakeJack::kSampleRate;
+    return JackTransportStopped;
+}
+
+}
+
+// -----------------------------------------------------------------------
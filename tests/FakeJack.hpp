@@ -0,0 +1,60 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef DISTRHO_TESTS_FAKE_JACK_HPP_INCLUDED
+#define DISTRHO_TESTS_FAKE_JACK_HPP_INCLUDED
+
+#include <stdint.h>
+#include <vector>
+
+// -----------------------------------------------------------------------
+// A libjack replacement that runs the process callback on demand, so JACK standalones can be tested without
+// a server. Link it in place of libjack, main() of the standalone then calls fakeJackMain() from jack_activate().
+
+struct FakeJackMidiEvent {
+    uint32_t frame;
+    uint8_t  size;
+    uint8_t  data[3];
+};
+
+namespace FakeJack {
+
+static const uint32_t kBufferSize = 256;
+static const uint32_t kSampleRate = 48000;
+
+// Audio of input port @a index for the next period.
+float* audioInput(uint32_t index);
+
+// Audio written to output port @a index in the last period.
+const float* audioOutput(uint32_t index);
+
+// MIDI input of the next period, in frame order.
+std::vector<FakeJackMidiEvent>& midiInput();
+
+// MIDI written in the last period, in the order it was written.
+const std::vector<FakeJackMidiEvent>& midiOutput();
+
+// Run the process callback for one period.
+void process();
+
+}
+
+// Implemented by the test, the process exits with its return value.
+int fakeJackMain();
+
+// -----------------------------------------------------------------------
+
+#endif // DISTRHO_TESTS_FAKE_JACK_HPP_INCLUDED
@@ -0,0 +1,329 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Feeds 10000 MIDI events per period through the JACK standalone wrapper. Dense periods overflow the staging
+// area and get split into several run() calls at event frames, check nothing gets lost, reordered or moved.
+
+#include "DistrhoPlugin.hpp"
+
+#include "FakeJack.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+// -----------------------------------------------------------------------
+
+static const uint32_t kEventsPerPeriod = 10000;
+
+#if DISTRHO_PLUGIN_MIDI_THRU
+static const char* const kTestName = "JackMidiThruStress";
+#else
+static const char* const kTestName = "JackMidiStress";
+#endif
+
+// Output of the plugin echo, to tell it apart from thru
+static const uint8_t kEchoStatus = 0xA0;
+
+struct DeliveredEvent {
+    uint32_t frame; // within the period
+    uint32_t index; // in the period input
+};
+
+// What the plugin saw during one period
+struct Delivery {
+    std::vector<DeliveredEvent> events;
+    uint32_t frames;
+    uint32_t runs;
+    uint32_t errors;
+
+    void clear()
+    {
+        events.clear();
+        frames = runs = errors = 0;
+    }
+};
+
+static Delivery gDelivery;
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+class JackMidiStressPlugin : public Plugin
+{
+public:
+    JackMidiStressPlugin()
+        : Plugin(0, 0, 0) {}
+
+protected:
+    const char* getLabel() const override
+    {
+        return "JackMidiStress";
+    }
+
+    const char* getMaker() const override
+    {
+        return "DISTRHO";
+    }
+
+    const char* getLicense() const override
+    {
+        return "ISC";
+    }
+
+    uint32_t getVersion() const override
+    {
+        return d_version(1, 0, 0);
+    }
+
+    int64_t getUniqueId() const override
+    {
+        return d_cconst('d', 'J', 'm', 's');
+    }
+
+    void initParameter(uint32_t, Parameter&) override {}
+
+    float getParameterValue(uint32_t) const override
+    {
+        return 0.0f;
+    }
+
+    void setParameterValue(uint32_t, float) override {}
+
+    // Pass audio through, record input events and echo each of them, alternating between both write APIs.
+    void run(const float** inputs, float** outputs, uint32_t frames,
+             const MidiEvent* midiEvents, uint32_t midiEventCount) override
+    {
+        std::memcpy(outputs[0], inputs[0], sizeof(float)*frames);
+
+        for (uint32_t i=0; i < midiEventCount; ++i)
+        {
+            const MidiEvent& midiEvent(midiEvents[i]);
+
+            if (midiEvent.frame >= frames || (i != 0 && midiEvent.frame < midiEvents[i-1].frame))
+                ++gDelivery.errors;
+
+            const DeliveredEvent delivered = {
+                gDelivery.frames + midiEvent.frame,
+                static_cast<uint32_t>(midiEvent.data[1]) | static_cast<uint32_t>(midiEvent.data[2]) << 7
+            };
+            gDelivery.events.push_back(delivered);
+
+            if (i % 2 == 0)
+            {
+                if (uint8_t* const data = reserveMidiEvent(midiEvent.frame, 3))
+                {
+                    data[0] = kEchoStatus;
+                    data[1] = midiEvent.data[1];
+                    data[2] = midiEvent.data[2];
+                }
+                else
+                {
+                    ++gDelivery.errors;
+                }
+            }
+            else
+            {
+                MidiEvent echo(midiEvent);
+                echo.data[0] = kEchoStatus;
+
+                if (writeMidiEvents(&echo, 1) != 1)
+                    ++gDelivery.errors;
+            }
+        }
+
+        gDelivery.frames += frames;
+        ++gDelivery.runs;
+    }
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(JackMidiStressPlugin)
+};
+
+Plugin* createPlugin()
+{
+    return new JackMidiStressPlugin();
+}
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+enum Pattern {
+    kPatternRandom,
+    kPatternFirstFrame,
+    kPatternFirstFrames,
+    kPatternLastFrame,
+    kPatternCount
+};
+
+static const char* const kPatternNames[kPatternCount] = {
+    "random frames",
+    "all on the first frame",
+    "first 8 frames",
+    "all on the last frame"
+};
+
+static uint32_t patternFrame(const Pattern pattern)
+{
+    switch (pattern)
+    {
+    case kPatternRandom:
+        return static_cast<uint32_t>(std::rand()) % FakeJack::kBufferSize;
+    case kPatternFirstFrame:
+        return 0;
+    case kPatternFirstFrames:
+        return static_cast<uint32_t>(std::rand()) % 8;
+    default:
+        return FakeJack::kBufferSize - 1;
+    }
+}
+
+// Run one period, returns the number of failed checks
+static uint32_t runPeriod(const Pattern pattern, const uint32_t period, uint32_t& late, uint32_t& maxRuns)
+{
+    uint32_t failures = 0;
+
+    // sorted input frames, each event carries its index
+    std::vector<uint32_t> frames(kEventsPerPeriod);
+    for (uint32_t i=0; i < kEventsPerPeriod; ++i)
+        frames[i] = patternFrame(pattern);
+    std::sort(frames.begin(), frames.end());
+
+    std::vector<FakeJackMidiEvent>& input(FakeJack::midiInput());
+    input.clear();
+
+    for (uint32_t i=0; i < kEventsPerPeriod; ++i)
+    {
+        const FakeJackMidiEvent midiEvent = {
+            frames[i], 3, { 0x90, static_cast<uint8_t>(i & 0x7f), static_cast<uint8_t>(i >> 7) }
+        };
+        input.push_back(midiEvent);
+    }
+
+    float* const audioIn = FakeJack::audioInput(0);
+    for (uint32_t i=0; i < FakeJack::kBufferSize; ++i)
+        audioIn[i] = static_cast<float>(period * FakeJack::kBufferSize + i);
+
+    gDelivery.clear();
+    FakeJack::process();
+
+    if (gDelivery.runs > maxRuns)
+        maxRuns = gDelivery.runs;
+
+    // sub-blocks cover the period exactly, audio goes through in place
+    if (gDelivery.frames != FakeJack::kBufferSize || gDelivery.errors != 0)
+        ++failures;
+    if (std::memcmp(FakeJack::audioOutput(0), audioIn, sizeof(float)*FakeJack::kBufferSize) != 0)
+        ++failures;
+
+    // events arrive in order, never early and, unless a whole frame does not fit the staging area, never late.
+    // All of them arrive unless they pile up on the last frame.
+    const std::vector<DeliveredEvent>& delivered(gDelivery.events);
+
+    if (pattern != kPatternLastFrame && delivered.size() != kEventsPerPeriod)
+        ++failures;
+    if (delivered.empty())
+        ++failures;
+
+    for (size_t i=0; i < delivered.size(); ++i)
+    {
+        const DeliveredEvent& event(delivered[i]);
+
+        if (event.index >= kEventsPerPeriod || (i != 0 && event.index <= delivered[i-1].index))
+        {
+            ++failures;
+            break;
+        }
+
+        if (event.frame < frames[event.index] || event.frame >= FakeJack::kBufferSize)
+            ++failures;
+        else if (event.frame != frames[event.index])
+            ++late;
+    }
+
+    if (pattern == kPatternRandom && late != 0)
+        ++failures;
+
+    // MIDI output is in frame order, echoes match the delivered events, thru matches the input
+    const std::vector<FakeJackMidiEvent>& output(FakeJack::midiOutput());
+    size_t echoes = 0, thru = 0;
+
+    for (size_t i=0; i < output.size(); ++i)
+    {
+        const FakeJackMidiEvent& midiEvent(output[i]);
+        const uint32_t index = static_cast<uint32_t>(midiEvent.data[1]) | static_cast<uint32_t>(midiEvent.data[2]) << 7;
+
+        if (i != 0 && midiEvent.frame < output[i-1].frame)
+        {
+            ++failures;
+            break;
+        }
+
+        if (midiEvent.data[0] == kEchoStatus)
+        {
+            if (echoes >= delivered.size() || delivered[echoes].index != index || delivered[echoes].frame != midiEvent.frame)
+                ++failures;
+            ++echoes;
+        }
+        else
+        {
+            if (thru != index || frames[index] != midiEvent.frame)
+                ++failures;
+            ++thru;
+        }
+    }
+
+    if (echoes != delivered.size())
+        ++failures;
+#if DISTRHO_PLUGIN_MIDI_THRU
+    if (thru != kEventsPerPeriod)
+        ++failures;
+#else
+    if (thru != 0)
+        ++failures;
+#endif
+
+    return failures;
+}
+
+int fakeJackMain()
+{
+    uint32_t failures = 0;
+    std::srand(1);
+
+    for (int p=0; p < kPatternCount; ++p)
+    {
+        const Pattern pattern = static_cast<Pattern>(p);
+        uint32_t late = 0, maxRuns = 0, patternFailures = 0;
+
+        for (uint32_t period=0; period < 50; ++period)
+            patternFailures += runPeriod(pattern, period, late, maxRuns);
+
+        d_stdout("%-24s up to %2u runs per period, %6u late events, %u failures",
+                 kPatternNames[p], maxRuns, late, patternFailures);
+
+        failures += patternFailures;
+    }
+
+    if (failures != 0)
+    {
+        d_stderr2("%s: %u failures", kTestName, failures);
+        return 1;
+    }
+
+    d_stdout("%s: ok", kTestName);
+    return 0;
+}
@@ -0,0 +1,44 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef DISTRHO_TESTS_TIMER_HPP_INCLUDED
+#define DISTRHO_TESTS_TIMER_HPP_INCLUDED
+
+#include <chrono>
+
+// Wall clock time since construction or the last reset(), for benchmarks.
+class Timer
+{
+public:
+    Timer()
+        : fStart(std::chrono::steady_clock::now()) {}
+
+    void reset()
+    {
+        fStart = std::chrono::steady_clock::now();
+    }
+
+    // seconds
+    double elapsed() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - fStart).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point fStart;
+};
+
+#endif // DISTRHO_TESTS_TIMER_HPP_INCLUDED